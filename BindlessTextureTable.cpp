@@ -0,0 +1,152 @@
+#include "BindlessTextureTable.h"
+
+#include "Device.h"
+#include "SwapChain.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Vkx
+{
+//! The capacity is limited to the device's maxDescriptorSetUpdateAfterBindSampledImages and
+//! maxPerStageDescriptorUpdateAfterBindSampledImages.
+//!
+//! @param  device      Logical device, created with the features returned by requiredFeatures()
+//! @param  capacity    Number of elements in the array
+//! @param  frames      Number of frames in flight (see SwapChain::framesInFlight())
+//! @param  stages      Shader stages that access the textures (default: all)
+//!
+//! @warning    A std::invalid_argument is thrown if capacity is 0 or frames < 1
+BindlessTextureTable::BindlessTextureTable(std::shared_ptr<Device> device,
+                                           uint32_t                capacity,
+                                           int                     frames,
+                                           vk::ShaderStageFlags    stages /*= vk::ShaderStageFlagBits::eAll*/)
+    : device_(device)
+    , removed_(std::max(frames, 1))
+{
+    if (capacity == 0)
+        throw std::invalid_argument("Vkx::BindlessTextureTable::BindlessTextureTable: capacity must be at least 1");
+    if (frames < 1)
+        throw std::invalid_argument("Vkx::BindlessTextureTable::BindlessTextureTable: frames must be at least 1");
+
+    auto properties = device_->physical()->getProperties2<vk::PhysicalDeviceProperties2,
+                                                          vk::PhysicalDeviceDescriptorIndexingProperties>();
+    vk::PhysicalDeviceDescriptorIndexingProperties const & limits =
+        properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+    capacity_ = std::min({ capacity,
+                           limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                           limits.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+    vk::DescriptorSetLayoutBinding binding(0, vk::DescriptorType::eSampledImage, capacity_, stages);
+    vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound |
+                                              vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                                              vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo(1, &bindingFlags);
+    vk::DescriptorSetLayoutCreateInfo layoutInfo(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool, 1, &binding);
+    layoutInfo.pNext = &flagsInfo;
+    layout_ = device_->createDescriptorSetLayoutUnique(layoutInfo);
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eSampledImage, capacity_);
+    pool_ = device_->createDescriptorPoolUnique(
+        vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, 1, &poolSize));
+
+    vk::DescriptorSetLayout layout = *layout_;
+    set_ = device_->allocateDescriptorSets(vk::DescriptorSetAllocateInfo(*pool_, 1, &layout))[0];
+}
+
+//! These features must be chained into the vk::DeviceCreateInfo (directly, or through vk::PhysicalDeviceVulkan12Features)
+//! of the device that creates the table.
+//!
+//! @return features with only the ones needed by the table enabled
+vk::PhysicalDeviceDescriptorIndexingFeatures BindlessTextureTable::requiredFeatures()
+{
+    vk::PhysicalDeviceDescriptorIndexingFeatures features;
+    features.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+    features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features.descriptorBindingUpdateUnusedWhilePending    = VK_TRUE;
+    features.descriptorBindingPartiallyBound              = VK_TRUE;
+    features.runtimeDescriptorArray                       = VK_TRUE;
+    return features;
+}
+
+//! Removed indices are reused before new ones, so the used part of the array stays compact.
+//!
+//! @param  view    Texture's view, or a null handle to leave the element unwritten until set() is called
+//! @param  layout  Layout of the image when it is accessed (default: vk::ImageLayout::eShaderReadOnlyOptimal)
+//!
+//! @return index of the texture in the array, or INVALID_INDEX if the table is full
+BindlessTextureTable::Index BindlessTextureTable::add(vk::ImageView   view,
+                                                      vk::ImageLayout layout /*= vk::ImageLayout::eShaderReadOnlyOptimal*/)
+{
+    Index index;
+    if (!freeIndices_.empty())
+    {
+        index = freeIndices_.back();
+        freeIndices_.pop_back();
+    }
+    else if (next_ < capacity_)
+    {
+        index = next_++;
+    }
+    else
+    {
+        return INVALID_INDEX;
+    }
+
+    ++size_;
+    if (view)
+        write(index, view, layout);
+    return index;
+}
+
+//! @param  index   Index of the texture
+//! @param  view    New view
+//! @param  layout  Layout of the image when it is accessed (default: vk::ImageLayout::eShaderReadOnlyOptimal)
+//!
+//! @warning    Command buffers that are in flight must not access the element.
+void BindlessTextureTable::set(Index           index,
+                               vk::ImageView   view,
+                               vk::ImageLayout layout /*= vk::ImageLayout::eShaderReadOnlyOptimal*/)
+{
+    write(index, view, layout);
+}
+
+//! The element's descriptor is left as it is, and the index is not reused until the current frame is started again.
+//!
+//! @param  index   Index of the texture
+void BindlessTextureTable::remove(Index index)
+{
+    removed_[currentFrame_].push_back(index);
+    --size_;
+}
+
+//! @param  frame   Index of the frame in [0, frames)
+//!
+//! @warning    The GPU must have finished with the frame's previous command buffers. SwapChain::swap() ensures this by waiting
+//!             for the frame's in-flight fence, so this is normally called after it.
+//! @warning    A std::out_of_range is thrown if the frame is out of range
+void BindlessTextureTable::beginFrame(int frame)
+{
+    std::vector<Index> & removed = removed_.at(frame);
+    freeIndices_.insert(freeIndices_.end(), removed.begin(), removed.end());
+    removed.clear();
+    currentFrame_ = frame;
+}
+
+//! @param  swapChain   Swap chain whose current frame is started. Its frame count must match this table's.
+//!
+//! @warning    This must be called after SwapChain::swap() has returned.
+void BindlessTextureTable::beginFrame(SwapChain const & swapChain)
+{
+    beginFrame(swapChain.frame());
+}
+
+void BindlessTextureTable::write(Index index, vk::ImageView view, vk::ImageLayout layout)
+{
+    vk::DescriptorImageInfo info(nullptr, view, layout);
+    device_->updateDescriptorSets(vk::WriteDescriptorSet(set_, 0, index, 1, vk::DescriptorType::eSampledImage, &info),
+                                  nullptr);
+}
+} // namespace Vkx
@@ -0,0 +1,932 @@
+#include "BlockCompressor.h"
+
+#include "Image.h"
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+using Vkx::BlockFormat;
+using Vkx::CompressionQuality;
+
+// A 4x4 block of RGBA texels, in row-major order
+using Block = uint8_t[16][4];
+
+// Returns the number of channels of a supported source format, or 0 if the format is not supported
+uint32_t sourceChannels(vk::Format format)
+{
+    switch (format)
+    {
+        case vk::Format::eR8Unorm:
+            return 1;
+        case vk::Format::eR8G8Unorm:
+            return 2;
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eR8G8B8A8Srgb:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+size_t blockSize(BlockFormat block)
+{
+    return (block == BlockFormat::eBC1 || block == BlockFormat::eBC4) ? 8 : 16;
+}
+
+// Number of endpoint refinement passes for each quality
+int refinements(CompressionQuality quality)
+{
+    switch (quality)
+    {
+        case CompressionQuality::eFast:
+            return 0;
+        case CompressionQuality::eNormal:
+            return 1;
+        default:
+            return 4;
+    }
+}
+
+int clamp255(int x)
+{
+    return std::min(std::max(x, 0), 255);
+}
+
+// Copies a block of texels, replicating the edge texels where the block extends past the image
+void fetchBlock(uint8_t const * texels,
+                uint32_t        width,
+                uint32_t        height,
+                uint32_t        channels,
+                uint32_t        x0,
+                uint32_t        y0,
+                Block &         block)
+{
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        uint32_t sy = std::min(y0 + y, height - 1);
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+            uint32_t sx        = std::min(x0 + x, width - 1);
+            uint8_t const * in = texels + (size_t(sy) * width + sx) * channels;
+            uint8_t * out      = block[y * 4 + x];
+            out[0] = in[0];
+            out[1] = (channels > 1) ? in[1] : 0;
+            out[2] = (channels > 2) ? in[2] : 0;
+            out[3] = (channels > 3) ? in[3] : 255;
+        }
+    }
+}
+
+// Finds the mean of the included texels and the (unit) direction along which the first N channels vary most, using power
+// iteration on their covariance. The axis is 0 if the texels are all the same.
+template <int N>
+void principalAxis(Block const & block, bool const * excluded, float mean[N], float axis[N])
+{
+    int count = 0;
+    std::fill(mean, mean + N, 0.0f);
+    for (int i = 0; i < 16; ++i)
+    {
+        if (excluded && excluded[i])
+            continue;
+        for (int c = 0; c < N; ++c)
+        {
+            mean[c] += block[i][c];
+        }
+        ++count;
+    }
+    for (int c = 0; c < N; ++c)
+    {
+        mean[c] /= (float)std::max(count, 1);
+    }
+
+    float covariance[N][N] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        if (excluded && excluded[i])
+            continue;
+        float d[N];
+        for (int c = 0; c < N; ++c)
+        {
+            d[c] = block[i][c] - mean[c];
+        }
+        for (int r = 0; r < N; ++r)
+        {
+            for (int c = 0; c < N; ++c)
+            {
+                covariance[r][c] += d[r] * d[c];
+            }
+        }
+    }
+
+    std::fill(axis, axis + N, 1.0f);
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[N] = {};
+        float largest = 0.0f;
+        for (int r = 0; r < N; ++r)
+        {
+            for (int c = 0; c < N; ++c)
+            {
+                next[r] += covariance[r][c] * axis[c];
+            }
+            largest = std::max(largest, std::abs(next[r]));
+        }
+        if (largest < 1.0e-6f)
+        {
+            std::fill(axis, axis + N, 0.0f);
+            return;
+        }
+        for (int c = 0; c < N; ++c)
+        {
+            axis[c] = next[c] / largest;
+        }
+    }
+
+    float length = 0.0f;
+    for (int c = 0; c < N; ++c)
+    {
+        length += axis[c] * axis[c];
+    }
+    length = std::sqrt(length);
+    for (int c = 0; c < N; ++c)
+    {
+        axis[c] /= length;
+    }
+}
+
+// Sets the endpoints to the extremes of the included texels projected onto their principal axis
+template <int N>
+void principalEndpoints(Block const & block, bool const * excluded, float lo[N], float hi[N])
+{
+    float mean[N];
+    float axis[N];
+    principalAxis<N>(block, excluded, mean, axis);
+
+    float tMin = std::numeric_limits<float>::max();
+    float tMax = -std::numeric_limits<float>::max();
+    for (int i = 0; i < 16; ++i)
+    {
+        if (excluded && excluded[i])
+            continue;
+        float t = 0.0f;
+        for (int c = 0; c < N; ++c)
+        {
+            t += (block[i][c] - mean[c]) * axis[c];
+        }
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < N; ++c)
+    {
+        lo[c] = std::min(std::max(mean[c] + axis[c] * tMin, 0.0f), 255.0f);
+        hi[c] = std::min(std::max(mean[c] + axis[c] * tMax, 0.0f), 255.0f);
+    }
+}
+
+// Sets the endpoints to the corners of the included texels' bounding box, inset slightly, choosing the diagonal that
+// follows the correlation of red and blue with green
+void boundingBoxEndpoints(Block const & block, bool const * excluded, float lo[3], float hi[3])
+{
+    float mean[3] = {};
+    int count     = 0;
+    for (int c = 0; c < 3; ++c)
+    {
+        lo[c] = 255.0f;
+        hi[c] = 0.0f;
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        if (excluded && excluded[i])
+            continue;
+        for (int c = 0; c < 3; ++c)
+        {
+            lo[c]    = std::min(lo[c], (float)block[i][c]);
+            hi[c]    = std::max(hi[c], (float)block[i][c]);
+            mean[c] += block[i][c];
+        }
+        ++count;
+    }
+
+    float rg = 0.0f;
+    float bg = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (excluded && excluded[i])
+            continue;
+        float g = block[i][1] - mean[1] / count;
+        rg += (block[i][0] - mean[0] / count) * g;
+        bg += (block[i][2] - mean[2] / count) * g;
+    }
+
+    for (int c = 0; c < 3; ++c)
+    {
+        float inset = (hi[c] - lo[c]) / 16.0f;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+    if (rg < 0.0f)
+        std::swap(lo[0], hi[0]);
+    if (bg < 0.0f)
+        std::swap(lo[2], hi[2]);
+}
+
+// Solves for the two endpoints that best reproduce the included texels with the given interpolation weights (the fraction of
+// the second endpoint). Returns false if the system is degenerate.
+template <int N>
+bool leastSquaresEndpoints(Block const &   block,
+                           bool const *    excluded,
+                           uint8_t const * indices,
+                           float const *   weights,
+                           float           e0[N],
+                           float           e1[N])
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x[N] = {};
+    float y[N] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        if (excluded && excluded[i])
+            continue;
+        float w = weights[indices[i]];
+        a += (1.0f - w) * (1.0f - w);
+        b += w * (1.0f - w);
+        c += w * w;
+        for (int k = 0; k < N; ++k)
+        {
+            x[k] += (1.0f - w) * block[i][k];
+            y[k] += w * block[i][k];
+        }
+    }
+    float determinant = a * c - b * b;
+    if (std::abs(determinant) < 1.0e-6f)
+        return false;
+    for (int k = 0; k < N; ++k)
+    {
+        e0[k] = std::min(std::max((c * x[k] - b * y[k]) / determinant, 0.0f), 255.0f);
+        e1[k] = std::min(std::max((a * y[k] - b * x[k]) / determinant, 0.0f), 255.0f);
+    }
+    return true;
+}
+
+// BC1 -------------------------------------------------------------------------------------------------------------------
+
+uint16_t pack565(float const c[3])
+{
+    int r = std::min(std::max((int)std::lround(c[0] * 31.0f / 255.0f), 0), 31);
+    int g = std::min(std::max((int)std::lround(c[1] * 63.0f / 255.0f), 0), 63);
+    int b = std::min(std::max((int)std::lround(c[2] * 31.0f / 255.0f), 0), 31);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void unpack565(uint16_t c, int rgb[3])
+{
+    int r = (c >> 11) & 31;
+    int g = (c >> 5) & 63;
+    int b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Orders the endpoints for the mode, chooses the nearest palette entry for each texel, and returns the total squared error.
+// Transparent texels use the 3-color mode's transparent entry.
+uint32_t evaluateBC1(Block const & block,
+                     uint16_t &    c0,
+                     uint16_t &    c1,
+                     bool          alwaysFourColors,
+                     bool const *  transparent,
+                     uint8_t       indices[16])
+{
+    bool wantFourColors = !transparent;
+    if (!alwaysFourColors && (wantFourColors ? c0 < c1 : c0 > c1))
+        std::swap(c0, c1);
+    bool fourColors = alwaysFourColors || c0 > c1;
+
+    int palette[4][3];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if (fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    // The fourth entry of the 3-color mode is only for transparent texels
+    int entries    = fourColors ? 4 : 3;
+    uint32_t total = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (transparent && transparent[i])
+        {
+            indices[i] = 3;
+            continue;
+        }
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        for (int k = 0; k < entries; ++k)
+        {
+            int dr = block[i][0] - palette[k][0];
+            int dg = block[i][1] - palette[k][1];
+            int db = block[i][2] - palette[k][2];
+            uint32_t e = (uint32_t)(dr * dr + dg * dg + db * db);
+            if (e < best)
+            {
+                best       = e;
+                indices[i] = (uint8_t)k;
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+// Encodes the colors of a block. If punchThrough is true, texels with alpha below 128 become transparent. BC3 color blocks
+// always use four colors.
+void encodeBC1(Block const & block, CompressionQuality quality, bool punchThrough, bool alwaysFourColors, uint8_t out[8])
+{
+    bool transparent[16] = {};
+    int  nTransparent    = 0;
+    if (punchThrough)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            transparent[i] = block[i][3] < 128;
+            nTransparent  += transparent[i];
+        }
+    }
+    bool const * excluded = (nTransparent > 0) ? transparent : nullptr;
+
+    uint16_t c0 = 0;
+    uint16_t c1 = 0;
+    uint8_t indices[16];
+    if (nTransparent < 16)
+    {
+        float lo[3];
+        float hi[3];
+        if (quality == CompressionQuality::eFast)
+            boundingBoxEndpoints(block, excluded, lo, hi);
+        else
+            principalEndpoints<3>(block, excluded, lo, hi);
+        c0 = pack565(hi);
+        c1 = pack565(lo);
+        uint32_t error = evaluateBC1(block, c0, c1, alwaysFourColors, excluded, indices);
+
+        for (int pass = 0; pass < refinements(quality) && error > 0; ++pass)
+        {
+            static float const FOUR_COLOR_WEIGHTS[4]  = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            static float const THREE_COLOR_WEIGHTS[4] = { 0.0f, 1.0f, 0.5f, 0.0f };
+            bool fourColors = alwaysFourColors || c0 > c1;
+            float e0[3];
+            float e1[3];
+            if (!leastSquaresEndpoints<3>(block,
+                                          excluded,
+                                          indices,
+                                          fourColors ? FOUR_COLOR_WEIGHTS : THREE_COLOR_WEIGHTS,
+                                          e0,
+                                          e1))
+            {
+                break;
+            }
+
+            uint16_t n0 = pack565(e0);
+            uint16_t n1 = pack565(e1);
+            uint8_t refined[16];
+            uint32_t refinedError = evaluateBC1(block, n0, n1, alwaysFourColors, excluded, refined);
+            if (refinedError >= error)
+                break;
+            c0    = n0;
+            c1    = n1;
+            error = refinedError;
+            std::copy(refined, refined + 16, indices);
+        }
+    }
+    else
+    {
+        std::fill(indices, indices + 16, 3);
+    }
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        bits |= uint32_t(indices[i]) << (2 * i);
+    }
+    out[0] = (uint8_t)c0;
+    out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)c1;
+    out[3] = (uint8_t)(c1 >> 8);
+    memcpy(out + 4, &bits, 4);  // Little-endian
+}
+
+// BC4 -------------------------------------------------------------------------------------------------------------------
+
+// Chooses the nearest palette entry for each value and returns the total squared error
+uint32_t evaluateBC4(uint8_t const values[16], int e0, int e1, uint8_t indices[16])
+{
+    int palette[8] = { e0, e1 };
+    if (e0 > e1)
+    {
+        for (int i = 2; i < 8; ++i)
+        {
+            palette[i] = ((8 - i) * e0 + (i - 1) * e1 + 3) / 7;
+        }
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+        {
+            palette[i] = ((6 - i) * e0 + (i - 1) * e1 + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint32_t total = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        for (int k = 0; k < 8; ++k)
+        {
+            int d = values[i] - palette[k];
+            if ((uint32_t)(d * d) < best)
+            {
+                best       = (uint32_t)(d * d);
+                indices[i] = (uint8_t)k;
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+// Encodes 16 single-channel values
+void encodeBC4(uint8_t const values[16], CompressionQuality quality, uint8_t out[8])
+{
+    int lo = 255;
+    int hi = 0;
+    int lo6 = 255;  // Extremes excluding 0 and 255, which the 6-value mode has exactly
+    int hi6 = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        lo = std::min(lo, (int)values[i]);
+        hi = std::max(hi, (int)values[i]);
+        if (values[i] != 0 && values[i] != 255)
+        {
+            lo6 = std::min(lo6, (int)values[i]);
+            hi6 = std::max(hi6, (int)values[i]);
+        }
+    }
+
+    int e0 = hi;
+    int e1 = lo;
+    uint8_t indices[16];
+    uint32_t error = evaluateBC4(values, e0, e1, indices);
+
+    auto consider = [&] (int a, int b) {
+                        uint8_t candidate[16];
+                        uint32_t e = evaluateBC4(values, a, b, candidate);
+                        if (e < error)
+                        {
+                            error = e;
+                            e0    = a;
+                            e1    = b;
+                            std::copy(candidate, candidate + 16, indices);
+                        }
+                    };
+
+    if (quality != CompressionQuality::eFast && error > 0)
+    {
+        if (lo6 <= hi6)
+            consider(lo6, hi6);
+        else
+            consider(0, 255);
+    }
+
+    // Insetting the endpoints often reduces the error of the values between them
+    if (quality == CompressionQuality::eBest && error > 0 && hi > lo)
+    {
+        int reach = std::max((hi - lo) / 16, 2);
+        for (int a = hi; a >= std::max(hi - reach, lo + 1); --a)
+        {
+            for (int b = lo; b <= std::min(lo + reach, a - 1); ++b)
+            {
+                consider(a, b);
+            }
+        }
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        bits |= uint64_t(indices[i]) << (3 * i);
+    }
+    out[0] = (uint8_t)e0;
+    out[1] = (uint8_t)e1;
+    for (int i = 0; i < 6; ++i)
+    {
+        out[2 + i] = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+// BC7 -------------------------------------------------------------------------------------------------------------------
+
+int const BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Writes fields into a block, least-significant bit first
+class BitWriter
+{
+public:
+    explicit BitWriter(uint8_t * out)
+        : out_(out)
+    {
+        memset(out_, 0, 16);
+    }
+
+    void write(uint32_t value, int bits)
+    {
+        for (int b = 0; b < bits; ++b, ++position_)
+        {
+            if ((value >> b) & 1)
+                out_[position_ >> 3] |= (uint8_t)(1 << (position_ & 7));
+        }
+    }
+
+private:
+    uint8_t * out_;
+    int position_ = 0;
+};
+
+// An endpoint in mode 6: 7 bits per channel plus a shared p-bit
+struct Bc7Endpoint
+{
+    int q[4];
+    int p;
+};
+
+// Quantizes an endpoint, choosing the p-bit that reproduces it better unless one is given
+Bc7Endpoint quantizeBC7(float const e[4], int forcedP = -1)
+{
+    Bc7Endpoint best  = {};
+    float bestError   = std::numeric_limits<float>::max();
+    for (int p = 0; p < 2; ++p)
+    {
+        if (forcedP >= 0 && p != forcedP)
+            continue;
+        Bc7Endpoint candidate;
+        candidate.p = p;
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            candidate.q[c] = std::min(std::max((int)std::lround((e[c] - p) / 2.0f), 0), 127);
+            float d = (float)(candidate.q[c] * 2 + p) - e[c];
+            error += d * d;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            best      = candidate;
+        }
+    }
+    return best;
+}
+
+// Chooses the nearest palette entry for each texel and returns the total squared error
+uint32_t evaluateBC7(Block const & block, Bc7Endpoint const & a, Bc7Endpoint const & b, uint8_t indices[16])
+{
+    int palette[16][4];
+    for (int c = 0; c < 4; ++c)
+    {
+        int e0 = a.q[c] * 2 + a.p;
+        int e1 = b.q[c] * 2 + b.p;
+        for (int k = 0; k < 16; ++k)
+        {
+            palette[k][c] = ((64 - BC7_WEIGHTS[k]) * e0 + BC7_WEIGHTS[k] * e1 + 32) >> 6;
+        }
+    }
+
+    uint32_t total = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        for (int k = 0; k < 16; ++k)
+        {
+            uint32_t e = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                int d = block[i][c] - palette[k][c];
+                e += (uint32_t)(d * d);
+            }
+            if (e < best)
+            {
+                best       = e;
+                indices[i] = (uint8_t)k;
+            }
+        }
+        total += best;
+    }
+    return total;
+}
+
+// Encodes a block in mode 6, which has one subset of RGBA endpoints and 4-bit indices
+void encodeBC7(Block const & block, CompressionQuality quality, uint8_t out[16])
+{
+    float lo[4];
+    float hi[4];
+    principalEndpoints<4>(block, nullptr, lo, hi);
+
+    Bc7Endpoint a = quantizeBC7(lo);
+    Bc7Endpoint b = quantizeBC7(hi);
+    uint8_t indices[16];
+    uint32_t error = evaluateBC7(block, a, b, indices);
+
+    float weights[16];
+    for (int k = 0; k < 16; ++k)
+    {
+        weights[k] = BC7_WEIGHTS[k] / 64.0f;
+    }
+
+    for (int pass = 0; pass < refinements(quality) && error > 0; ++pass)
+    {
+        float e0[4];
+        float e1[4];
+        if (!leastSquaresEndpoints<4>(block, nullptr, indices, weights, e0, e1))
+            break;
+
+        // The best preset also tries every combination of p-bits
+        Bc7Endpoint bestA = a;
+        Bc7Endpoint bestB = b;
+        uint32_t bestError = error;
+        uint8_t refined[16];
+        int combinations = (quality == CompressionQuality::eBest) ? 4 : 1;
+        for (int i = 0; i < combinations; ++i)
+        {
+            Bc7Endpoint na = (combinations > 1) ? quantizeBC7(e0, i & 1) : quantizeBC7(e0);
+            Bc7Endpoint nb = (combinations > 1) ? quantizeBC7(e1, i >> 1) : quantizeBC7(e1);
+            uint32_t e = evaluateBC7(block, na, nb, refined);
+            if (e < bestError)
+            {
+                bestError = e;
+                bestA     = na;
+                bestB     = nb;
+            }
+        }
+        if (bestError >= error)
+            break;
+        a     = bestA;
+        b     = bestB;
+        error = evaluateBC7(block, a, b, indices);
+    }
+
+    // The most significant bit of the first index is implied to be 0
+    if (indices[0] & 8)
+    {
+        std::swap(a, b);
+        for (auto & index : indices)
+        {
+            index = (uint8_t)(15 - index);
+        }
+    }
+
+    BitWriter writer(out);
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c)
+    {
+        writer.write((uint32_t)a.q[c], 7);
+        writer.write((uint32_t)b.q[c], 7);
+    }
+    writer.write((uint32_t)a.p, 1);
+    writer.write((uint32_t)b.p, 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+    {
+        writer.write(indices[i], 4);
+    }
+}
+
+void encodeBlock(Block const & texels, BlockFormat block, CompressionQuality quality, uint8_t * out)
+{
+    uint8_t values[16];
+    switch (block)
+    {
+        case BlockFormat::eBC1:
+            encodeBC1(texels, quality, true, false, out);
+            break;
+        case BlockFormat::eBC3:
+            for (int i = 0; i < 16; ++i)
+            {
+                values[i] = texels[i][3];
+            }
+            encodeBC4(values, quality, out);
+            encodeBC1(texels, quality, false, true, out + 8);
+            break;
+        case BlockFormat::eBC4:
+        case BlockFormat::eBC5:
+            for (int c = 0; c < ((block == BlockFormat::eBC5) ? 2 : 1); ++c)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    values[i] = texels[i][c];
+                }
+                encodeBC4(values, quality, out + 8 * c);
+            }
+            break;
+        case BlockFormat::eBC7:
+            encodeBC7(texels, quality, out);
+            break;
+    }
+}
+
+// A 2D image (one layer or slice of a level) to compress
+struct Surface
+{
+    uint8_t const * texels;
+    size_t dst;         // Offset of the surface's blocks in the compressed pixels
+    uint32_t width;
+    uint32_t height;
+    size_t firstRow;    // Index of the surface's first row of blocks among all surfaces
+};
+} // anonymous namespace
+
+namespace Vkx
+{
+//! BC1, BC3 and BC7 require RGBA8 (unorm or sRGB) images. BC4 and BC5 require unorm images with at least one or two
+//! channels (R8, R8G8 or RGBA8).
+//!
+//! @param  format      Format of the uncompressed image
+//! @param  block       Block format
+//!
+//! @return true if the image can be compressed
+bool canCompressImage(vk::Format format, BlockFormat block)
+{
+    uint32_t channels = sourceChannels(format);
+    switch (block)
+    {
+        case BlockFormat::eBC4:
+            return channels >= 1 && format != vk::Format::eR8G8B8A8Srgb;
+        case BlockFormat::eBC5:
+            return channels >= 2 && format != vk::Format::eR8G8B8A8Srgb;
+        default:
+            return channels == 4;
+    }
+}
+
+//! The encoding (unorm or sRGB) of the image is preserved. BC1 images have 1-bit alpha.
+//!
+//! @param  format      Format of the uncompressed image
+//! @param  block       Block format
+//!
+//! @return compressed format
+//!
+//! @warning    A std::invalid_argument is thrown if the image cannot be compressed into the block format
+vk::Format compressedFormat(vk::Format format, BlockFormat block)
+{
+    if (!canCompressImage(format, block))
+        throw std::invalid_argument("Vkx::compressedFormat: unsupported format");
+
+    bool srgb = format == vk::Format::eR8G8B8A8Srgb;
+    switch (block)
+    {
+        case BlockFormat::eBC1:
+            return srgb ? vk::Format::eBc1RgbaSrgbBlock : vk::Format::eBc1RgbaUnormBlock;
+        case BlockFormat::eBC3:
+            return srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+        case BlockFormat::eBC4:
+            return vk::Format::eBc4UnormBlock;
+        case BlockFormat::eBC5:
+            return vk::Format::eBc5UnormBlock;
+        default:
+            return srgb ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+    }
+}
+
+//! The image data's texels must be tightly packed. If the image has mip levels and the data does not provide them, they are
+//! generated by generateMipChain() first, because compressed levels cannot be blitted. Every level and layer (and every slice
+//! of a 3D image) is compressed into its own region, and rows of blocks are compressed in parallel if there are workers.
+//!
+//! BC7 blocks are encoded in mode 6 only (one RGBA subset). BC1 blocks containing texels with alpha below 128 use the
+//! 3-color mode with transparent texels.
+//!
+//! @param  data        Uncompressed image data
+//! @param  block       Block format
+//! @param  quality     Speed/quality trade-off (default: CompressionQuality::eNormal)
+//! @param  workers     Worker threads used to compress the blocks, or nullptr to compress on the calling thread
+//!                     (default: nullptr)
+//!
+//! @return compressed image data, ready to be uploaded
+//!
+//! @warning    A std::invalid_argument is thrown if the image cannot be compressed into the block format, if its mip levels
+//!             are needed but cannot be generated, or if there are fewer pixels than the regions require
+ImageData compressImage(ImageData const &  data,
+                        BlockFormat        block,
+                        CompressionQuality quality /*= CompressionQuality::eNormal*/,
+                        ThreadPool *       workers /*= nullptr*/)
+{
+    vk::ImageCreateInfo const & info = data.info;
+    if (!canCompressImage(info.format, block))
+        throw std::invalid_argument("Vkx::compressImage: unsupported format");
+
+    ImageData const * source = &data;
+    ImageData withMipmaps;
+    if (info.mipLevels > 1 && !data.hasMipmaps())
+    {
+        if (!canGenerateMipChain(info))
+            throw std::invalid_argument("Vkx::compressImage: the mip levels cannot be generated");
+        withMipmaps = data;
+        generateMipChain(withMipmaps, MipFilter::eBox, workers);
+        source = &withMipmaps;
+    }
+
+    // Without regions, the pixels are level 0 of every layer
+    std::vector<vk::BufferImageCopy> regions = source->regions;
+    if (regions.empty())
+    {
+        regions.emplace_back(0,
+                             0,
+                             0,
+                             vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, info.arrayLayers),
+                             vk::Offset3D(0, 0, 0),
+                             info.extent);
+    }
+
+    ImageData result{ info, {}, {} };
+    result.info.format = compressedFormat(info.format, block);
+
+    uint32_t channels = sourceChannels(info.format);
+    size_t   bytes    = blockSize(block);
+    std::vector<Surface> surfaces;
+    size_t size = 0;
+    size_t rows = 0;
+    for (auto const & region : regions)
+    {
+        vk::Extent3D const & extent = region.imageExtent;
+        uint32_t blocksX   = (extent.width + 3) / 4;
+        uint32_t blocksY   = (extent.height + 3) / 4;
+        size_t surfaceSize = size_t(extent.width) * extent.height * channels;
+        uint32_t count     = region.imageSubresource.layerCount * extent.depth;
+        if (region.bufferOffset + surfaceSize * count > source->pixels.size())
+            throw std::invalid_argument("Vkx::compressImage: not enough pixels for the regions");
+
+        size = (size + 15) & ~size_t(15);
+        vk::BufferImageCopy compressed = region;
+        compressed.bufferOffset      = size;
+        compressed.bufferRowLength   = 0;
+        compressed.bufferImageHeight = 0;
+        result.regions.push_back(compressed);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            surfaces.push_back({ source->pixels.data() + region.bufferOffset + surfaceSize * i,
+                                 size,
+                                 extent.width,
+                                 extent.height,
+                                 rows });
+            size += blocksX * blocksY * bytes;
+            rows += blocksY;
+        }
+    }
+    result.pixels.resize(size);
+
+    auto compressRows = [&surfaces, &result, block, quality, channels, bytes] (size_t begin, size_t end) {
+                            for (size_t row = begin; row < end; ++row)
+                            {
+                                auto s = std::upper_bound(surfaces.begin(),
+                                                          surfaces.end(),
+                                                          row,
+                                                          [] (size_t r, Surface const & surface) {
+                                                              return r < surface.firstRow;
+                                                          }) - 1;
+                                uint32_t by      = (uint32_t)(row - s->firstRow);
+                                uint32_t blocksX = (s->width + 3) / 4;
+                                uint8_t * out    = result.pixels.data() + s->dst + size_t(by) * blocksX * bytes;
+                                Block texels;
+                                for (uint32_t bx = 0; bx < blocksX; ++bx)
+                                {
+                                    fetchBlock(s->texels, s->width, s->height, channels, bx * 4, by * 4, texels);
+                                    encodeBlock(texels, block, quality, out + bx * bytes);
+                                }
+                            }
+                        };
+
+    if (workers)
+        workers->parallelFor(rows, compressRows);
+    else
+        compressRows(0, rows);
+
+    return result;
+}
+} // namespace Vkx
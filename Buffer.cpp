@@ -4,6 +4,10 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
 namespace Vkx
 {
 //! @param  device              Logical device associated with the buffer
@@ -72,18 +76,140 @@ HostBuffer::HostBuffer(std::shared_ptr<Device> device,
              vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
              sharingMode)
 {
+    // The memory is unmapped implicitly when it is freed
+    data_ = device_->mapMemory(allocation(), 0, VK_WHOLE_SIZE, vk::MemoryMapFlags());
     if (src)
         set(0, src, size);
 }
 
+//! @param  src     Move source
+HostBuffer::HostBuffer(HostBuffer && src)
+    : Buffer(std::move(src))
+    , data_(src.data_)
+{
+    src.data_ = nullptr;
+}
+
+//! @param  rhs     Move source
+HostBuffer & HostBuffer::operator =(HostBuffer && rhs)
+{
+    if (this != &rhs)
+    {
+        Buffer::operator =(std::move(rhs));
+        data_     = rhs.data_;
+        rhs.data_ = nullptr;
+    }
+    return *this;
+}
+
 //! @param  offset  Where in the buffer to put the copied data
 //! @param  src     Data to be copied into the buffer
 //! @param  size    Size of the data to copy
 void HostBuffer::set(size_t offset, void const * src, size_t size)
 {
-    char * data = (char *)device_->mapMemory(allocation(), 0, size, vk::MemoryMapFlags());
-    memcpy(data + offset, src, size);
-    device_->unmapMemory(allocation());
+    memcpy(static_cast<char *>(data_) + offset, src, size);
+}
+
+//! @param  device          Logical device associated with the buffer
+//! @param  src             Memory to import
+//! @param  size            Size of the memory
+//! @param  usage           Usage flags (default: eTransferSrc)
+//! @param  sharingMode     Sharing mode flag (default: eExclusive)
+//!
+//! @warning    A std::runtime_error is thrown if the device cannot import CPU memory or the memory cannot be imported
+//! @warning    A std::invalid_argument is thrown if the memory is not aligned as the buffer requires, or if the buffer
+//!             requires more memory than the imported pages hold
+ImportedHostBuffer::ImportedHostBuffer(std::shared_ptr<Device> device,
+                                       void const *            src,
+                                       size_t                  size,
+                                       vk::BufferUsageFlags    usage /*= vk::BufferUsageFlagBits::eTransferSrc*/,
+                                       vk::SharingMode         sharingMode /*= vk::SharingMode::eExclusive*/)
+{
+    if (!isSupported(*device))
+        throw std::runtime_error("Vkx::ImportedHostBuffer::ImportedHostBuffer: VK_EXT_external_memory_host is not enabled");
+    device_ = device;
+
+    // The imported range must start and end on the boundaries given by minImportedHostPointerAlignment (typically pages), so
+    // the range is widened to them and the buffer is bound at the offset of the memory within it.
+    auto properties = device_->physical()->getProperties2<vk::PhysicalDeviceProperties2,
+                                                          vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>();
+    uintptr_t alignment = (uintptr_t)properties.get<vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>()
+                          .minImportedHostPointerAlignment;
+    uintptr_t address = reinterpret_cast<uintptr_t>(src);
+    uintptr_t first   = address & ~(alignment - 1);
+    uintptr_t last    = (address + size + alignment - 1) & ~(alignment - 1);
+    void * pages      = reinterpret_cast<void *>(first);
+
+    vk::ExternalMemoryBufferCreateInfo external(vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT);
+    vk::BufferCreateInfo info({}, size, usage, sharingMode);
+    info.pNext = &external;
+    buffer_    = device_->createBufferUnique(info);
+
+    vk::MemoryRequirements requirements = device_->getBufferMemoryRequirements(*buffer_);
+    if ((address - first) % requirements.alignment != 0)
+        throw std::invalid_argument("Vkx::ImportedHostBuffer::ImportedHostBuffer: the memory is not aligned for the buffer");
+
+    // The buffer may require more memory than its size (rounded up to an alignment), which could extend past the pages
+    if ((address - first) + requirements.size > last - first)
+        throw std::invalid_argument("Vkx::ImportedHostBuffer::ImportedHostBuffer: the buffer extends past the memory");
+
+    // The function is provided by an extension, so it must be loaded
+    auto getMemoryHostPointerProperties = reinterpret_cast<PFN_vkGetMemoryHostPointerPropertiesEXT>(
+        device_->getProcAddr("vkGetMemoryHostPointerPropertiesEXT"));
+    VkMemoryHostPointerPropertiesEXT hostProperties = {};
+    hostProperties.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+    if (!getMemoryHostPointerProperties ||
+        getMemoryHostPointerProperties(static_cast<VkDevice>(*device_),
+                                       VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+                                       pages,
+                                       &hostProperties) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Vkx::ImportedHostBuffer::ImportedHostBuffer: the memory cannot be imported");
+    }
+    uint32_t memoryType = findAppropriateMemoryType(device_->physical(),
+                                                    requirements.memoryTypeBits & hostProperties.memoryTypeBits,
+                                                    vk::MemoryPropertyFlags());
+
+    vk::ImportMemoryHostPointerInfoEXT import(vk::ExternalMemoryHandleTypeFlagBits::eHostAllocationEXT, pages);
+    vk::MemoryAllocateInfo allocateInfo(last - first, memoryType);
+    allocateInfo.pNext = &import;
+    allocation_        = device_->allocateMemoryUnique(allocateInfo);
+    device_->bindBufferMemory(*buffer_, *allocation_, address - first);
+}
+
+//! @param  device  Logical device
+//!
+//! @return true if VK_EXT_external_memory_host is enabled on the device
+bool ImportedHostBuffer::isSupported(Device const & device)
+{
+    return device.extensionEnabled(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+}
+
+//! The memory is imported into an ImportedHostBuffer if the device supports it. Otherwise, or if the memory cannot be
+//! imported, it is copied into a HostBuffer.
+//!
+//! @param  device      Logical device associated with the buffer
+//! @param  src         Data to be transferred
+//! @param  size        Size of the data
+//!
+//! @return a buffer with usage eTransferSrc holding the data at offset 0
+//!
+//! @warning    If the memory is imported, it must remain valid until the buffer is destroyed and the GPU has finished using
+//!             it.
+std::unique_ptr<Buffer> createStagingBuffer(std::shared_ptr<Device> device, void const * src, size_t size)
+{
+    if (ImportedHostBuffer::isSupported(*device))
+    {
+        try
+        {
+            return std::make_unique<ImportedHostBuffer>(device, src, size);
+        }
+        catch (std::exception const &)
+        {
+            // Fall back to copying
+        }
+    }
+    return std::make_unique<HostBuffer>(device, size, vk::BufferUsageFlagBits::eTransferSrc, src);
 }
 
 //! @param  device          Logical device associated with the buffer
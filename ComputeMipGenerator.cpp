@@ -0,0 +1,266 @@
+#include "ComputeMipGenerator.h"
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Image.h"
+#include "SamplerCache.h"
+#include "ShaderCache.h"
+#include "Vkx.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+// Push constants of shaders/GenerateMipmaps.comp
+struct Parameters
+{
+    int32_t width;
+    int32_t height;
+    int32_t levels;
+    int32_t groupsX;
+};
+
+uint32_t constexpr TILE_SIZE                  = 64;  // Size of the tile of the base level reduced by a workgroup
+uint32_t constexpr LEVELS_PER_WORKGROUP       = 6;   // Number of levels a workgroup reduces its tile to
+uint32_t constexpr MAX_GROUPS_FOR_SECOND_PASS = 64;  // Maximum workgroups in x or y for the last workgroup to continue
+
+vk::ImageMemoryBarrier levelBarrier(vk::Image       image,
+                                    uint32_t        baseLevel,
+                                    uint32_t        levelCount,
+                                    vk::AccessFlags srcAccess,
+                                    vk::AccessFlags dstAccess,
+                                    vk::ImageLayout oldLayout,
+                                    vk::ImageLayout newLayout)
+{
+    return vk::ImageMemoryBarrier(srcAccess,
+                                  dstAccess,
+                                  oldLayout,
+                                  newLayout,
+                                  VK_QUEUE_FAMILY_IGNORED,
+                                  VK_QUEUE_FAMILY_IGNORED,
+                                  image,
+                                  vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, baseLevel, levelCount, 0, 1));
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  device      Logical device associated with the images
+//! @param  shaderPath  Path to the SPIR-V compiled from shaders/GenerateMipmaps.comp
+//!
+//! @warning    A std::runtime_error is thrown if the shader cannot be loaded
+ComputeMipGenerator::ComputeMipGenerator(std::shared_ptr<Device> device, std::string const & shaderPath)
+    : device_(device)
+{
+    sampler_ = device_->samplers().get(vk::SamplerCreateInfo({},
+                                                             vk::Filter::eNearest,
+                                                             vk::Filter::eNearest,
+                                                             vk::SamplerMipmapMode::eNearest,
+                                                             vk::SamplerAddressMode::eClampToEdge,
+                                                             vk::SamplerAddressMode::eClampToEdge,
+                                                             vk::SamplerAddressMode::eClampToEdge));
+
+    std::array<vk::DescriptorSetLayoutBinding, 3> bindings =
+    {
+        vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageImage, MAX_LEVELS_PER_DISPATCH, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute)
+    };
+    descriptorSetLayout_ = device_->createDescriptorSetLayoutUnique(
+        vk::DescriptorSetLayoutCreateInfo({}, (uint32_t)bindings.size(), bindings.data()));
+
+    vk::PushConstantRange pushConstants(vk::ShaderStageFlagBits::eCompute, 0, sizeof(Parameters));
+    pipelineLayout_ = device_->createPipelineLayoutUnique(
+        vk::PipelineLayoutCreateInfo({}, 1, &(*descriptorSetLayout_), 1, &pushConstants));
+
+    ShaderCache::Module shader = device_->shaders().get(shaderPath);
+    vk::ComputePipelineCreateInfo info({},
+                                       vk::PipelineShaderStageCreateInfo({},
+                                                                         vk::ShaderStageFlagBits::eCompute,
+                                                                         *shader,
+                                                                         "main"),
+                                       *pipelineLayout_);
+    pipeline_ = std::move(device_->createComputePipelineUnique(nullptr, info).value);
+}
+
+//! @param  format  Format of the image
+//!
+//! @return true if the format can be sampled and used as a storage image
+bool ComputeMipGenerator::supports(vk::Format format) const
+{
+    vk::FormatFeatureFlags features = device_->physical()->getFormatProperties(format).optimalTilingFeatures;
+    return (features & vk::FormatFeatureFlagBits::eStorageImage) && (features & vk::FormatFeatureFlagBits::eSampledImage);
+}
+
+//! Mip level 0 is expected to be in the eTransferDstOptimal layout when the commands are executed. All levels are in the
+//! eShaderReadOnlyOptimal layout afterwards, just as they are after LocalImage::generateMipmaps().
+//!
+//! @param  commands        Command buffer to record the commands in. Its queue must support compute operations.
+//! @param  image           Image whose levels are generated from level 0
+//! @param  shaderStages    Stages that read the image afterwards, besides the compute shader. They must be supported by
+//!                         the command buffer's queue. (default: fragment shader)
+//!
+//! @return resources that must be kept until the commands have been executed
+//!
+//! @warning    A std::invalid_argument is thrown if the image is not a single-layer 2D storage image or its format is not
+//!             supported
+std::shared_ptr<MipDispatch> ComputeMipGenerator::record(
+    vk::CommandBuffer &    commands,
+    Image const &          image,
+    vk::PipelineStageFlags shaderStages /*= vk::PipelineStageFlagBits::eFragmentShader*/) const
+{
+    vk::ImageCreateInfo info = image.info();
+    if (info.imageType != vk::ImageType::e2D || info.arrayLayers != 1)
+        throw std::invalid_argument("Vkx::ComputeMipGenerator::record: only single-layer 2D images are supported");
+    if (!supports(info.format))
+        throw std::invalid_argument("Vkx::ComputeMipGenerator::record: unsupported format");
+    if (!(info.usage & vk::ImageUsageFlagBits::eStorage))
+        throw std::invalid_argument("Vkx::ComputeMipGenerator::record: the image was not created with eStorage usage");
+
+    auto dispatch = std::make_shared<MipDispatch>();
+    if (info.mipLevels <= 1)
+        return dispatch;
+
+    // Plan the dispatches. A dispatch generates levels 7 - 12 only if its level 6 is small enough for a single workgroup.
+    struct Pass
+    {
+        uint32_t base;
+        uint32_t levels;
+        uint32_t groupsX;
+        uint32_t groupsY;
+    };
+    std::vector<Pass> passes;
+    for (uint32_t base = 0; base + 1 < info.mipLevels;)
+    {
+        uint32_t width   = std::max(info.extent.width >> base, 1u);
+        uint32_t height  = std::max(info.extent.height >> base, 1u);
+        uint32_t groupsX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        uint32_t groupsY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        uint32_t levels  = std::min(info.mipLevels - 1 - base, MAX_LEVELS_PER_DISPATCH);
+        if (groupsX > MAX_GROUPS_FOR_SECOND_PASS || groupsY > MAX_GROUPS_FOR_SECOND_PASS)
+            levels = std::min(levels, LEVELS_PER_WORKGROUP);
+        passes.push_back({ base, levels, groupsX, groupsY });
+        base += levels;
+    }
+
+    std::array<vk::DescriptorPoolSize, 3> poolSizes =
+    {
+        vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, (uint32_t)passes.size()),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, (uint32_t)passes.size() * MAX_LEVELS_PER_DISPATCH),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, (uint32_t)passes.size())
+    };
+    dispatch->descriptorPool = device_->createDescriptorPoolUnique(
+        vk::DescriptorPoolCreateInfo({}, (uint32_t)passes.size(), (uint32_t)poolSizes.size(), poolSizes.data()));
+    std::vector<vk::DescriptorSetLayout> layouts(passes.size(), *descriptorSetLayout_);
+    std::vector<vk::DescriptorSet> sets = device_->allocateDescriptorSets(
+        vk::DescriptorSetAllocateInfo(*dispatch->descriptorPool, (uint32_t)layouts.size(), layouts.data()));
+
+    auto levelView = [this, &info, &image] (uint32_t level) {
+                         return device_->createImageViewUnique(
+                             vk::ImageViewCreateInfo({},
+                                                     image,
+                                                     vk::ImageViewType::e2D,
+                                                     info.format,
+                                                     vk::ComponentMapping(),
+                                                     vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1)));
+                     };
+
+    // Level 0 is sampled and the other levels are written, so they all start in different layouts
+    std::array<vk::ImageMemoryBarrier, 2> initial =
+    {
+        levelBarrier(image,
+                     0,
+                     1,
+                     vk::AccessFlagBits::eTransferWrite,
+                     vk::AccessFlagBits::eShaderRead,
+                     vk::ImageLayout::eTransferDstOptimal,
+                     vk::ImageLayout::eShaderReadOnlyOptimal),
+        levelBarrier(image,
+                     1,
+                     info.mipLevels - 1,
+                     vk::AccessFlags(),
+                     vk::AccessFlagBits::eShaderWrite,
+                     vk::ImageLayout::eUndefined,
+                     vk::ImageLayout::eGeneral)
+    };
+    commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eTopOfPipe,
+                             vk::PipelineStageFlagBits::eComputeShader,
+                             {},
+                             nullptr,
+                             nullptr,
+                             initial);
+
+    // The counters must be zero when the dispatches start
+    for (auto const & pass : passes)
+    {
+        dispatch->intermediates.emplace_back(device_,
+                                             sizeof(uint32_t) * 4 + sizeof(float) * 4 * pass.groupsX * pass.groupsY,
+                                             vk::BufferUsageFlagBits::eStorageBuffer);
+        commands.fillBuffer(dispatch->intermediates.back(), 0, sizeof(uint32_t), 0);
+    }
+    vk::MemoryBarrier cleared(vk::AccessFlagBits::eTransferWrite,
+                              vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                             vk::PipelineStageFlagBits::eComputeShader,
+                             {},
+                             cleared,
+                             nullptr,
+                             nullptr);
+
+    commands.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline_);
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        Pass const & pass = passes[i];
+
+        dispatch->views.push_back(levelView(pass.base));
+        vk::DescriptorImageInfo baseInfo(sampler_, *dispatch->views.back(), vk::ImageLayout::eShaderReadOnlyOptimal);
+
+        // Unused elements of the array refer to the last level generated, but the shader never writes to them
+        std::array<vk::DescriptorImageInfo, MAX_LEVELS_PER_DISPATCH> levelInfos;
+        for (uint32_t j = 0; j < MAX_LEVELS_PER_DISPATCH; ++j)
+        {
+            if (j < pass.levels)
+                dispatch->views.push_back(levelView(pass.base + 1 + j));
+            levelInfos[j] = vk::DescriptorImageInfo(nullptr, *dispatch->views.back(), vk::ImageLayout::eGeneral);
+        }
+
+        vk::DescriptorBufferInfo intermediateInfo(dispatch->intermediates[i], 0, VK_WHOLE_SIZE);
+
+        std::array<vk::WriteDescriptorSet, 3> writes =
+        {
+            vk::WriteDescriptorSet(sets[i], 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &baseInfo),
+            vk::WriteDescriptorSet(sets[i], 1, 0, MAX_LEVELS_PER_DISPATCH, vk::DescriptorType::eStorageImage, levelInfos.data()),
+            vk::WriteDescriptorSet(sets[i], 2, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &intermediateInfo)
+        };
+        device_->updateDescriptorSets(writes, nullptr);
+
+        Parameters parameters{ (int32_t)std::max(info.extent.width >> pass.base, 1u),
+                               (int32_t)std::max(info.extent.height >> pass.base, 1u),
+                               (int32_t)pass.levels,
+                               (int32_t)pass.groupsX };
+        commands.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout_, 0, sets[i], nullptr);
+        commands.pushConstants(*pipelineLayout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(parameters), &parameters);
+        commands.dispatch(pass.groupsX, pass.groupsY, 1);
+
+        // The levels just generated are done. The last of them is sampled by the next dispatch, if there is one.
+        vk::ImageMemoryBarrier done = levelBarrier(image,
+                                                   pass.base + 1,
+                                                   pass.levels,
+                                                   vk::AccessFlagBits::eShaderWrite,
+                                                   vk::AccessFlagBits::eShaderRead,
+                                                   vk::ImageLayout::eGeneral,
+                                                   vk::ImageLayout::eShaderReadOnlyOptimal);
+        commands.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                 shaderStages | vk::PipelineStageFlagBits::eComputeShader,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 done);
+    }
+
+    return dispatch;
+}
+} // namespace Vkx
@@ -0,0 +1,150 @@
+#include "DescriptorAllocator.h"
+
+#include "Device.h"
+#include "SwapChain.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Vkx
+{
+//! The pools hold enough descriptors for setsPerPool sets of the average composition given by descriptorsPerSet. A frame's
+//! first pool holds setsPerPool sets, and each pool added after it holds twice as many as the previous one.
+//!
+//! @param  device              Logical device that creates the pools
+//! @param  descriptorsPerSet   Average number of descriptors of each type in a set
+//! @param  frames              Number of frames in flight (see SwapChain::framesInFlight())
+//! @param  setsPerPool         Number of sets in a frame's first pool (default: 64)
+//!
+//! @warning    A std::invalid_argument is thrown if descriptorsPerSet is empty, frames < 1, or setsPerPool is 0
+DescriptorAllocator::DescriptorAllocator(std::shared_ptr<Device>                     device,
+                                         std::vector<vk::DescriptorPoolSize> const & descriptorsPerSet,
+                                         int                                         frames,
+                                         uint32_t                                    setsPerPool /*= 64*/)
+    : device_(device)
+    , descriptorsPerSet_(descriptorsPerSet)
+    , setsPerPool_(std::min(setsPerPool, MAX_SETS_PER_POOL))
+{
+    if (descriptorsPerSet.empty())
+        throw std::invalid_argument("Vkx::DescriptorAllocator::DescriptorAllocator: no descriptor types");
+    if (frames < 1)
+        throw std::invalid_argument("Vkx::DescriptorAllocator::DescriptorAllocator: frames must be at least 1");
+    if (setsPerPool == 0)
+        throw std::invalid_argument("Vkx::DescriptorAllocator::DescriptorAllocator: setsPerPool must be at least 1");
+    frames_.resize(frames);
+}
+
+//! All sets allocated during the frame's previous use become invalid.
+//!
+//! @param  frame   Index of the frame in [0, frames)
+//!
+//! @warning    The GPU must have finished with the frame's previous sets. SwapChain::swap() ensures this by waiting for the
+//!             frame's in-flight fence, so this is normally called after it.
+//! @warning    A std::out_of_range is thrown if the frame is out of range
+void DescriptorAllocator::beginFrame(int frame)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    FrameData & data = frames_.at(frame);
+    for (auto & pool : data.pools)
+    {
+        device_->resetDescriptorPool(*pool.pool);
+        pool.used = false;
+    }
+    data.current  = 0;
+    data.sets     = 0;
+    currentFrame_ = frame;
+}
+
+//! @param  swapChain   Swap chain whose current frame is started. Its frame count must match this allocator's.
+//!
+//! @warning    This must be called after SwapChain::swap() has returned.
+void DescriptorAllocator::beginFrame(SwapChain const & swapChain)
+{
+    beginFrame(swapChain.frame());
+}
+
+//! @param  layout  Layout of the set
+//!
+//! @return descriptor set, which remains valid until beginFrame() is called again for the current frame
+//!
+//! @warning    A std::runtime_error is thrown if a set with the layout does not fit in an empty pool. The frame's pools are
+//!             left as they were, so a set that is too large does not make them grow.
+vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    FrameData & frame = frames_[currentFrame_];
+    if (frame.pools.empty())
+        addPool(frame);
+
+    size_t first = frame.current;
+    bool   added = false;       // True if a pool has been added for this set
+    while (true)
+    {
+        Pool & pool = frame.pools[frame.current];
+        try
+        {
+            std::vector<vk::DescriptorSet> sets = device_->allocateDescriptorSets(
+                vk::DescriptorSetAllocateInfo(*pool.pool, 1, &layout));
+            pool.used = true;
+            ++frame.sets;
+            ++allocations_;
+            growths_ += frame.current - first;
+            return sets[0];
+        }
+        catch (vk::OutOfPoolMemoryError const &)
+        {
+        }
+        catch (vk::FragmentedPoolError const &)
+        {
+        }
+
+        // A set that does not fit in an empty pool is rejected, and a pool added for it is removed
+        if (!pool.used)
+        {
+            if (added)
+                frame.pools.pop_back();
+            frame.current = first;
+            throw std::runtime_error("Vkx::DescriptorAllocator::allocate: the set does not fit in an empty pool");
+        }
+
+        // Move on to the next pool, adding it if necessary
+        ++frame.current;
+        added = frame.current == frame.pools.size();
+        if (added)
+            addPool(frame);
+    }
+}
+
+DescriptorAllocator::Statistics DescriptorAllocator::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics statistics{ 0, 0, allocations_, growths_ };
+    for (auto const & frame : frames_)
+    {
+        statistics.pools += frame.pools.size();
+        statistics.sets  += frame.sets;
+    }
+    return statistics;
+}
+
+void DescriptorAllocator::addPool(FrameData & frame)
+{
+    uint32_t maxSets = frame.pools.empty() ? setsPerPool_ : std::min(frame.pools.back().maxSets * 2, MAX_SETS_PER_POOL);
+
+    std::vector<vk::DescriptorPoolSize> sizes = descriptorsPerSet_;
+    for (auto & size : sizes)
+    {
+        size.descriptorCount = std::max(size.descriptorCount * maxSets, 1u);
+    }
+
+    Pool pool;
+    pool.pool = device_->createDescriptorPoolUnique(vk::DescriptorPoolCreateInfo({},
+                                                                                 maxSets,
+                                                                                 (uint32_t)sizes.size(),
+                                                                                 sizes.data()));
+    pool.maxSets = maxSets;
+    frame.pools.push_back(std::move(pool));
+}
+} // namespace Vkx
@@ -0,0 +1,102 @@
+#include "DescriptorUpdateTemplate.h"
+
+#include "Device.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+// Returns the size of the info describing a descriptor of the given type
+size_t infoSize(vk::DescriptorType type)
+{
+    switch (type)
+    {
+        case vk::DescriptorType::eUniformTexelBuffer:
+        case vk::DescriptorType::eStorageTexelBuffer:
+            return sizeof(vk::BufferView);
+        case vk::DescriptorType::eUniformBuffer:
+        case vk::DescriptorType::eStorageBuffer:
+        case vk::DescriptorType::eUniformBufferDynamic:
+        case vk::DescriptorType::eStorageBufferDynamic:
+            return sizeof(vk::DescriptorBufferInfo);
+        default:
+            return sizeof(vk::DescriptorImageInfo);
+    }
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  device      Logical device that creates the template
+//! @param  layout      Layout of the descriptor sets that are updated
+//! @param  entries     Bindings to update and where their descriptor info is found (see entry())
+//!
+//! @warning    A std::invalid_argument is thrown if there are no entries
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(std::shared_ptr<Device>                                device,
+                                                   vk::DescriptorSetLayout                                layout,
+                                                   std::vector<vk::DescriptorUpdateTemplateEntry> const & entries)
+    : device_(device)
+{
+    if (entries.empty())
+        throw std::invalid_argument("Vkx::DescriptorUpdateTemplate::DescriptorUpdateTemplate: no entries");
+
+    for (auto const & entry : entries)
+    {
+        if (entry.descriptorCount > 0)
+            size_ = std::max(size_, entry.offset + (entry.descriptorCount - 1) * entry.stride + infoSize(entry.descriptorType));
+    }
+
+    template_ = device_->createDescriptorUpdateTemplateUnique(
+        vk::DescriptorUpdateTemplateCreateInfo({},
+                                               (uint32_t)entries.size(),
+                                               entries.data(),
+                                               vk::DescriptorUpdateTemplateType::eDescriptorSet,
+                                               layout));
+}
+
+//! @param  set     Descriptor set to update
+//! @param  data    Descriptor info, at the offsets given by the entries
+//! @param  size    Size of the data
+//!
+//! @warning    A std::invalid_argument is thrown if the data is too small for the entries
+void DescriptorUpdateTemplate::update(vk::DescriptorSet set, void const * data, size_t size) const
+{
+    if (size < size_)
+        throw std::invalid_argument("Vkx::DescriptorUpdateTemplate::update: the data is too small for the entries");
+    device_->updateDescriptorSetWithTemplate(set, *template_, data);
+}
+
+vk::DescriptorUpdateTemplateEntry DescriptorUpdateTemplate::makeEntry(uint32_t           binding,
+                                                                      uint32_t           arrayElement,
+                                                                      uint32_t           count,
+                                                                      vk::DescriptorType type,
+                                                                      Kind               kind,
+                                                                      size_t             offset,
+                                                                      size_t             stride)
+{
+    Kind expected;
+    switch (type)
+    {
+        case vk::DescriptorType::eUniformTexelBuffer:
+        case vk::DescriptorType::eStorageTexelBuffer:
+            expected = Kind::eTexelBuffer;
+            break;
+        case vk::DescriptorType::eUniformBuffer:
+        case vk::DescriptorType::eStorageBuffer:
+        case vk::DescriptorType::eUniformBufferDynamic:
+        case vk::DescriptorType::eStorageBufferDynamic:
+            expected = Kind::eBuffer;
+            break;
+        default:
+            expected = Kind::eImage;
+            break;
+    }
+    if (kind != expected)
+        throw std::invalid_argument("Vkx::DescriptorUpdateTemplate::entry: the member does not hold this type of descriptor");
+
+    return vk::DescriptorUpdateTemplateEntry(binding, arrayElement, count, type, offset, stride);
+}
+} // namespace Vkx
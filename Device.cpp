@@ -1,9 +1,32 @@
 #include "Device.h"
 
 #include "Instance.h"
+#include "PipelineCache.h"
+#include "SamplerCache.h"
+#include "ShaderCache.h"
 
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
+
+namespace
+{
+// Returns the core features enabled by a device's creation info, either directly or by a chained
+// vk::PhysicalDeviceFeatures2
+vk::PhysicalDeviceFeatures featuresOf(vk::DeviceCreateInfo const & info)
+{
+    if (info.pEnabledFeatures)
+        return *info.pEnabledFeatures;
+
+    for (auto next = static_cast<vk::BaseInStructure const *>(info.pNext); next; next = next->pNext)
+    {
+        if (next->sType == vk::StructureType::ePhysicalDeviceFeatures2)
+            return reinterpret_cast<vk::PhysicalDeviceFeatures2 const *>(next)->features;
+    }
+    return vk::PhysicalDeviceFeatures();
+}
+} // anonymous namespace
+
 namespace Vkx
 {
 //! @param  physicalDevice  Physical device to be associated with this device
@@ -11,19 +34,35 @@ namespace Vkx
 Device::Device(std::shared_ptr<PhysicalDevice> physicalDevice, vk::DeviceCreateInfo const & info)
     : vk::Device(physicalDevice->createDevice(info))
     , physicalDevice_(physicalDevice)
+    , extensions_(info.ppEnabledExtensionNames, info.ppEnabledExtensionNames + info.enabledExtensionCount)
+    , features_(featuresOf(info))
 {
+    vk::PhysicalDeviceProperties properties = physicalDevice_->getProperties();
+    samplers_      = std::make_unique<SamplerCache>(*this, properties.limits.maxSamplerAllocationCount);
+    pipelineCache_ = std::make_unique<PipelineCache>(*this, properties);
+    shaders_       = std::make_unique<ShaderCache>(*this);
 }
 
 //! @param  src     Move source
 Device::Device(Device && src)
     : vk::Device(src)
     , physicalDevice_(std::move(src.physicalDevice_))
+    , samplers_(std::move(src.samplers_))
+    , pipelineCache_(std::move(src.pipelineCache_))
+    , shaders_(std::move(src.shaders_))
+    , extensions_(std::move(src.extensions_))
+    , features_(src.features_)
 {
+    if (shaders_)
+        shaders_->device_ = this;
     static_cast<vk::Device &>(src) = nullptr;
 }
 
 Device::~Device()
 {
+    shaders_.reset();
+    pipelineCache_.reset();
+    samplers_.reset();
     vk::Device::destroy();
 }
 
@@ -32,16 +71,34 @@ Device & Device::operator =(Device && rhs)
 {
     if (this != &rhs)
     {
+        shaders_.reset();
+        pipelineCache_.reset();
+        samplers_.reset();
         vk::Device::destroy();
         
         vk::Device::operator =(rhs);
         physicalDevice_ = std::move(rhs.physicalDevice_);
+        samplers_       = std::move(rhs.samplers_);
+        pipelineCache_  = std::move(rhs.pipelineCache_);
+        shaders_        = std::move(rhs.shaders_);
+        extensions_     = std::move(rhs.extensions_);
+        features_       = rhs.features_;
+        if (shaders_)
+            shaders_->device_ = this;
         
         static_cast<vk::Device &>(rhs) = nullptr;
     }
     return *this;
 }
 
+//! @param  name    Name of the extension
+//!
+//! @return true if the extension is enabled
+bool Device::extensionEnabled(char const * name) const
+{
+    return std::find(extensions_.begin(), extensions_.end(), name) != extensions_.end();
+}
+
 PhysicalDevice::PhysicalDevice(std::shared_ptr<Instance> &                                                instance,
                                vk::SurfaceKHR                                                             surface,
                                std::function<vk::PhysicalDevice(std::vector<vk::PhysicalDevice> const &)> chooser)
@@ -1,15 +1,29 @@
 #include "Image.h"
 
 #include "Buffer.h"
+#include "ComputeMipGenerator.h"
+#include "MipGenerator.h"
+#include "PixelCopy.h"
 #include "Vkx.h"
 
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
+#include <stdexcept>
 
 namespace Vkx
 {
+//! @return true if any region copies to a level other than level 0
+bool ImageData::hasMipmaps() const
+{
+    return std::any_of(regions.begin(),
+                       regions.end(),
+                       [] (vk::BufferImageCopy const & r) { return r.imageSubresource.mipLevel > 0; });
+}
+
 //! @param  device              Logical device associated with the image
 //! @param  info                Creation info
 //! @param  memoryProperties    Memory properties
@@ -38,10 +52,10 @@ Image::Image(std::shared_ptr<Device>     device,
     view_ = device->createImageViewUnique(
         vk::ImageViewCreateInfo({},
                                 *image_,
-                                vk::ImageViewType::e2D,
+                                viewType(info_),
                                 info_.format,
                                 vk::ComponentMapping(),
-                                vk::ImageSubresourceRange(aspect, 0, info_.mipLevels, 0, 1)));
+                                vk::ImageSubresourceRange(aspect, 0, info_.mipLevels, 0, info_.arrayLayers)));
 }
 
 //! @param  src     Move source
@@ -73,18 +87,42 @@ Image & Image::operator =(Image && rhs)
 //!
 //! @param  width       Width of the image
 //! @param  height      Height of the image
+//! @param  depth       Depth of the image (default: 1)
 //!
 //! @return number of levels
-uint32_t Image::computeMaxMipLevels(uint32_t width, uint32_t height)
+uint32_t Image::computeMaxMipLevels(uint32_t width, uint32_t height, uint32_t depth /*= 1*/)
 {
-    return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    return static_cast<uint32_t>(std::floor(std::log2(std::max({ width, height, depth })))) + 1;
+}
+
+//! A 2D image with 6 layers (or a multiple of 6) is viewed as a cube (or cube array) if it is cube-compatible. Otherwise, a
+//! 1D or 2D image with more than one layer is viewed as an array.
+//!
+//! @param  info        Creation info of the image
+//!
+//! @return the type of view that includes all of the image's layers
+vk::ImageViewType Image::viewType(vk::ImageCreateInfo const & info)
+{
+    switch (info.imageType)
+    {
+        case vk::ImageType::e1D:
+            return (info.arrayLayers > 1) ? vk::ImageViewType::e1DArray : vk::ImageViewType::e1D;
+        case vk::ImageType::e3D:
+            return vk::ImageViewType::e3D;
+        default:
+            if ((info.flags & vk::ImageCreateFlagBits::eCubeCompatible) && info.arrayLayers % 6 == 0)
+                return (info.arrayLayers == 6) ? vk::ImageViewType::eCube : vk::ImageViewType::eCubeArray;
+            return (info.arrayLayers > 1) ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
+    }
 }
 
 //! @param  device              Logical device associated with the image
 //! @param  info                Creation info
-//! @param  src                 Image data
-//! @param  size                Size of image data
+//! @param  src                 Image data (tightly-packed texels), or nullptr if nothing to copy (default: nullptr)
+//! @param  size                Size of image data (default: 0)
 //! @param  aspect              Image aspect
+//!
+//! @warning    A std::invalid_argument is thrown if the image's tiling is not linear
 HostImage::HostImage(std::shared_ptr<Device>     device,
                      vk::ImageCreateInfo const & info,
                      void const *                src /*= nullptr*/,
@@ -95,18 +133,118 @@ HostImage::HostImage(std::shared_ptr<Device>     device,
             vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
             aspect)
 {
+    // The layout of an optimally-tiled image's memory is not defined, so it cannot be written by the CPU
+    if (info.tiling != vk::ImageTiling::eLinear)
+        throw std::invalid_argument("Vkx::HostImage::HostImage: the image's tiling must be linear");
+
+    layout_ = device_->getImageSubresourceLayout(*image_, vk::ImageSubresource(aspect, 0, 0));
+
+    // The memory is unmapped implicitly when it is freed
+    data_ = device_->mapMemory(allocation(), 0, VK_WHOLE_SIZE, vk::MemoryMapFlags());
+
     if (src && size > 0)
         set(src, 0, size);
 }
 
+//! @param  src     Move source
+HostImage::HostImage(HostImage && src)
+    : Image(std::move(src))
+    , data_(src.data_)
+    , layout_(src.layout_)
+{
+    src.data_ = nullptr;
+}
+
+//! @param  rhs     Move source
+HostImage & HostImage::operator =(HostImage && rhs)
+{
+    if (this != &rhs)
+    {
+        Image::operator =(std::move(rhs));
+        data_     = rhs.data_;
+        layout_   = rhs.layout_;
+        rhs.data_ = nullptr;
+    }
+    return *this;
+}
+
+//! The offset and size refer to the image's texels as if they were tightly packed, and the data is copied to wherever
+//! they are in the image's memory, so a range may start and end anywhere, even in the middle of a row. Data past the end
+//! of the image is ignored.
+//!
+//! Splitting the data at padded rows requires the size of a texel, which texelSize() knows only for some formats. The rows
+//! of an image in any other format are taken to be tightly packed unless the row pitch is not a multiple of the width.
+//!
 //! @param  src         Source data
-//! @param  offset      Offset to the start of the image in the source data
-//! @param  size        Size of image data
+//! @param  offset      Where the data goes, as an offset into the image's tightly-packed texels
+//! @param  size        Size of the data
+//!
+//! @warning    A std::invalid_argument is thrown if the rows are padded and the size of a texel of the format is unknown
 void HostImage::set(void const * src, size_t offset, size_t size)
 {
-    char * data = (char *)device_->mapMemory(allocation(), 0, size, vk::MemoryMapFlags());
-    memcpy(data + offset, src, size);
-    device_->unmapMemory(allocation());
+    size_t rowSize = layout_.rowPitch;
+    try
+    {
+        rowSize = info_.extent.width * texelSize(info_.format);
+    }
+    catch (std::invalid_argument const &)
+    {
+        if (layout_.rowPitch % info_.extent.width != 0)
+            throw std::invalid_argument("Vkx::HostImage::set: the rows are padded, but the format's texel size is unknown");
+    }
+    size_t end = std::min(offset + size, rowSize * info_.extent.height);
+    uint8_t const * in = static_cast<uint8_t const *>(src);
+    uint8_t *       out = static_cast<uint8_t *>(data_) + layout_.offset;
+
+    if (rowSize == layout_.rowPitch)
+    {
+        if (offset < end)
+            memcpy(out + offset, in, end - offset);
+        return;
+    }
+
+    // A partial first row, then whole rows, then a partial last row
+    while (offset < end)
+    {
+        size_t row    = offset / rowSize;
+        size_t column = offset % rowSize;
+        size_t count  = std::min(rowSize - column, end - offset);
+        if (column == 0 && count == rowSize)
+        {
+            uint32_t rows = (uint32_t)((end - offset) / rowSize);
+            copyRows(out + row * layout_.rowPitch, layout_.rowPitch, in, rowSize, rowSize, rows);
+            count = rows * rowSize;
+        }
+        else
+        {
+            memcpy(out + row * layout_.rowPitch + column, in, count);
+        }
+        in     += count;
+        offset += count;
+    }
+}
+
+//! @param  rect        Where the texels go in the image
+//! @param  src         Texels to copy
+//! @param  srcPitch    Distance in bytes between the starts of rows in the source
+//!
+//! @warning    A std::invalid_argument is thrown if the rectangle is not inside the image
+void HostImage::set(vk::Rect2D const & rect, void const * src, size_t srcPitch)
+{
+    if (rect.offset.x < 0 || rect.offset.y < 0 ||
+        rect.offset.x + rect.extent.width > info_.extent.width ||
+        rect.offset.y + rect.extent.height > info_.extent.height)
+    {
+        throw std::invalid_argument("Vkx::HostImage::set: the rectangle is not inside the image");
+    }
+
+    size_t texel = texelSize(info_.format);
+    copyRows(static_cast<uint8_t *>(data_) + layout_.offset + rect.offset.y * layout_.rowPitch + rect.offset.x * texel,
+             layout_.rowPitch,
+             src,
+             srcPitch,
+             rect.extent.width * texel,
+             rect.extent.height);
 }
 
 //! @param  device              Logical device associated with the image
@@ -138,6 +276,23 @@ LocalImage::LocalImage(std::shared_ptr<Device> device,
     set(commandPool, queue, src, size);
 }
 
+//! @param  device              Logical device associated with the image
+//! @param  commandPool         Command buffer allocator
+//! @param  queue               Queue used to initialize the image
+//! @param  data                Creation info and image data
+//! @param  aspect              Image aspect
+LocalImage::LocalImage(std::shared_ptr<Device> device,
+                       vk::CommandPool const & commandPool,
+                       vk::Queue const &       queue,
+                       ImageData const &       data,
+                       vk::ImageAspectFlags    aspect /*= vk::ImageAspectFlagBits::eColor*/)
+    : Image(device, data.info, vk::MemoryPropertyFlagBits::eDeviceLocal, aspect)
+{
+    set(commandPool, queue, data);
+}
+
+//! The data is level 0 of every layer, one layer after another. Any other levels are generated.
+//!
 //! @param  commandPool         Command buffer allocator
 //! @param  queue               Queue used to initialize the image
 //! @param  src                 Image data
@@ -147,6 +302,14 @@ void LocalImage::set(vk::CommandPool const & commandPool,
                      void const *            src,
                      size_t                  size)
 {
+    // If the mip levels cannot be blitted, then they are generated on the CPU instead
+    if (info_.mipLevels > 1 && !gpuCanGenerateMipmaps())
+    {
+        uint8_t const * pixels = static_cast<uint8_t const *>(src);
+        set(commandPool, queue, ImageData{ info_, std::vector<uint8_t>(pixels, pixels + size), {} });
+        return;
+    }
+
     // Transition to transfer dst for copy
     transitionLayout(commandPool,
                      queue,
@@ -174,6 +337,290 @@ void LocalImage::set(vk::CommandPool const & commandPool,
     }
 }
 
+//! The texels are converted directly into the staging buffer, so the only copy made on the CPU is the conversion itself. If
+//! the image has mip levels, they are generated (on the CPU if they cannot be generated on the GPU).
+//!
+//! @param  commandPool         Command buffer allocator
+//! @param  queue               Queue used to initialize the image
+//! @param  src                 Tightly-packed texels of level 0 of each layer, one layer after another
+//! @param  srcFormat           Format of the texels. See convertRows() for the supported conversions.
+//!
+//! @warning    A std::invalid_argument is thrown if the texels cannot be converted to the image's format
+void LocalImage::set(vk::CommandPool const & commandPool,
+                     vk::Queue const &       queue,
+                     void const *            src,
+                     vk::Format              srcFormat)
+{
+    if (!canConvertRows(srcFormat, info_.format))
+        throw std::invalid_argument("Vkx::LocalImage::set: the texels cannot be converted to the image's format");
+
+    uint32_t width  = info_.extent.width;
+    uint32_t rows   = info_.extent.height * info_.extent.depth * info_.arrayLayers;
+    size_t   srcRow = width * texelSize(srcFormat);
+    size_t   dstRow = width * texelSize(info_.format);
+
+    // Generating the mip levels on the CPU needs the converted texels in CPU memory anyway
+    if (info_.mipLevels > 1 && !gpuCanGenerateMipmaps())
+    {
+        ImageData data{ info_, std::vector<uint8_t>(dstRow * rows), {} };
+        convertRows(data.pixels.data(), dstRow, info_.format, src, srcRow, srcFormat, width, rows);
+        set(commandPool, queue, data);
+        return;
+    }
+
+    HostBuffer staging(device_, dstRow * rows, vk::BufferUsageFlagBits::eTransferSrc);
+    convertRows(staging.data(), dstRow, info_.format, src, srcRow, srcFormat, width, rows);
+
+    executeOnceSynched(device_,
+                       commandPool,
+                       queue,
+                       [this, &staging] (vk::CommandBuffer & commands) {
+                           transitionLayout(commands, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+                           copy(commands, staging);
+                           if (info_.mipLevels > 1)
+                               generateMipmaps(commands);
+                           else
+                               transitionLayout(commands,
+                                                vk::ImageLayout::eTransferDstOptimal,
+                                                vk::ImageLayout::eShaderReadOnlyOptimal);
+                       });
+}
+
+//! All of the regions are copied with a single command. If the data provides mip levels, they are used as-is; otherwise, if
+//! the image has mip levels, they are generated. They are generated on the CPU if they cannot be generated on the GPU.
+//!
+//! @param  commandPool         Command buffer allocator
+//! @param  queue               Queue used to initialize the image
+//! @param  data                Image data
+//!
+//! @warning    A std::invalid_argument is thrown if the mip levels must be generated on the CPU and generateMipChain() does
+//!             not support the image (see canGenerateMipChain())
+void LocalImage::set(vk::CommandPool const & commandPool,
+                     vk::Queue const &       queue,
+                     ImageData const &       data)
+{
+    if (info_.mipLevels > 1 && !data.hasMipmaps() && !gpuCanGenerateMipmaps())
+    {
+        if (!canGenerateMipChain(info_))
+            throw std::invalid_argument("Vkx::LocalImage::set: the mip levels cannot be generated for this format");
+        ImageData withMipmaps = data;
+        withMipmaps.info.mipLevels = info_.mipLevels;
+        generateMipChain(withMipmaps);
+        set(commandPool, queue, withMipmaps);
+        return;
+    }
+
+    HostBuffer staging(device_,
+                       data.pixels.size(),
+                       vk::BufferUsageFlagBits::eTransferSrc,
+                       data.pixels.data());
+
+    executeOnceSynched(device_,
+                       commandPool,
+                       queue,
+                       [this, &data, &staging] (vk::CommandBuffer & commands) {
+                           transitionLayout(commands, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+                           if (data.regions.empty())
+                               copy(commands, staging);
+                           else
+                               copy(commands, staging, data.regions);
+
+                           if (info_.mipLevels > 1 && !data.hasMipmaps())
+                               generateMipmaps(commands);
+                           else
+                               transitionLayout(commands,
+                                                vk::ImageLayout::eTransferDstOptimal,
+                                                vk::ImageLayout::eShaderReadOnlyOptimal);
+                       });
+}
+
+//! Level 0 of the layer is replaced and the layer's other levels are regenerated (on the CPU if they cannot be blitted). The
+//! other layers are not affected, so the layers of an array can be filled one at a time.
+//!
+//! @param  commandPool         Command buffer allocator
+//! @param  queue               Queue used to update the image
+//! @param  layer               Layer to replace
+//! @param  src                 Texels of level 0 of the layer
+//! @param  size                Size of the texels
+//!
+//! @warning    The layer must not be in use by the GPU when this function is called.
+//! @warning    A std::invalid_argument is thrown if the mip levels cannot be blitted and generateMipChain() does not support
+//!             the image (see canGenerateMipChain())
+void LocalImage::setLayer(vk::CommandPool const & commandPool,
+                          vk::Queue const &       queue,
+                          uint32_t                layer,
+                          void const *            src,
+                          size_t                  size)
+{
+    HostBuffer staging;
+    std::vector<vk::BufferImageCopy> regions;
+    if (info_.mipLevels > 1 && !canBlitMipmaps())
+    {
+        if (!canGenerateMipChain(info_))
+            throw std::invalid_argument("Vkx::LocalImage::setLayer: the mip levels cannot be generated for this format");
+        uint8_t const * texels = static_cast<uint8_t const *>(src);
+        ImageData data{ info_, std::vector<uint8_t>(texels, texels + size), {} };
+        data.info.arrayLayers = 1;
+        generateMipChain(data);
+        staging = HostBuffer(device_, data.pixels.size(), vk::BufferUsageFlagBits::eTransferSrc, data.pixels.data());
+        regions = std::move(data.regions);
+    }
+    else
+    {
+        staging = HostBuffer(device_, size, vk::BufferUsageFlagBits::eTransferSrc, src);
+        regions.emplace_back(0,
+                             0,
+                             0,
+                             vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                             vk::Offset3D(0, 0, 0),
+                             info_.extent);
+    }
+    for (auto & region : regions)
+    {
+        region.imageSubresource.baseArrayLayer = layer;
+    }
+
+    executeOnceSynched(device_,
+                       commandPool,
+                       queue,
+                       [this, layer, &staging, &regions] (vk::CommandBuffer & commands) {
+                           // All of the layer's levels are replaced, so their contents can be discarded
+                           transitionLayout(commands,
+                                            vk::ImageLayout::eUndefined,
+                                            vk::ImageLayout::eTransferDstOptimal,
+                                            layer,
+                                            1);
+                           copy(commands, staging, regions);
+                           if (regions.size() < info_.mipLevels)
+                               generateMipmaps(commands, layer, 1);
+                           else
+                               transitionLayout(commands,
+                                                vk::ImageLayout::eTransferDstOptimal,
+                                                vk::ImageLayout::eShaderReadOnlyOptimal,
+                                                layer,
+                                                1);
+                       });
+}
+
+//! Only the texels in the rectangles are staged and uploaded, with a single copy command. Overlapping and adjacent rectangles
+//! are coalesced first. The image's other levels are not updated.
+//!
+//! @param  commandPool     Command buffer allocator
+//! @param  queue           Queue used to update the image
+//! @param  src             Tightly-packed texels of the whole level
+//! @param  rects           Rectangles to update, in the level's texel coordinates
+//! @param  level           Level to update (default: 0)
+//! @param  layer           Layer to update (default: 0)
+//!
+//! @warning    A std::invalid_argument is thrown if the level or layer does not exist, or if a rectangle is not inside the
+//!             level
+//! @note   The image must be in the eShaderReadOnlyOptimal layout, and the layer must not be in use by the GPU.
+void LocalImage::update(vk::CommandPool const &         commandPool,
+                        vk::Queue const &               queue,
+                        void const *                    src,
+                        std::vector<vk::Rect2D> const & rects,
+                        uint32_t                        level /*= 0*/,
+                        uint32_t                        layer /*= 0*/)
+{
+    std::vector<vk::Rect2D> coalesced = validatedRects(rects, level, layer);
+    if (coalesced.empty())
+        return;
+
+    // Pack the rectangles into the staging buffer. Each one starts on a texel and 4-byte boundary.
+    size_t texel      = texelSize(info_.format);
+    size_t alignment  = copyAlignment(info_.format);
+    size_t rowLength  = std::max(info_.extent.width >> level, 1u);
+    std::vector<size_t> offsets;
+    offsets.reserve(coalesced.size());
+    size_t size = 0;
+    for (auto const & rect : coalesced)
+    {
+        size = (size + alignment - 1) / alignment * alignment;
+        offsets.push_back(size);
+        size += size_t(rect.extent.width) * rect.extent.height * texel;
+    }
+
+    // The rows are written straight into the mapped staging buffer
+    HostBuffer staging(device_, size, vk::BufferUsageFlagBits::eTransferSrc);
+    uint8_t * packed = static_cast<uint8_t *>(staging.data());
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve(coalesced.size());
+    uint8_t const * texels = static_cast<uint8_t const *>(src);
+    for (size_t i = 0; i < coalesced.size(); ++i)
+    {
+        vk::Rect2D const & rect = coalesced[i];
+        size_t rowSize = rect.extent.width * texel;
+        copyRows(packed + offsets[i],
+                 rowSize,
+                 texels + (rect.offset.y * rowLength + rect.offset.x) * texel,
+                 rowLength * texel,
+                 rowSize,
+                 rect.extent.height);
+        regions.emplace_back(offsets[i],
+                             0,
+                             0,
+                             vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, layer, 1),
+                             vk::Offset3D(rect.offset.x, rect.offset.y, 0),
+                             vk::Extent3D(rect.extent.width, rect.extent.height, 1));
+    }
+
+    executeOnceSynched(device_,
+                       commandPool,
+                       queue,
+                       [this, layer, &staging, &regions] (vk::CommandBuffer & commands) {
+                           transitionLayout(commands,
+                                            vk::ImageLayout::eShaderReadOnlyOptimal,
+                                            vk::ImageLayout::eTransferDstOptimal,
+                                            layer,
+                                            1);
+                           copy(commands, staging, regions);
+                           transitionLayout(commands,
+                                            vk::ImageLayout::eTransferDstOptimal,
+                                            vk::ImageLayout::eShaderReadOnlyOptimal,
+                                            layer,
+                                            1);
+                       });
+}
+
+//! The buffer holds the whole level, so nothing is staged. Overlapping and adjacent rectangles are coalesced and then copied
+//! with a single command.
+//!
+//! @param  commands        Command buffer to record the copy in
+//! @param  buffer          Tightly-packed texels of the whole level
+//! @param  rects           Rectangles to update, in the level's texel coordinates
+//! @param  level           Level to update (default: 0)
+//! @param  layer           Layer to update (default: 0)
+//!
+//! @warning    A std::invalid_argument is thrown if the level or layer does not exist, or if a rectangle is not inside the
+//!             level
+//! @note   The image must be in the eTransferDstOptimal layout when the commands are executed.
+//! @note   If the queue supports neither graphics nor compute, each rectangle must start on a 4-byte boundary in the buffer.
+void LocalImage::update(vk::CommandBuffer &             commands,
+                        vk::Buffer const &              buffer,
+                        std::vector<vk::Rect2D> const & rects,
+                        uint32_t                        level /*= 0*/,
+                        uint32_t                        layer /*= 0*/)
+{
+    std::vector<vk::Rect2D> coalesced = validatedRects(rects, level, layer);
+    if (coalesced.empty())
+        return;
+
+    size_t   texel     = texelSize(info_.format);
+    uint32_t rowLength = std::max(info_.extent.width >> level, 1u);
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve(coalesced.size());
+    for (auto const & rect : coalesced)
+    {
+        regions.emplace_back((size_t(rect.offset.y) * rowLength + rect.offset.x) * texel,
+                             rowLength,
+                             0,
+                             vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, layer, 1),
+                             vk::Offset3D(rect.offset.x, rect.offset.y, 0),
+                             vk::Extent3D(rect.extent.width, rect.extent.height, 1));
+    }
+    copy(commands, buffer, regions);
+}
+
 //! @param  commandPool     Command buffer allocator
 //! @param  queue           Queue used to initialize the image
 //! @param  buffer          Image data
@@ -185,16 +632,39 @@ void LocalImage::copy(vk::CommandPool const & commandPool,
                        commandPool,
                        queue,
                        [this, &buffer] (vk::CommandBuffer & commands) {
-                           vk::BufferImageCopy region(0,
-                                                      0,
-                                                      0,
-                                                      vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
-                                                      { 0, 0, 0 },
-                                                      { info_.extent.width, info_.extent.height, 1 });
-                           commands.copyBufferToImage(buffer, *image_, vk::ImageLayout::eTransferDstOptimal, region);
+                           copy(commands, buffer);
                        });
 }
 
+//! Level 0 of every layer is copied. The layers are expected to be consecutive and tightly packed in the buffer.
+//!
+//! @param  commands        Command buffer to record the copy in
+//! @param  buffer          Image data
+//!
+//! @note   The image must be in the eTransferDstOptimal layout when the commands are executed.
+void LocalImage::copy(vk::CommandBuffer & commands, vk::Buffer const & buffer)
+{
+    vk::BufferImageCopy region(0,
+                               0,
+                               0,
+                               vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, info_.arrayLayers),
+                               { 0, 0, 0 },
+                               info_.extent);
+    commands.copyBufferToImage(buffer, *image_, vk::ImageLayout::eTransferDstOptimal, region);
+}
+
+//! @param  commands        Command buffer to record the copy in
+//! @param  buffer          Image data
+//! @param  regions         Regions of the buffer to copy and where they go in the image
+//!
+//! @note   The image must be in the eTransferDstOptimal layout when the commands are executed.
+void LocalImage::copy(vk::CommandBuffer &                      commands,
+                      vk::Buffer const &                       buffer,
+                      std::vector<vk::BufferImageCopy> const & regions)
+{
+    commands.copyBufferToImage(buffer, *image_, vk::ImageLayout::eTransferDstOptimal, regions);
+}
+
 //! @param  commandPool     Command buffer allocator
 //! @param  queue           Queue used to initialize the image
 //! @param  oldLayout       Current layout
@@ -204,6 +674,51 @@ void LocalImage::transitionLayout(vk::CommandPool const & commandPool,
                                   vk::ImageLayout         oldLayout,
                                   vk::ImageLayout         newLayout)
 {
+    executeOnceSynched(device_,
+                       commandPool,
+                       queue,
+                       [this, oldLayout, newLayout] (vk::CommandBuffer & commands) {
+                           transitionLayout(commands, oldLayout, newLayout);
+                       });
+}
+
+//! All of the image's layers and levels are transitioned.
+//!
+//! @param  commands        Command buffer to record the transition in
+//! @param  oldLayout       Current layout
+//! @param  newLayout       New layout
+//! @param  shaderStages    Stages that access the image in the eShaderReadOnlyOptimal layout (default: fragment shader)
+void LocalImage::transitionLayout(vk::CommandBuffer &    commands,
+                                  vk::ImageLayout        oldLayout,
+                                  vk::ImageLayout        newLayout,
+                                  vk::PipelineStageFlags shaderStages /*= vk::PipelineStageFlagBits::eFragmentShader*/)
+{
+    transitionLayout(commands, oldLayout, newLayout, 0, info_.arrayLayers, shaderStages);
+}
+
+//! All levels of the layers are transitioned.
+//!
+//! The shader stages are the destination of a transition to eShaderReadOnlyOptimal or eGeneral and the source of a transition
+//! from eShaderReadOnlyOptimal.
+//! They must be supported by the command buffer's queue. On a queue that supports neither graphics nor compute operations
+//! (a transfer-only queue), pass no stages: the barrier then only orders the transfers and changes the layout, and the
+//! fence or semaphore that hands the image to the queue that uses it makes the writes visible.
+//!
+//! @param  commands        Command buffer to record the transition in
+//! @param  oldLayout       Current layout
+//! @param  newLayout       New layout
+//! @param  baseLayer       First layer to transition
+//! @param  layerCount      Number of layers to transition
+//! @param  shaderStages    Stages that access the image in the eShaderReadOnlyOptimal layout (default: fragment shader)
+void LocalImage::transitionLayout(vk::CommandBuffer &    commands,
+                                  vk::ImageLayout        oldLayout,
+                                  vk::ImageLayout        newLayout,
+                                  uint32_t               baseLayer,
+                                  uint32_t               layerCount,
+                                  vk::PipelineStageFlags shaderStages /*= vk::PipelineStageFlagBits::eFragmentShader*/)
+{
+    bool shaders = bool(shaderStages);
+
     vk::AccessFlags        srcAccessMask;
     vk::AccessFlags        dstAccessMask;
     vk::PipelineStageFlags srcStage;
@@ -221,9 +736,27 @@ void LocalImage::transitionLayout(vk::CommandPool const & commandPool,
     else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
     {
         srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-        dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        dstAccessMask = shaders ? vk::AccessFlags(vk::AccessFlagBits::eShaderRead) : vk::AccessFlags();
         srcStage      = vk::PipelineStageFlagBits::eTransfer;
-        dstStage      = vk::PipelineStageFlagBits::eFragmentShader;
+        dstStage      = shaders ? shaderStages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eBottomOfPipe);
+        aspectMask    = vk::ImageAspectFlagBits::eColor;
+    }
+    else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::eGeneral)
+    {
+        // The image is both sampled and copied from, so the writes are made visible to transfers too
+        srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        dstAccessMask = shaders ? vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eShaderRead
+                                : vk::AccessFlags(vk::AccessFlagBits::eTransferRead);
+        srcStage      = vk::PipelineStageFlagBits::eTransfer;
+        dstStage      = vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTransfer) | shaderStages;
+        aspectMask    = vk::ImageAspectFlagBits::eColor;
+    }
+    else if (oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && newLayout == vk::ImageLayout::eTransferDstOptimal)
+    {
+        srcAccessMask = vk::AccessFlags();     // Reads need no availability operation
+        dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+        srcStage      = shaders ? shaderStages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe);
+        dstStage      = vk::PipelineStageFlagBits::eTransfer;
         aspectMask    = vk::ImageAspectFlagBits::eColor;
     }
     else if (oldLayout == vk::ImageLayout::eUndefined && newLayout == vk::ImageLayout::eDepthStencilAttachmentOptimal)
@@ -256,14 +789,9 @@ void LocalImage::transitionLayout(vk::CommandPool const & commandPool,
                                    VK_QUEUE_FAMILY_IGNORED,
                                    VK_QUEUE_FAMILY_IGNORED,
                                    *image_,
-                                   vk::ImageSubresourceRange(aspectMask, 0, info_.mipLevels, 0, 1));
+                                   vk::ImageSubresourceRange(aspectMask, 0, info_.mipLevels, baseLayer, layerCount));
 
-    executeOnceSynched(device_,
-                       commandPool,
-                       queue,
-                       [srcStage, dstStage, &barrier] (vk::CommandBuffer & commands) {
-                           commands.pipelineBarrier(srcStage, dstStage, {}, nullptr, nullptr, barrier);
-                       });
+    commands.pipelineBarrier(srcStage, dstStage, {}, nullptr, nullptr, barrier);
 }
 
 //! @param  commandPool         Command buffer allocator
@@ -271,93 +799,182 @@ void LocalImage::transitionLayout(vk::CommandPool const & commandPool,
 void LocalImage::generateMipmaps(vk::CommandPool const & commandPool,
                                  vk::Queue const &       queue)
 {
-    // Check if image format supports blitting with linear filtering
-    vk::FormatProperties formatProperties = device_->physical()->getFormatProperties(info_.format);
-    if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
-        throw std::runtime_error("texture image format does not support linear blitting!");
     executeOnceSynched(device_,
                        commandPool,
                        queue,
                        [this] (vk::CommandBuffer & commands) {
-                           vk::ImageMemoryBarrier barrier(vk::AccessFlags(),
-                                                          vk::AccessFlags(),
-                                                          vk::ImageLayout::eUndefined,
-                                                          vk::ImageLayout::eUndefined,
-                                                          VK_QUEUE_FAMILY_IGNORED,
-                                                          VK_QUEUE_FAMILY_IGNORED,
-                                                          *image_,
-                                                          vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
-
-                           int32_t mipWidth  = info_.extent.width;
-                           int32_t mipHeight = info_.extent.height;
-
-                           for (uint32_t i = 1; i < info_.mipLevels; i++)
-                           {
-                               int32_t previousWidth  = mipWidth;
-                               int32_t previousHeight = mipHeight;
-
-                               if (mipWidth > 1)
-                                   mipWidth /= 2;
-                               if (mipHeight > 1)
-                                   mipHeight /= 2;
-
-                               // Transition the layout for the previous mip level to transfer src
-                               barrier.subresourceRange.setBaseMipLevel(i - 1);
-                               barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-                               barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
-                               barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-                               barrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
-
-                               commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                                        vk::PipelineStageFlagBits::eTransfer,
-                                                        {},
-                                                        nullptr,
-                                                        nullptr,
-                                                        barrier);
-
-                               // Blit the previous mip level to the current mip level
-                               commands.blitImage(*image_,
-                                                  vk::ImageLayout::eTransferSrcOptimal,
-                                                  *image_,
-                                                  vk::ImageLayout::eTransferDstOptimal,
-                                                  vk::ImageBlit(
-                                                      vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i - 1, 0, 1),
-                                                      {{{ 0, 0, 0 }, { previousWidth, previousHeight, 1 } } },
-                                                      vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, 0, 1),
-                                                      {{{ 0, 0, 0 }, { mipWidth, mipHeight, 1 } } }),
-                                                  vk::Filter::eLinear);
-                           }
-
-                           // Transition the final mip level to transfer src so that all levels can be transitioned to shader
-                           // read-only in one shot
-                           barrier.subresourceRange.setBaseMipLevel(info_.mipLevels - 1);
-                           barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-                           barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
-                           barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
-                           barrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
-                           commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                                    vk::PipelineStageFlagBits::eTransfer,
-                                                    {},
-                                                    nullptr,
-                                                    nullptr,
-                                                    barrier);
-
-                           // Transition all mip levels to shader read-only
-                           barrier.subresourceRange.setBaseMipLevel(0);
-                           barrier.subresourceRange.setLevelCount(info_.mipLevels);
-                           barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
-                           barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-                           barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferRead);
-                           barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
-                           commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
-                                                    vk::PipelineStageFlagBits::eFragmentShader,
-                                                    {},
-                                                    nullptr,
-                                                    nullptr,
-                                                    barrier);
+                           generateMipmaps(commands);
                        });
 }
 
+//! Mip level 0 is expected to be in the eTransferDstOptimal layout when the commands are executed. All levels are in the
+//! eShaderReadOnlyOptimal layout afterwards.
+//!
+//! If a mip generator has been set, the image is a single-layer 2D image with eStorage usage, and the generator supports its
+//! format, the levels are generated by its compute shader, and the resources it uses are kept by the image until the next
+//! call. Otherwise, they are generated by a chain of blits.
+//!
+//! @param  commands            Command buffer to record the commands in. Its queue must support graphics operations, or
+//!                             compute operations if a mip generator is used.
+//! @param  shaderStages        Stages that read the image afterwards. They must be supported by the command buffer's queue.
+//!                             (default: fragment shader)
+//!
+//! @warning    A std::runtime_error is thrown if the image's format does not support linear filtering
+void LocalImage::generateMipmaps(vk::CommandBuffer &    commands,
+                                 vk::PipelineStageFlags shaderStages /*= vk::PipelineStageFlagBits::eFragmentShader*/)
+{
+    if (usesMipGenerator())
+    {
+        mipDispatch_ = mipGenerator_->record(commands, *this, shaderStages);
+        return;
+    }
+
+    generateMipmaps(commands, 0, info_.arrayLayers, shaderStages);
+}
+
+//! The mipmaps of the layers are generated by a chain of blits. Level 0 of the layers is expected to be in the
+//! eTransferDstOptimal layout when the commands are executed. All levels of the layers are in the eShaderReadOnlyOptimal
+//! layout afterwards. For a 3D image, the depth is halved along with the width and height.
+//!
+//! @param  commands            Command buffer to record the commands in. Its queue must support graphics operations.
+//! @param  baseLayer           First layer
+//! @param  layerCount          Number of layers
+//! @param  shaderStages        Stages that read the image afterwards (default: fragment shader)
+//!
+//! @warning    A std::runtime_error is thrown if the image's format does not support linear filtering
+void LocalImage::generateMipmaps(vk::CommandBuffer &    commands,
+                                 uint32_t               baseLayer,
+                                 uint32_t               layerCount,
+                                 vk::PipelineStageFlags shaderStages /*= vk::PipelineStageFlagBits::eFragmentShader*/)
+{
+    // Check if image format supports blitting with linear filtering
+    if (!canBlitMipmaps())
+        throw std::runtime_error("texture image format does not support linear blitting!");
+
+    vk::ImageMemoryBarrier barrier(vk::AccessFlags(),
+                                   vk::AccessFlags(),
+                                   vk::ImageLayout::eUndefined,
+                                   vk::ImageLayout::eUndefined,
+                                   VK_QUEUE_FAMILY_IGNORED,
+                                   VK_QUEUE_FAMILY_IGNORED,
+                                   *image_,
+                                   vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, baseLayer, layerCount));
+
+    int32_t mipWidth  = info_.extent.width;
+    int32_t mipHeight = info_.extent.height;
+    int32_t mipDepth  = info_.extent.depth;
+
+    for (uint32_t i = 1; i < info_.mipLevels; i++)
+    {
+        int32_t previousWidth  = mipWidth;
+        int32_t previousHeight = mipHeight;
+        int32_t previousDepth  = mipDepth;
+
+        if (mipWidth > 1)
+            mipWidth /= 2;
+        if (mipHeight > 1)
+            mipHeight /= 2;
+        if (mipDepth > 1)
+            mipDepth /= 2;
+
+        // Transition the layout for the previous mip level to transfer src
+        barrier.subresourceRange.setBaseMipLevel(i - 1);
+        barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        barrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+
+        commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eTransfer,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 barrier);
+
+        // Blit the previous mip level to the current mip level
+        commands.blitImage(*image_,
+                           vk::ImageLayout::eTransferSrcOptimal,
+                           *image_,
+                           vk::ImageLayout::eTransferDstOptimal,
+                           vk::ImageBlit(
+                               vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i - 1, baseLayer, layerCount),
+                               {{{ 0, 0, 0 }, { previousWidth, previousHeight, previousDepth } } },
+                               vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, baseLayer, layerCount),
+                               {{{ 0, 0, 0 }, { mipWidth, mipHeight, mipDepth } } }),
+                           vk::Filter::eLinear);
+    }
+
+    // Transition the final mip level to transfer src so that all levels can be transitioned to shader
+    // read-only in one shot
+    barrier.subresourceRange.setBaseMipLevel(info_.mipLevels - 1);
+    barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+    barrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    barrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+    commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                             vk::PipelineStageFlagBits::eTransfer,
+                             {},
+                             nullptr,
+                             nullptr,
+                             barrier);
+
+    // Transition all mip levels to shader read-only
+    barrier.subresourceRange.setBaseMipLevel(0);
+    barrier.subresourceRange.setLevelCount(info_.mipLevels);
+    barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
+    barrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferRead);
+    barrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                             shaderStages,
+                             {},
+                             nullptr,
+                             nullptr,
+                             barrier);
+}
+
+//! @return true if the image's format supports linear filtering, which generateMipmaps() requires
+bool LocalImage::canBlitMipmaps() const
+{
+    vk::FormatProperties formatProperties = device_->physical()->getFormatProperties(info_.format);
+    return bool(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear);
+}
+
+// Checks the arguments of update() and returns the coalesced rectangles
+std::vector<vk::Rect2D> LocalImage::validatedRects(std::vector<vk::Rect2D> const & rects,
+                                                   uint32_t                        level,
+                                                   uint32_t                        layer) const
+{
+    if (level >= info_.mipLevels || layer >= info_.arrayLayers)
+        throw std::invalid_argument("Vkx::LocalImage::update: the level or layer does not exist");
+
+    uint32_t width  = std::max(info_.extent.width >> level, 1u);
+    uint32_t height = std::max(info_.extent.height >> level, 1u);
+    for (auto const & rect : rects)
+    {
+        if (rect.offset.x < 0 || rect.offset.y < 0 ||
+            rect.offset.x + rect.extent.width > width || rect.offset.y + rect.extent.height > height)
+        {
+            throw std::invalid_argument("Vkx::LocalImage::update: a rectangle is not inside the level");
+        }
+    }
+    return coalesceRects(rects);
+}
+
+// Returns true if generateMipmaps() uses the mip generator, which requires a single-layer 2D storage image in a format that
+// the generator supports
+bool LocalImage::usesMipGenerator() const
+{
+    return mipGenerator_ && info_.imageType == vk::ImageType::e2D && info_.arrayLayers == 1 &&
+           (info_.usage & vk::ImageUsageFlagBits::eStorage) && mipGenerator_->supports(info_.format);
+}
+
+// Returns true if generateMipmaps() can generate the image's mipmaps, either with the mip generator or by blitting
+bool LocalImage::gpuCanGenerateMipmaps() const
+{
+    return usesMipGenerator() || canBlitMipmaps();
+}
+
 //! @param  device              Logical device associated with the image
 //! @param  commandPool         Command buffer allocator
 //! @param  queue               Queue used to initialize the image
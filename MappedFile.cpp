@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vkx
+{
+//! @param  path    Path to the file
+//!
+//! @warning    A std::runtime_error is thrown if the file cannot be opened or mapped
+MappedFile::MappedFile(std::string const & path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Vkx::MappedFile::MappedFile: failed to open " + path);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        throw std::runtime_error("Vkx::MappedFile::MappedFile: failed to get the size of " + path);
+    }
+    size_ = (size_t)size.QuadPart;
+
+    if (size_ > 0)
+    {
+        // The view keeps the file and the mapping open after their handles are closed
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            data_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        throw std::runtime_error("Vkx::MappedFile::MappedFile: failed to open " + path);
+
+    struct stat status;
+    if (fstat(file, &status) != 0)
+    {
+        close(file);
+        throw std::runtime_error("Vkx::MappedFile::MappedFile: failed to get the size of " + path);
+    }
+    size_ = (size_t)status.st_size;
+
+    if (size_ > 0)
+    {
+        // The mapping keeps the file open after it is closed
+        void * mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped != MAP_FAILED)
+            data_ = mapped;
+    }
+    close(file);
+#endif
+
+    if (size_ > 0 && !data_)
+        throw std::runtime_error("Vkx::MappedFile::MappedFile: failed to map " + path);
+}
+
+//! @param  src     Move source
+MappedFile::MappedFile(MappedFile && src)
+    : data_(src.data_)
+    , size_(src.size_)
+{
+    src.data_ = nullptr;
+    src.size_ = 0;
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+//! @param  rhs     Move source
+MappedFile & MappedFile::operator =(MappedFile && rhs)
+{
+    if (this != &rhs)
+    {
+        unmap();
+        data_     = rhs.data_;
+        size_     = rhs.size_;
+        rhs.data_ = nullptr;
+        rhs.size_ = 0;
+    }
+    return *this;
+}
+
+void MappedFile::unmap()
+{
+    if (data_)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<void *>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+} // namespace Vkx
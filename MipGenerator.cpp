@@ -0,0 +1,783 @@
+#include "MipGenerator.h"
+
+#include "Image.h"
+#include "PixelCopy.h"
+#include "ThreadPool.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define VKX_MIPGENERATOR_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define VKX_MIPGENERATOR_TARGET(isa)
+#else
+#include <cpuid.h>
+#define VKX_MIPGENERATOR_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VKX_MIPGENERATOR_NEON
+#endif
+
+namespace
+{
+// How the channels of a format are encoded
+enum class Encoding
+{
+    eUnorm8,
+    eUnorm16,
+    eHalf,
+    eFloat
+};
+
+// How texels of a format are stored
+struct Layout
+{
+    uint32_t channels;  // Number of channels
+    Encoding encoding;
+    bool isSrgb;        // Color channels (not alpha) are sRGB-encoded
+
+    size_t channelSize() const
+    {
+        return (encoding == Encoding::eUnorm8) ? 1 : (encoding == Encoding::eFloat) ? sizeof(float) : sizeof(uint16_t);
+    }
+    size_t texelSize() const { return channels * channelSize(); }
+};
+
+bool describe(vk::Format format, Layout & layout)
+{
+    switch (format)
+    {
+        case vk::Format::eR8Unorm:              layout = { 1, Encoding::eUnorm8, false }; return true;
+        case vk::Format::eR8Srgb:               layout = { 1, Encoding::eUnorm8, true }; return true;
+        case vk::Format::eR8G8Unorm:            layout = { 2, Encoding::eUnorm8, false }; return true;
+        case vk::Format::eR8G8Srgb:             layout = { 2, Encoding::eUnorm8, true }; return true;
+        case vk::Format::eR8G8B8Unorm:          layout = { 3, Encoding::eUnorm8, false }; return true;
+        case vk::Format::eR8G8B8Srgb:           layout = { 3, Encoding::eUnorm8, true }; return true;
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eB8G8R8A8Unorm:        layout = { 4, Encoding::eUnorm8, false }; return true;
+        case vk::Format::eR8G8B8A8Srgb:
+        case vk::Format::eB8G8R8A8Srgb:         layout = { 4, Encoding::eUnorm8, true }; return true;
+        case vk::Format::eR16Unorm:             layout = { 1, Encoding::eUnorm16, false }; return true;
+        case vk::Format::eR16G16Unorm:          layout = { 2, Encoding::eUnorm16, false }; return true;
+        case vk::Format::eR16G16B16A16Unorm:    layout = { 4, Encoding::eUnorm16, false }; return true;
+        case vk::Format::eR16Sfloat:            layout = { 1, Encoding::eHalf, false }; return true;
+        case vk::Format::eR16G16Sfloat:         layout = { 2, Encoding::eHalf, false }; return true;
+        case vk::Format::eR16G16B16A16Sfloat:   layout = { 4, Encoding::eHalf, false }; return true;
+        case vk::Format::eR32Sfloat:            layout = { 1, Encoding::eFloat, false }; return true;
+        case vk::Format::eR32G32Sfloat:         layout = { 2, Encoding::eFloat, false }; return true;
+        case vk::Format::eR32G32B32A32Sfloat:   layout = { 4, Encoding::eFloat, false }; return true;
+        default:                                return false;
+    }
+}
+
+// Formats of 32-bit and 16-bit float texels with a number of channels (1, 2 or 4), for convertRows()
+vk::Format floatFormat(uint32_t channels)
+{
+    return (channels == 1) ? vk::Format::eR32Sfloat : (channels == 2) ? vk::Format::eR32G32Sfloat
+                                                                      : vk::Format::eR32G32B32A32Sfloat;
+}
+
+vk::Format halfFormat(uint32_t channels)
+{
+    return (channels == 1) ? vk::Format::eR16Sfloat : (channels == 2) ? vk::Format::eR16G16Sfloat
+                                                                      : vk::Format::eR16G16B16A16Sfloat;
+}
+
+float halfToFloat(uint16_t half)
+{
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    float magnitude;
+    if (exponent == 0)
+        magnitude = std::ldexp((float)mantissa, -24);
+    else if (exponent == 31)
+        magnitude = mantissa ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+    else
+        magnitude = std::ldexp((float)(mantissa | 0x400), (int)exponent - 25);
+    return (half & 0x8000) ? -magnitude : magnitude;
+}
+
+// Conversions between sRGB-encoded bytes and linear values
+class SrgbTables
+{
+public:
+    static int constexpr ENCODE_SIZE = 16384;
+
+    static SrgbTables const & get()
+    {
+        static SrgbTables const tables;
+        return tables;
+    }
+
+    float decode(uint8_t value) const { return toLinear_[value]; }
+
+    uint8_t encode(float value) const
+    {
+        value = std::min(std::max(value, 0.0f), 1.0f);
+        return fromLinear_[(int)(value * (ENCODE_SIZE - 1) + 0.5f)];
+    }
+
+private:
+    SrgbTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            toLinear_[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < ENCODE_SIZE; ++i)
+        {
+            float l = i / float(ENCODE_SIZE - 1);
+            float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            fromLinear_[i] = (uint8_t)(c * 255.0f + 0.5f);
+        }
+    }
+
+    float toLinear_[256];
+    uint8_t fromLinear_[ENCODE_SIZE];
+};
+
+// A texel of the working format, which always has 4 float channels
+#if defined(VKX_MIPGENERATOR_SSE2)
+using Vec4 = __m128;
+inline Vec4 load4(float const * p)                  { return _mm_loadu_ps(p); }
+inline void store4(float * p, Vec4 v)               { _mm_storeu_ps(p, v); }
+inline Vec4 zero4()                                 { return _mm_setzero_ps(); }
+inline Vec4 add4(Vec4 a, Vec4 b)                    { return _mm_add_ps(a, b); }
+inline Vec4 scale4(Vec4 a, float s)                 { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+inline Vec4 madd4(Vec4 acc, Vec4 a, float s)        { return _mm_add_ps(acc, _mm_mul_ps(a, _mm_set1_ps(s))); }
+#elif defined(VKX_MIPGENERATOR_NEON)
+using Vec4 = float32x4_t;
+inline Vec4 load4(float const * p)                  { return vld1q_f32(p); }
+inline void store4(float * p, Vec4 v)               { vst1q_f32(p, v); }
+inline Vec4 zero4()                                 { return vdupq_n_f32(0.0f); }
+inline Vec4 add4(Vec4 a, Vec4 b)                    { return vaddq_f32(a, b); }
+inline Vec4 scale4(Vec4 a, float s)                 { return vmulq_n_f32(a, s); }
+inline Vec4 madd4(Vec4 acc, Vec4 a, float s)        { return vmlaq_n_f32(acc, a, s); }
+#else
+struct Vec4 { float v[4]; };
+inline Vec4 load4(float const * p)                  { return { { p[0], p[1], p[2], p[3] } }; }
+inline void store4(float * p, Vec4 a)               { std::copy(a.v, a.v + 4, p); }
+inline Vec4 zero4()                                 { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+inline Vec4 add4(Vec4 a, Vec4 b)                    { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+inline Vec4 scale4(Vec4 a, float s)                 { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+inline Vec4 madd4(Vec4 acc, Vec4 a, float s)        { return add4(acc, scale4(a, s)); }
+#endif
+
+// A level in the working format
+struct Plane
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<float> texels;
+
+    float * row(uint32_t y) { return texels.data() + size_t(y) * width * 4; }
+    float const * row(uint32_t y) const { return texels.data() + size_t(y) * width * 4; }
+};
+
+// Calls body for ranges of [0, count), in parallel if there are workers
+void forRows(Vkx::ThreadPool * workers, size_t count, std::function<void(size_t, size_t)> const & body)
+{
+    if (workers)
+        workers->parallelFor(count, body);
+    else
+        body(0, count);
+}
+
+Plane decode(uint8_t const * src, uint32_t width, uint32_t height, Layout const & layout, Vkx::ThreadPool * workers)
+{
+    Plane plane{ width, height, std::vector<float>(size_t(width) * height * 4, 0.0f) };
+    size_t rowSize = width * layout.texelSize();
+    uint32_t nColors = layout.isSrgb ? std::min(layout.channels, 3u) : 0;
+    SrgbTables const & srgb = SrgbTables::get();
+
+    forRows(workers, height, [&] (size_t y0, size_t y1) {
+                for (size_t y = y0; y < y1; ++y)
+                {
+                    float * out = plane.row((uint32_t)y);
+                    if (layout.encoding == Encoding::eFloat)
+                    {
+                        float const * in = reinterpret_cast<float const *>(src + y * rowSize);
+                        for (uint32_t x = 0; x < width; ++x)
+                        {
+                            std::copy(in + x * layout.channels, in + (x + 1) * layout.channels, out + x * 4);
+                        }
+                    }
+                    else if (layout.encoding != Encoding::eUnorm8)
+                    {
+                        uint8_t const * in = src + y * rowSize;
+                        for (uint32_t x = 0; x < width; ++x)
+                        {
+                            for (uint32_t c = 0; c < layout.channels; ++c)
+                            {
+                                uint16_t value;
+                                memcpy(&value, in + (x * layout.channels + c) * sizeof(value), sizeof(value));
+                                out[x * 4 + c] = (layout.encoding == Encoding::eHalf) ? halfToFloat(value)
+                                                                                      : value / 65535.0f;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        uint8_t const * in = src + y * rowSize;
+                        for (uint32_t x = 0; x < width; ++x)
+                        {
+                            for (uint32_t c = 0; c < layout.channels; ++c)
+                            {
+                                uint8_t value = in[x * layout.channels + c];
+                                out[x * 4 + c] = (c < nColors) ? srgb.decode(value) : value / 255.0f;
+                            }
+                        }
+                    }
+                }
+            });
+    return plane;
+}
+
+void encode(Plane const & plane, Layout const & layout, uint8_t * dst, Vkx::ThreadPool * workers)
+{
+    size_t rowSize = plane.width * layout.texelSize();
+    uint32_t nColors = layout.isSrgb ? std::min(layout.channels, 3u) : 0;
+    SrgbTables const & srgb = SrgbTables::get();
+
+    forRows(workers, plane.height, [&] (size_t y0, size_t y1) {
+                std::vector<float> packed;  // A row of halfs before conversion
+                for (size_t y = y0; y < y1; ++y)
+                {
+                    float const * in = plane.row((uint32_t)y);
+                    if (layout.encoding == Encoding::eFloat || layout.encoding == Encoding::eHalf)
+                    {
+                        float * out = reinterpret_cast<float *>(dst + y * rowSize);
+                        if (layout.encoding == Encoding::eHalf)
+                        {
+                            packed.resize(size_t(plane.width) * layout.channels);
+                            out = packed.data();
+                        }
+                        for (uint32_t x = 0; x < plane.width; ++x)
+                        {
+                            std::copy(in + x * 4, in + x * 4 + layout.channels, out + x * layout.channels);
+                        }
+                        if (layout.encoding == Encoding::eHalf)
+                        {
+                            Vkx::convertRows(dst + y * rowSize,
+                                             rowSize,
+                                             halfFormat(layout.channels),
+                                             packed.data(),
+                                             packed.size() * sizeof(float),
+                                             floatFormat(layout.channels),
+                                             plane.width,
+                                             1);
+                        }
+                    }
+                    else if (layout.encoding == Encoding::eUnorm16)
+                    {
+                        uint8_t * out = dst + y * rowSize;
+                        for (uint32_t x = 0; x < plane.width; ++x)
+                        {
+                            for (uint32_t c = 0; c < layout.channels; ++c)
+                            {
+                                float    value   = std::min(std::max(in[x * 4 + c], 0.0f), 1.0f);
+                                uint16_t encoded = (uint16_t)(value * 65535.0f + 0.5f);
+                                memcpy(out + (x * layout.channels + c) * sizeof(encoded), &encoded, sizeof(encoded));
+                            }
+                        }
+                    }
+                    else
+                    {
+                        uint8_t * out = dst + y * rowSize;
+                        for (uint32_t x = 0; x < plane.width; ++x)
+                        {
+                            for (uint32_t c = 0; c < layout.channels; ++c)
+                            {
+                                float value = in[x * 4 + c];
+                                out[x * layout.channels + c] = (c < nColors)
+                                                               ? srgb.encode(value)
+                                                               : (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+                            }
+                        }
+                    }
+                }
+            });
+}
+
+// Box-filters a level in the working format. A dimension of size 1 is not filtered.
+Plane boxFilter(Plane const & src, Vkx::ThreadPool * workers)
+{
+    Plane dst{ std::max(src.width / 2, 1u), std::max(src.height / 2, 1u), {} };
+    dst.texels.resize(size_t(dst.width) * dst.height * 4);
+
+    forRows(workers, dst.height, [&] (size_t y0, size_t y1) {
+                for (size_t y = y0; y < y1; ++y)
+                {
+                    float const * row0 = src.row(std::min(uint32_t(y * 2), src.height - 1));
+                    float const * row1 = src.row(std::min(uint32_t(y * 2 + 1), src.height - 1));
+                    float * out = dst.row((uint32_t)y);
+                    for (uint32_t x = 0; x < dst.width; ++x)
+                    {
+                        uint32_t x0 = std::min(x * 2, src.width - 1) * 4;
+                        uint32_t x1 = std::min(x * 2 + 1, src.width - 1) * 4;
+                        Vec4 sum = add4(add4(load4(row0 + x0), load4(row0 + x1)), add4(load4(row1 + x0), load4(row1 + x1)));
+                        store4(out + x * 4, scale4(sum, 0.25f));
+                    }
+                }
+            });
+    return dst;
+}
+
+// Averages two levels of the same size, such as two filtered slices of a 3D image
+Plane average(Plane a, Plane const & b)
+{
+    for (size_t i = 0; i < a.texels.size(); i += 4)
+    {
+        store4(&a.texels[i], scale4(add4(load4(&a.texels[i]), load4(&b.texels[i])), 0.5f));
+    }
+    return a;
+}
+
+// Source texels and weights contributing to one destination texel along an axis
+struct Tap
+{
+    uint32_t index;
+    float weight;
+};
+
+float besselI0(float x)
+{
+    float sum  = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+    {
+        term *= (x * x) / (4.0f * k * k);
+        sum  += term;
+    }
+    return sum;
+}
+
+// Builds the taps of a Kaiser-windowed sinc filter for each destination texel along an axis
+std::vector<std::vector<Tap>> kaiserTaps(uint32_t srcSize, uint32_t dstSize)
+{
+    static float constexpr RADIUS = 3.0f;   // Support, in destination texels
+    static float constexpr ALPHA  = 4.0f;   // Window shape
+    static float constexpr PI     = 3.14159265358979f;
+
+    std::vector<std::vector<Tap>> taps(dstSize);
+    if (srcSize == dstSize)
+    {
+        for (uint32_t i = 0; i < dstSize; ++i)
+        {
+            taps[i].push_back({ i, 1.0f });
+        }
+        return taps;
+    }
+
+    float scale = float(srcSize) / float(dstSize);
+    float i0Alpha = besselI0(ALPHA);
+    for (uint32_t i = 0; i < dstSize; ++i)
+    {
+        float center = (i + 0.5f) * scale;
+        int first = (int)std::floor(center - RADIUS * scale);
+        int last  = (int)std::ceil(center + RADIUS * scale);
+        float total = 0.0f;
+        for (int j = first; j <= last; ++j)
+        {
+            float t = ((j + 0.5f) - center) / scale;
+            if (std::abs(t) >= RADIUS)
+                continue;
+            float sinc   = (t == 0.0f) ? 1.0f : std::sin(PI * t) / (PI * t);
+            float r      = t / RADIUS;
+            float window = besselI0(ALPHA * std::sqrt(1.0f - r * r)) / i0Alpha;
+            float weight = sinc * window;
+
+            // Texels beyond the edges are clamped, so their weights are added to the edge texels
+            uint32_t index = (uint32_t)std::min(std::max(j, 0), (int)srcSize - 1);
+            auto tap = std::find_if(taps[i].begin(), taps[i].end(), [index] (Tap const & t) { return t.index == index; });
+            if (tap != taps[i].end())
+                tap->weight += weight;
+            else
+                taps[i].push_back({ index, weight });
+            total += weight;
+        }
+        for (auto & tap : taps[i])
+        {
+            tap.weight /= total;
+        }
+    }
+    return taps;
+}
+
+// Kaiser-filters a level in the working format, horizontally and then vertically
+Plane kaiserFilter(Plane const & src, Vkx::ThreadPool * workers)
+{
+    uint32_t dstWidth  = std::max(src.width / 2, 1u);
+    uint32_t dstHeight = std::max(src.height / 2, 1u);
+    std::vector<std::vector<Tap>> columns = kaiserTaps(src.width, dstWidth);
+    std::vector<std::vector<Tap>> rows    = kaiserTaps(src.height, dstHeight);
+
+    Plane horizontal{ dstWidth, src.height, std::vector<float>(size_t(dstWidth) * src.height * 4) };
+    forRows(workers, src.height, [&] (size_t y0, size_t y1) {
+                for (size_t y = y0; y < y1; ++y)
+                {
+                    float const * in = src.row((uint32_t)y);
+                    float * out = horizontal.row((uint32_t)y);
+                    for (uint32_t x = 0; x < dstWidth; ++x)
+                    {
+                        Vec4 sum = zero4();
+                        for (auto const & tap : columns[x])
+                        {
+                            sum = madd4(sum, load4(in + tap.index * 4), tap.weight);
+                        }
+                        store4(out + x * 4, sum);
+                    }
+                }
+            });
+
+    Plane dst{ dstWidth, dstHeight, std::vector<float>(size_t(dstWidth) * dstHeight * 4) };
+    forRows(workers, dstHeight, [&] (size_t y0, size_t y1) {
+                for (size_t y = y0; y < y1; ++y)
+                {
+                    float * out = dst.row((uint32_t)y);
+                    for (uint32_t x = 0; x < dstWidth; ++x)
+                    {
+                        Vec4 sum = zero4();
+                        for (auto const & tap : rows[y])
+                        {
+                            sum = madd4(sum, load4(horizontal.row(tap.index) + x * 4), tap.weight);
+                        }
+                        store4(out + x * 4, sum);
+                    }
+                }
+            });
+    return dst;
+}
+
+#if defined(VKX_MIPGENERATOR_SSE2)
+// Returns true if the CPU and OS support AVX2. The AVX2 kernel is compiled for it individually, so it is chosen at run time
+// regardless of the compiler's target flags.
+bool detectAvx2()
+{
+    unsigned registers[4];
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int *>(registers), 0, 0);
+#else
+    __cpuid_count(0, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    if (registers[0] < 7)
+        return false;
+
+    // AVX registers are only usable if the OS saves them (OSXSAVE, and XCR0 enables the SSE and AVX state)
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int *>(registers), 1, 0);
+#else
+    __cpuid_count(1, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    if (!(registers[2] & (1u << 28)) || !(registers[2] & (1u << 27)))
+        return false;
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned low;
+    unsigned high;
+    __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long)high << 32) | low;
+#endif
+    if ((xcr0 & 6) != 6)
+        return false;
+
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int *>(registers), 7, 0);
+#else
+    __cpuid_count(7, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    return (registers[1] & (1u << 5)) != 0;
+}
+
+bool hasAvx2()
+{
+    static bool const avx2 = detectAvx2();
+    return avx2;
+}
+
+// Averages 2x2 blocks of 8-bit RGBA texels in a pair of rows with AVX2, 4 output texels at a time. Returns the number of
+// texels written.
+VKX_MIPGENERATOR_TARGET("avx2")
+uint32_t boxRowRgba8Avx2(uint8_t const * row0, uint8_t const * row1, uint8_t * dst, uint32_t dstWidth)
+{
+    uint32_t x = 0;
+    for (; x + 4 <= dstWidth; x += 4)
+    {
+        __m128i const * a = reinterpret_cast<__m128i const *>(row0 + x * 8);
+        __m128i const * b = reinterpret_cast<__m128i const *>(row1 + x * 8);
+        __m256i s0 = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(a)), _mm256_cvtepu8_epi16(_mm_loadu_si128(b)));
+        __m256i s1 = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(a + 1)), _mm256_cvtepu8_epi16(_mm_loadu_si128(b + 1)));
+        s0 = _mm256_add_epi16(s0, _mm256_srli_si256(s0, 8));  // Texels 0+1 | 2+3
+        s1 = _mm256_add_epi16(s1, _mm256_srli_si256(s1, 8));  // Texels 4+5 | 6+7
+        __m256i sum = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(s0, s1), _MM_SHUFFLE(3, 1, 2, 0));
+        sum = _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+        __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), packed);
+    }
+    return x;
+}
+#endif
+
+// Averages 2x2 blocks of 8-bit RGBA texels in a pair of rows with SIMD. Returns the number of texels written.
+uint32_t boxRowRgba8(uint8_t const * row0, uint8_t const * row1, uint8_t * dst, uint32_t dstWidth)
+{
+    uint32_t x = 0;
+#if defined(VKX_MIPGENERATOR_SSE2)
+    if (hasAvx2())
+        x = boxRowRgba8Avx2(row0, row1, dst, dstWidth);
+
+    __m128i const zero = _mm_setzero_si128();
+    for (; x + 2 <= dstWidth; x += 2)
+    {
+        __m128i a  = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row0 + x * 8));
+        __m128i b  = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row1 + x * 8));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));   // Texels 0, 1
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));   // Texels 2, 3
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_set1_epi16(2)), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x * 4), _mm_packus_epi16(sum, sum));
+    }
+#elif defined(VKX_MIPGENERATOR_NEON)
+    for (; x + 2 <= dstWidth; x += 2)
+    {
+        uint8x16_t a  = vld1q_u8(row0 + x * 8);
+        uint8x16_t b  = vld1q_u8(row1 + x * 8);
+        uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));     // Texels 0, 1
+        uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));   // Texels 2, 3
+        uint16x8_t sum = vcombine_u16(vadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+                                      vadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+        vst1_u8(dst + x * 4, vrshrn_n_u16(sum, 2));
+    }
+#endif
+    return x;
+}
+
+// Box-filters a level of linear 8-bit texels directly, without converting to the working format
+void boxFilter8(uint8_t const * src,
+                uint32_t        srcWidth,
+                uint32_t        srcHeight,
+                uint32_t        channels,
+                uint8_t *       dst,
+                Vkx::ThreadPool * workers)
+{
+    uint32_t dstWidth  = std::max(srcWidth / 2, 1u);
+    uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+    size_t srcRowSize  = size_t(srcWidth) * channels;
+    size_t dstRowSize  = size_t(dstWidth) * channels;
+
+    forRows(workers, dstHeight, [&] (size_t y0, size_t y1) {
+                for (size_t y = y0; y < y1; ++y)
+                {
+                    uint8_t const * row0 = src + std::min(uint32_t(y * 2), srcHeight - 1) * srcRowSize;
+                    uint8_t const * row1 = src + std::min(uint32_t(y * 2 + 1), srcHeight - 1) * srcRowSize;
+                    uint8_t * out = dst + y * dstRowSize;
+
+                    // A source row of width 1 is shorter than the SIMD loop expects
+                    uint32_t x = (channels == 4 && srcWidth > 1) ? boxRowRgba8(row0, row1, out, dstWidth) : 0;
+                    for (; x < dstWidth; ++x)
+                    {
+                        uint32_t x0 = std::min(x * 2, srcWidth - 1) * channels;
+                        uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * channels;
+                        for (uint32_t c = 0; c < channels; ++c)
+                        {
+                            unsigned sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                            out[x * channels + c] = (uint8_t)((sum + 2) >> 2);
+                        }
+                    }
+                }
+            });
+}
+
+// Gathers level 0 of every layer from the regions that provide it into tightly-packed texels, one layer (or slice)
+// after another
+std::vector<uint8_t> packLevel0(Vkx::ImageData const & data, size_t texelSize, uint32_t depth)
+{
+    vk::Extent3D const & extent = data.info.extent;
+    std::vector<uint8_t> packed(size_t(extent.width) * extent.height * depth * texelSize * data.info.arrayLayers);
+    for (auto const & region : data.regions)
+    {
+        vk::Offset3D const & offset = region.imageOffset;
+        vk::Extent3D const & size   = region.imageExtent;
+        vk::ImageSubresourceLayers const & layers = region.imageSubresource;
+        if (offset.x < 0 || offset.y < 0 || offset.z < 0 ||
+            offset.x + size.width > extent.width || offset.y + size.height > extent.height || offset.z + size.depth > depth ||
+            layers.baseArrayLayer + layers.layerCount > data.info.arrayLayers)
+        {
+            throw std::invalid_argument("Vkx::generateMipChain: a region is not inside level 0");
+        }
+
+        size_t rowSize    = size_t(size.width) * texelSize;
+        size_t srcPitch   = size_t(region.bufferRowLength ? region.bufferRowLength : size.width) * texelSize;
+        size_t srcSlice   = srcPitch * (region.bufferImageHeight ? region.bufferImageHeight : size.height);
+        size_t srcLayer   = srcSlice * size.depth;
+        size_t dstPitch   = size_t(extent.width) * texelSize;
+        size_t dstSlice   = dstPitch * extent.height;
+        if (size.width == 0 || size.height == 0 || size.depth == 0 || layers.layerCount == 0)
+            continue;
+        size_t end = region.bufferOffset + srcLayer * (layers.layerCount - 1) + srcSlice * (size.depth - 1) +
+                     srcPitch * (size.height - 1) + rowSize;
+        if (end > data.pixels.size())
+            throw std::invalid_argument("Vkx::generateMipChain: a region extends past the pixels");
+
+        for (uint32_t layer = 0; layer < layers.layerCount; ++layer)
+        {
+            for (uint32_t z = 0; z < size.depth; ++z)
+            {
+                uint8_t const * src = data.pixels.data() + region.bufferOffset + srcLayer * layer + srcSlice * z;
+                uint8_t * dst = packed.data() + dstSlice * (size_t(layers.baseArrayLayer + layer) * depth + offset.z + z) +
+                                dstPitch * offset.y + size_t(offset.x) * texelSize;
+                Vkx::copyRows(dst, dstPitch, src, srcPitch, rowSize, size.height);
+            }
+        }
+    }
+    return packed;
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  info    Creation info of the image
+//!
+//! @return true if mip levels can be generated for the image
+bool canGenerateMipChain(vk::ImageCreateInfo const & info)
+{
+    Layout layout;
+    return describe(info.format, layout);
+}
+
+//! The pixels are expected to be the tightly-packed texels of mip level 0 of each layer, one layer after another (the
+//! slices of a 3D image, one after another). Each additional level, up to the number of levels in the image's creation
+//! info, is generated from the previous one for every layer and appended to the pixels (each level aligned to 16 bytes and
+//! to the texel size), and the regions are replaced with one region per level, so the result can be copied into the
+//! staging buffer as-is. If the data has regions for level 0, level 0 is taken from them instead. Data that already provides
+//! mip levels is not changed.
+//!
+//! sRGB-encoded color channels are filtered in linear space. Linear 8-bit formats of 2D images are box-filtered directly
+//! on the 8-bit values; all others are converted to 32-bit floats for filtering. Each slice of a 3D level is the average
+//! of the two filtered slices above it. Rows are filtered in parallel if there are workers.
+//!
+//! The supported formats are the 8-bit unorm and sRGB formats with 1 to 4 channels (RGBA or BGRA with 4), and the 16-bit
+//! unorm, 16-bit float and 32-bit float formats with 1, 2 or 4 channels. Others, such as block-compressed, packed and
+//! depth formats, are not supported; canGenerateMipChain() returns false for them so callers can use another path.
+//!
+//! @param  data        Image data
+//! @param  filter      Filter used to downsample each level (default: MipFilter::eBox)
+//! @param  workers     Worker threads used to filter the rows, or nullptr to filter on the calling thread (default: nullptr)
+//!
+//! @warning    A std::invalid_argument is thrown if the format is not supported, if there are fewer pixels than level 0
+//!             requires, or if a region is not inside level 0 or extends past the pixels
+void generateMipChain(ImageData & data, MipFilter filter /*= MipFilter::eBox*/, ThreadPool * workers /*= nullptr*/)
+{
+    vk::ImageCreateInfo const & info = data.info;
+    if (data.hasMipmaps() || info.mipLevels <= 1)
+        return;
+
+    Layout layout;
+    if (!describe(info.format, layout))
+        throw std::invalid_argument("Vkx::generateMipChain: unsupported format");
+
+    size_t texelSize = layout.texelSize();
+    size_t alignment = std::lcm(texelSize, size_t(16));
+    uint32_t layers  = info.arrayLayers;
+    uint32_t width   = info.extent.width;
+    uint32_t height  = info.extent.height;
+    uint32_t depth   = (info.imageType == vk::ImageType::e3D) ? info.extent.depth : 1;
+    if (!data.regions.empty())
+        data.pixels = packLevel0(data, texelSize, depth);
+    if (data.pixels.size() < size_t(width) * height * depth * texelSize * layers)
+        throw std::invalid_argument("Vkx::generateMipChain: not enough pixels for level 0");
+
+    // Lay out the levels. The layers of each level are consecutive.
+    std::vector<vk::BufferImageCopy> regions;
+    std::vector<size_t> layerSizes;
+    size_t size = 0;
+    for (uint32_t level = 0; level < info.mipLevels; ++level)
+    {
+        regions.emplace_back(size,
+                             0,
+                             0,
+                             vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, layers),
+                             vk::Offset3D(0, 0, 0),
+                             vk::Extent3D(width, height, depth));
+        layerSizes.push_back(size_t(width) * height * depth * texelSize);
+        size  += layerSizes.back() * layers;
+        size   = (size + alignment - 1) / alignment * alignment;
+        width  = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        depth  = std::max(depth / 2, 1u);
+    }
+    data.pixels.resize(size);
+
+    // Returns the address of a slice of a layer of a level
+    auto texels = [&data, &regions, &layerSizes, texelSize] (uint32_t level, uint32_t layer, uint32_t slice = 0) {
+                      vk::Extent3D const & extent = regions[level].imageExtent;
+                      size_t sliceSize = size_t(extent.width) * extent.height * texelSize;
+                      return data.pixels.data() + regions[level].bufferOffset + layerSizes[level] * layer +
+                             sliceSize * slice;
+                  };
+
+    for (uint32_t layer = 0; layer < layers; ++layer)
+    {
+        if (filter == MipFilter::eBox && layout.encoding == Encoding::eUnorm8 && !layout.isSrgb &&
+            info.imageType != vk::ImageType::e3D)
+        {
+            for (uint32_t level = 1; level < info.mipLevels; ++level)
+            {
+                vk::Extent3D const & from = regions[level - 1].imageExtent;
+                boxFilter8(texels(level - 1, layer), from.width, from.height, layout.channels, texels(level, layer), workers);
+            }
+        }
+        else
+        {
+            // Each level is filtered from the previous level at full precision, then encoded
+            vk::Extent3D const & extent = regions[0].imageExtent;
+            std::vector<Plane> slices;
+            for (uint32_t z = 0; z < extent.depth; ++z)
+            {
+                slices.push_back(decode(texels(0, layer, z), extent.width, extent.height, layout, workers));
+            }
+            for (uint32_t level = 1; level < info.mipLevels; ++level)
+            {
+                for (auto & slice : slices)
+                {
+                    slice = (filter == MipFilter::eKaiser) ? kaiserFilter(slice, workers) : boxFilter(slice, workers);
+                }
+
+                // Pairs of filtered slices are averaged. The last slice of an odd depth is clamped, like the texels.
+                uint32_t sliceCount = regions[level].imageExtent.depth;
+                if (sliceCount < slices.size())
+                {
+                    for (uint32_t z = 0; z < sliceCount; ++z)
+                    {
+                        uint32_t z1 = std::min(z * 2 + 1, (uint32_t)slices.size() - 1);
+                        slices[z] = (z1 == z * 2) ? std::move(slices[z * 2])
+                                                  : average(std::move(slices[z * 2]), slices[z1]);
+                    }
+                    slices.resize(sliceCount);
+                }
+
+                for (uint32_t z = 0; z < sliceCount; ++z)
+                {
+                    encode(slices[z], layout, texels(level, layer, z), workers);
+                }
+            }
+        }
+    }
+
+    data.regions = std::move(regions);
+}
+} // namespace Vkx
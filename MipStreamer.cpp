@@ -0,0 +1,379 @@
+#include "MipStreamer.h"
+
+#include "Buffer.h"
+#include "Camera.h"
+#include "Device.h"
+#include "Image.h"
+#include "ThreadPool.h"
+#include "Vkx.h"
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+vk::Extent3D levelExtent(vk::Extent3D const & extent, uint32_t level)
+{
+    return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), std::max(extent.depth >> level, 1u) };
+}
+
+// Returns the number of texels in the given level and all smaller levels of every layer
+size_t texelsFrom(vk::ImageCreateInfo const & info, uint32_t level)
+{
+    size_t texels = 0;
+    for (uint32_t i = level; i < info.mipLevels; ++i)
+    {
+        vk::Extent3D extent = levelExtent(info.extent, i);
+        texels += (size_t)extent.width * extent.height * extent.depth;
+    }
+    return texels * info.arrayLayers;
+}
+
+// Returns the alignment of each level's texels in a staging buffer. copyAlignment() supports only uncompressed formats. Every
+// block-compressed format has 8- or 16-byte blocks, so 16 bytes is used for the others.
+size_t stagingAlignment(vk::Format format)
+{
+    try
+    {
+        return Vkx::copyAlignment(format);
+    }
+    catch (std::invalid_argument const &)
+    {
+        return 16;
+    }
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  info            Creation info of the full texture, including all of its mip levels
+//! @param  source          Provides the texels of each level
+//! @param  tailLevels      Number of the smallest levels that are always resident (default: 1)
+StreamedTexture::StreamedTexture(vk::ImageCreateInfo const & info, Source source, uint32_t tailLevels /*= 1*/)
+    : info_(info)
+    , source_(source)
+    , tailLevel_(info.mipLevels - std::min(std::max(tailLevels, 1u), info.mipLevels))
+    , residentLevel_(info.mipLevels)
+    , requestedLevel_(tailLevel_)
+{
+}
+
+//! The level is chosen so that one texel of the level covers about one pixel, assuming that the texture spans the diameter of
+//! the object.
+//!
+//! @param  camera          Camera viewing the object
+//! @param  position        Position of the object in world space
+//! @param  radius          Radius of the object's bounding sphere
+//! @param  viewportHeight  Height of the viewport in pixels
+//!
+//! @return desired mip level
+uint32_t StreamedTexture::desiredLevel(Camera const &    camera,
+                                       glm::vec3 const & position,
+                                       float             radius,
+                                       float             viewportHeight) const
+{
+    float distance = glm::distance(camera.position(), position);
+    if (distance <= radius)
+        return 0;
+
+    // The projected diameter is 2r / (2d tan(fov/2)) of the viewport height
+    float pixels = radius * viewportHeight / (distance * std::tan(camera.angleOfView() * 0.5f));
+    float texels = (float)std::max(info_.extent.width, info_.extent.height);
+    if (pixels >= texels)
+        return 0;
+
+    uint32_t level = (uint32_t)std::floor(std::log2(texels / std::max(pixels, 1.0f)));
+    return std::min(level, info_.mipLevels - 1);
+}
+
+//! @param  device          Logical device associated with the textures
+//! @param  queue           Queue that the uploads are submitted to
+//! @param  queueFamily     Family of the upload queue
+//! @param  graphicsFamily  Family of the queues that sample the textures
+//! @param  texelBudget     Approximate number of texels that can be loaded per update. At least one load is always started.
+//! @param  workers         Worker threads used to load the levels, or nullptr to create a pool (default: nullptr)
+//! @param  framesInFlight  Number of frames in flight (see SwapChain::framesInFlight())
+//!                         (default: SwapChain::DEFAULT_FRAMES_IN_FLIGHT)
+//!
+//! @warning    A std::invalid_argument is thrown if framesInFlight is not in [1, SwapChain::MAX_FRAMES_IN_FLIGHT]
+MipStreamer::MipStreamer(std::shared_ptr<Device>     device,
+                         vk::Queue                   queue,
+                         uint32_t                    queueFamily,
+                         uint32_t                    graphicsFamily,
+                         size_t                      texelBudget,
+                         std::shared_ptr<ThreadPool> workers /*= nullptr*/,
+                         int                         framesInFlight /*= SwapChain::DEFAULT_FRAMES_IN_FLIGHT*/)
+    : device_(device)
+    , queue_(queue)
+    , families_{ queueFamily, graphicsFamily }
+    , shaderStages_(samplingStages(device->physical()->getQueueFamilyProperties()[queueFamily].queueFlags))
+    , texelBudget_(texelBudget)
+    , workers_(workers ? workers : std::make_shared<ThreadPool>())
+    , framesInFlight_(framesInFlight)
+{
+    if (framesInFlight < 1 || framesInFlight > SwapChain::MAX_FRAMES_IN_FLIGHT)
+        throw std::invalid_argument("Vkx::MipStreamer::MipStreamer: framesInFlight is out of range");
+    commandPool_ = device_->createCommandPoolUnique(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient,
+                                                                              queueFamily));
+}
+
+MipStreamer::~MipStreamer()
+{
+    for (auto & job : jobs_)
+    {
+        job.wait();
+    }
+    for (auto & batch : batches_)
+    {
+        device_->waitForFences(1, &(*batch.fence), VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+}
+
+//! @param  texture     Texture to stream
+void MipStreamer::add(std::shared_ptr<StreamedTexture> texture)
+{
+    textures_.push_back(texture);
+}
+
+//! Loads in progress for the texture still complete, but no new loads are started.
+//!
+//! @param  texture     Texture to stop streaming
+void MipStreamer::remove(std::shared_ptr<StreamedTexture> const & texture)
+{
+    textures_.erase(std::remove(textures_.begin(), textures_.end(), texture), textures_.end());
+}
+
+//! Requests are typically made every frame, using StreamedTexture::desiredLevel() to choose the level and the object's
+//! screen coverage or distance as the priority. The texture's mip tail is never released.
+//!
+//! @param  texture     Texture
+//! @param  level       Most detailed level that should be resident
+//! @param  priority    Requests with higher priorities are serviced first
+void MipStreamer::request(StreamedTexture & texture, uint32_t level, float priority)
+{
+    texture.requestedLevel_ = std::min(level, texture.tailLevel_);
+    texture.priority_       = priority;
+}
+
+//! The frame's previous submission must have completed, which SwapChain::swap() ensures by waiting for its in-flight fence.
+//! An image that has been replaced may be in use by any frame in flight, so it is destroyed once every frame has started
+//! again. Uploads that complete are made available here, so the frame's commands should be recorded after this call.
+//!
+//! @param  frame   Index of the frame being started, in [0, framesInFlight)
+//!
+//! @warning    A std::out_of_range is thrown if the frame is out of range
+void MipStreamer::update(int frame)
+{
+    if (frame < 0 || frame >= framesInFlight_)
+        throw std::out_of_range("Vkx::MipStreamer::update: frame is out of range");
+
+    // Images that have been replaced are destroyed once no frame can be using them
+    for (auto & r : retired_)
+    {
+        r.frames &= ~(1u << frame);
+    }
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [] (Retired const & r) { return r.frames == 0; }),
+                   retired_.end());
+
+    // Replace images whose uploads have completed. Batches are submitted to a single queue, so they complete in order.
+    while (!batches_.empty() && device_->getFenceStatus(*batches_.front().fence) == vk::Result::eSuccess)
+    {
+        for (auto & upload : batches_.front().uploads)
+        {
+            StreamedTexture & texture = *upload.texture;
+            if (texture.image_)
+                retired_.push_back({ std::move(texture.image_), (1u << framesInFlight_) - 1 });
+            texture.image_         = std::move(upload.image);
+            texture.residentLevel_ = upload.level;
+            texture.busy_          = false;
+        }
+        batches_.pop_front();
+    }
+
+    jobs_.erase(std::remove_if(jobs_.begin(),
+                               jobs_.end(),
+                               [] (std::future<void> & job) {
+                                   return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                               }),
+                jobs_.end());
+
+    // Start loading the highest-priority requests that fit in the budget
+    std::vector<std::shared_ptr<StreamedTexture>> candidates;
+    for (auto const & texture : textures_)
+    {
+        if (!texture->busy_ && texture->requestedLevel_ != texture->residentLevel_)
+            candidates.push_back(texture);
+    }
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [] (std::shared_ptr<StreamedTexture> const & a, std::shared_ptr<StreamedTexture> const & b) {
+                  return a->priority_ > b->priority_;
+              });
+
+    size_t started = 0;
+    for (auto const & texture : candidates)
+    {
+        // Refine one level at a time, but load the initial mip tail and reductions in one step
+        uint32_t level = texture->requestedLevel_;
+        if (texture->image_ && level < texture->residentLevel_)
+            level = texture->residentLevel_ - 1;
+
+        size_t texels = texelsFrom(texture->info_, level);
+        if (started > 0 && started + texels > texelBudget_)
+            break;
+        started += texels;
+        start(texture, level);
+    }
+
+    // Upload everything that has been loaded in a single submission
+    std::vector<Upload> loaded;
+    {
+        std::lock_guard<std::mutex> lock(loadedMutex_);
+        loaded.swap(loaded_);
+    }
+
+    Batch batch;
+    for (auto & upload : loaded)
+    {
+        if (upload.image)
+        {
+            batch.uploads.push_back(std::move(upload));
+        }
+        else
+        {
+            // The load failed, so the request is abandoned
+            upload.texture->requestedLevel_ = upload.texture->residentLevel_;
+            upload.texture->busy_           = false;
+        }
+    }
+    if (batch.uploads.empty())
+        return;
+
+    std::vector<vk::UniqueCommandBuffer> commandBuffers = device_->allocateCommandBuffersUnique(
+        vk::CommandBufferAllocateInfo(*commandPool_, vk::CommandBufferLevel::ePrimary, 1));
+    batch.commands = std::move(commandBuffers[0]);
+
+    vk::CommandBuffer & commands = *batch.commands;
+    commands.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    for (auto & upload : batch.uploads)
+    {
+        // The current image stays in the eGeneral layout, so it can be copied while frames are still sampling it
+        LocalImage & image = *upload.image;
+        image.transitionLayout(commands, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+        if (upload.staging)
+            image.copy(commands, *upload.staging, upload.regions);
+        if (!upload.copies.empty())
+        {
+            commands.copyImage(*upload.texture->image_,
+                               StreamedTexture::LAYOUT,
+                               image,
+                               vk::ImageLayout::eTransferDstOptimal,
+                               upload.copies);
+        }
+        image.transitionLayout(commands, vk::ImageLayout::eTransferDstOptimal, StreamedTexture::LAYOUT, shaderStages_);
+    }
+    commands.end();
+
+    batch.fence = device_->createFenceUnique(vk::FenceCreateInfo());
+    queue_.submit(vk::SubmitInfo(0, nullptr, nullptr, 1, &commands), *batch.fence);
+    batches_.push_back(std::move(batch));
+}
+
+//! @param  swapChain   Swap chain whose current frame is started. Its frame count must match this streamer's.
+//!
+//! @warning    This must be called after SwapChain::swap() has returned.
+void MipStreamer::update(SwapChain const & swapChain)
+{
+    update(swapChain.frame());
+}
+
+//! @return total number of texels in the resident levels
+size_t MipStreamer::residentTexels() const
+{
+    size_t texels = 0;
+    for (auto const & texture : textures_)
+    {
+        texels += texelsFrom(texture->info_, texture->residentLevel_);
+    }
+    return texels;
+}
+
+void MipStreamer::start(std::shared_ptr<StreamedTexture> texture, uint32_t level)
+{
+    // The resident level and image do not change until the upload completes
+    texture->busy_ = true;
+    uint32_t residentLevel = texture->image_ ? texture->residentLevel_ : texture->info_.mipLevels;
+    jobs_.push_back(workers_->submit([this, texture, level, residentLevel] () {
+                                         Upload upload = load(texture, level, residentLevel);
+                                         std::lock_guard<std::mutex> lock(loadedMutex_);
+                                         loaded_.push_back(std::move(upload));
+                                     }));
+}
+
+// Runs on a worker thread. Creates an image holding the levels from the given level to the end of the chain. The levels that
+// are already resident are copied from the current image when the upload is recorded, so only the others are read from the
+// source and staged.
+MipStreamer::Upload MipStreamer::load(std::shared_ptr<StreamedTexture> texture, uint32_t level, uint32_t residentLevel)
+{
+    Upload upload{ texture, level, nullptr, {}, nullptr, {}, {} };
+    try
+    {
+        vk::ImageCreateInfo info = texture->info_;
+        info.extent    = levelExtent(texture->info_.extent, level);
+        info.mipLevels = texture->info_.mipLevels - level;
+        info.usage    |= vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc |
+                         vk::ImageUsageFlagBits::eSampled;
+        if (families_[0] != families_[1])
+        {
+            info.sharingMode           = vk::SharingMode::eConcurrent;
+            info.queueFamilyIndexCount = 2;
+            info.pQueueFamilyIndices   = families_;
+        }
+        uint32_t layers = info.arrayLayers;
+
+        // Each level is staged at an offset that a copy to the image allows
+        size_t alignment = stagingAlignment(info.format);
+        std::vector<uint8_t> & texels = upload.texels;
+        for (uint32_t i = level; i < std::min(residentLevel, texture->info_.mipLevels); ++i)
+        {
+            std::vector<uint8_t> data = texture->source_(i);
+            size_t offset = (texels.size() + alignment - 1) / alignment * alignment;
+            upload.regions.emplace_back(offset,
+                                        0,
+                                        0,
+                                        vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i - level, 0, layers),
+                                        vk::Offset3D(0, 0, 0),
+                                        levelExtent(texture->info_.extent, i));
+            texels.resize(offset);
+            texels.insert(texels.end(), data.begin(), data.end());
+        }
+
+        for (uint32_t i = std::max(level, residentLevel); i < texture->info_.mipLevels; ++i)
+        {
+            upload.copies.emplace_back(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor,
+                                                                  i - residentLevel,
+                                                                  0,
+                                                                  layers),
+                                       vk::Offset3D(0, 0, 0),
+                                       vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i - level, 0, layers),
+                                       vk::Offset3D(0, 0, 0),
+                                       levelExtent(texture->info_.extent, i));
+        }
+
+        if (!texels.empty())
+            upload.staging = createStagingBuffer(device_, texels.data(), texels.size());
+        upload.image = std::make_unique<LocalImage>(device_, info);
+    }
+    catch (std::exception const &)
+    {
+        upload.image.reset();
+    }
+    return upload;
+}
+} // namespace Vkx
@@ -0,0 +1,353 @@
+#include "PipelineBuilder.h"
+
+#include "Device.h"
+#include "ShaderCache.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+// FNV-1a
+class Hasher
+{
+public:
+    template <typename T>
+    void add(T const & value)
+    {
+        uint8_t bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        for (uint8_t b : bytes)
+        {
+            hash_ = (hash_ ^ b) * 0x100000001b3ull;
+        }
+    }
+
+    void add(std::string const & value)
+    {
+        add(value.size());
+        for (char c : value)
+        {
+            hash_ = (hash_ ^ (uint8_t)c) * 0x100000001b3ull;
+        }
+    }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+// One color attachment that writes every component without blending
+vk::PipelineColorBlendAttachmentState const DEFAULT_BLEND_ATTACHMENT(VK_FALSE,
+                                                                     vk::BlendFactor::eOne,
+                                                                     vk::BlendFactor::eZero,
+                                                                     vk::BlendOp::eAdd,
+                                                                     vk::BlendFactor::eOne,
+                                                                     vk::BlendFactor::eZero,
+                                                                     vk::BlendOp::eAdd,
+                                                                     vk::ColorComponentFlagBits::eR |
+                                                                     vk::ColorComponentFlagBits::eG |
+                                                                     vk::ColorComponentFlagBits::eB |
+                                                                     vk::ColorComponentFlagBits::eA);
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  layout      Layout of the pipeline
+//! @param  renderPass  Render pass the pipeline is used in
+//! @param  subpass     Subpass the pipeline is used in (default: 0)
+PipelineBuilder::PipelineBuilder(vk::PipelineLayout layout, vk::RenderPass renderPass, uint32_t subpass /*= 0*/)
+    : layout_(layout)
+    , renderPass_(renderPass)
+    , subpass_(subpass)
+{
+}
+
+//! @param  stage           Stage
+//! @param  path            Path to the SPIR-V file
+//! @param  entry           Name of the entry point (default: "main")
+//! @param  specialization  Values of the shader's specialization constants (default: none)
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::shader(vk::ShaderStageFlagBits stage,
+                                          std::string const &     path,
+                                          std::string const &     entry /*= "main"*/,
+                                          Specialization const &  specialization /*= Specialization()*/)
+{
+    stages_.push_back({ stage, path, entry, specialization });
+    return *this;
+}
+
+//! @param  binding     Binding number
+//! @param  stride      Distance between consecutive elements in the buffer
+//! @param  rate        Whether elements are per vertex or per instance (default: eVertex)
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::vertexBinding(uint32_t            binding,
+                                                 uint32_t            stride,
+                                                 vk::VertexInputRate rate /*= vk::VertexInputRate::eVertex*/)
+{
+    bindings_.emplace_back(binding, stride, rate);
+    return *this;
+}
+
+//! @param  location    Shader input location
+//! @param  binding     Binding the attribute is read from
+//! @param  format      Format of the attribute
+//! @param  offset      Offset of the attribute in an element
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::vertexAttribute(uint32_t location, uint32_t binding, vk::Format format, uint32_t offset)
+{
+    attributes_.emplace_back(location, binding, format, offset);
+    return *this;
+}
+
+//! @param  topology            Primitive topology
+//! @param  primitiveRestart    True if a special index restarts strips and fans (default: false)
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::topology(vk::PrimitiveTopology topology, bool primitiveRestart /*= false*/)
+{
+    topology_         = topology;
+    primitiveRestart_ = primitiveRestart;
+    return *this;
+}
+
+//! @param  polygonMode     How polygons are rasterized
+//! @param  cullMode        Which faces are culled
+//! @param  frontFace       Which winding is front-facing
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::rasterization(vk::PolygonMode polygonMode, vk::CullModeFlags cullMode, vk::FrontFace frontFace)
+{
+    polygonMode_ = polygonMode;
+    cullMode_    = cullMode;
+    frontFace_   = frontFace;
+    return *this;
+}
+
+//! @param  samples     Number of samples per pixel
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::samples(vk::SampleCountFlagBits samples)
+{
+    samples_ = samples;
+    return *this;
+}
+
+//! @param  test        True if fragments are depth-tested
+//! @param  write       True if depths are written
+//! @param  compare     Depth comparison (default: eLess)
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::depthTest(bool test, bool write, vk::CompareOp compare /*= vk::CompareOp::eLess*/)
+{
+    depthTest_    = test;
+    depthWrite_   = write;
+    depthCompare_ = compare;
+    return *this;
+}
+
+//! Attachments are added in order. If none are added, the pipeline has one attachment without blending.
+//!
+//! @param  attachment  Blend state of the next color attachment
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::blend(vk::PipelineColorBlendAttachmentState const & attachment)
+{
+    blendAttachments_.push_back(attachment);
+    return *this;
+}
+
+//! @param  state   State that is set by commands instead of the pipeline. Viewport and scissor are always dynamic.
+//!
+//! @return this builder
+PipelineBuilder & PipelineBuilder::dynamicState(vk::DynamicState state)
+{
+    dynamicStates_.push_back(state);
+    return *this;
+}
+
+//! @param  device  Logical device that creates the pipeline. Its ShaderCache provides the shader modules.
+//! @param  cache   Pipeline cache, or nullptr for none
+//!
+//! @return new pipeline
+//!
+//! @warning    A std::runtime_error is thrown if a shader file cannot be opened
+vk::UniquePipeline PipelineBuilder::build(Device & device, vk::PipelineCache cache) const
+{
+    // The modules are kept until the pipeline has been created
+    std::vector<ShaderCache::Module> modules;
+    std::vector<vk::SpecializationInfo> specializations;
+    std::vector<vk::PipelineShaderStageCreateInfo> stages;
+    modules.reserve(stages_.size());
+    specializations.reserve(stages_.size());
+    stages.reserve(stages_.size());
+    for (auto const & stage : stages_)
+    {
+        modules.push_back(device.shaders().get(stage.path));
+        specializations.push_back(stage.specialization.info());
+        stages.emplace_back(vk::PipelineShaderStageCreateFlags(),
+                            stage.stage,
+                            *modules.back(),
+                            stage.entry.c_str(),
+                            stage.specialization.empty() ? nullptr : &specializations.back());
+    }
+
+    vk::PipelineVertexInputStateCreateInfo vertexInput({},
+                                                       (uint32_t)bindings_.size(),
+                                                       bindings_.data(),
+                                                       (uint32_t)attributes_.size(),
+                                                       attributes_.data());
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, topology_, primitiveRestart_);
+    vk::PipelineViewportStateCreateInfo viewport({}, 1, nullptr, 1, nullptr);
+    vk::PipelineRasterizationStateCreateInfo rasterization({},
+                                                           VK_FALSE,
+                                                           VK_FALSE,
+                                                           polygonMode_,
+                                                           cullMode_,
+                                                           frontFace_,
+                                                           VK_FALSE,
+                                                           0.0f,
+                                                           0.0f,
+                                                           0.0f,
+                                                           1.0f);
+    vk::PipelineMultisampleStateCreateInfo multisample({}, samples_);
+    vk::PipelineDepthStencilStateCreateInfo depthStencil({}, depthTest_, depthWrite_, depthCompare_);
+
+    std::vector<vk::PipelineColorBlendAttachmentState> attachments = blendAttachments_;
+    if (attachments.empty())
+        attachments.push_back(DEFAULT_BLEND_ATTACHMENT);
+    vk::PipelineColorBlendStateCreateInfo colorBlend({},
+                                                     VK_FALSE,
+                                                     vk::LogicOp::eCopy,
+                                                     (uint32_t)attachments.size(),
+                                                     attachments.data());
+
+    std::vector<vk::DynamicState> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+    dynamicStates.insert(dynamicStates.end(), dynamicStates_.begin(), dynamicStates_.end());
+    vk::PipelineDynamicStateCreateInfo dynamic({}, (uint32_t)dynamicStates.size(), dynamicStates.data());
+
+    vk::GraphicsPipelineCreateInfo info({},
+                                        (uint32_t)stages.size(),
+                                        stages.data(),
+                                        &vertexInput,
+                                        &inputAssembly,
+                                        nullptr,
+                                        &viewport,
+                                        &rasterization,
+                                        &multisample,
+                                        &depthStencil,
+                                        &colorBlend,
+                                        &dynamic,
+                                        layout_,
+                                        renderPass_,
+                                        subpass_);
+    return std::move(device.createGraphicsPipelineUnique(cache, info).value);
+}
+
+//! @return paths, in the order the stages were added
+std::vector<std::string> PipelineBuilder::shaderPaths() const
+{
+    std::vector<std::string> paths;
+    for (auto const & stage : stages_)
+    {
+        paths.push_back(stage.path);
+    }
+    return paths;
+}
+
+//! @return hash of every part of the state
+size_t PipelineBuilder::hash() const
+{
+    Hasher hasher;
+    hasher.add(std::hash<vk::PipelineLayout>()(layout_));
+    hasher.add(std::hash<vk::RenderPass>()(renderPass_));
+    hasher.add(subpass_);
+    hasher.add(stages_.size());
+    for (auto const & stage : stages_)
+    {
+        hasher.add(stage.stage);
+        hasher.add(stage.path);
+        hasher.add(stage.entry);
+        hasher.add(stage.specialization.hash());
+    }
+    hasher.add(bindings_.size());
+    for (auto const & binding : bindings_)
+    {
+        hasher.add(binding.binding);
+        hasher.add(binding.stride);
+        hasher.add(binding.inputRate);
+    }
+    hasher.add(attributes_.size());
+    for (auto const & attribute : attributes_)
+    {
+        hasher.add(attribute.location);
+        hasher.add(attribute.binding);
+        hasher.add(attribute.format);
+        hasher.add(attribute.offset);
+    }
+    hasher.add(topology_);
+    hasher.add(primitiveRestart_);
+    hasher.add(polygonMode_);
+    hasher.add((uint32_t)cullMode_);
+    hasher.add(frontFace_);
+    hasher.add(samples_);
+    hasher.add(depthTest_);
+    hasher.add(depthWrite_);
+    hasher.add(depthCompare_);
+    hasher.add(blendAttachments_.size());
+    for (auto const & attachment : blendAttachments_)
+    {
+        hasher.add(attachment.blendEnable);
+        hasher.add(attachment.srcColorBlendFactor);
+        hasher.add(attachment.dstColorBlendFactor);
+        hasher.add(attachment.colorBlendOp);
+        hasher.add(attachment.srcAlphaBlendFactor);
+        hasher.add(attachment.dstAlphaBlendFactor);
+        hasher.add(attachment.alphaBlendOp);
+        hasher.add((uint32_t)attachment.colorWriteMask);
+    }
+    hasher.add(dynamicStates_.size());
+    for (auto state : dynamicStates_)
+    {
+        hasher.add(state);
+    }
+    return (size_t)hasher.value();
+}
+
+//! @param  rhs     Builder to compare with
+//!
+//! @return true if every part of the state is the same
+bool PipelineBuilder::operator ==(PipelineBuilder const & rhs) const
+{
+    auto sameStages = [] (Stage const & a, Stage const & b) {
+                          return a.stage == b.stage &&
+                                 a.path == b.path &&
+                                 a.entry == b.entry &&
+                                 a.specialization == b.specialization;
+                      };
+    return layout_ == rhs.layout_ &&
+           renderPass_ == rhs.renderPass_ &&
+           subpass_ == rhs.subpass_ &&
+           std::equal(stages_.begin(), stages_.end(), rhs.stages_.begin(), rhs.stages_.end(), sameStages) &&
+           bindings_ == rhs.bindings_ &&
+           attributes_ == rhs.attributes_ &&
+           topology_ == rhs.topology_ &&
+           primitiveRestart_ == rhs.primitiveRestart_ &&
+           polygonMode_ == rhs.polygonMode_ &&
+           cullMode_ == rhs.cullMode_ &&
+           frontFace_ == rhs.frontFace_ &&
+           samples_ == rhs.samples_ &&
+           depthTest_ == rhs.depthTest_ &&
+           depthWrite_ == rhs.depthWrite_ &&
+           depthCompare_ == rhs.depthCompare_ &&
+           blendAttachments_ == rhs.blendAttachments_ &&
+           dynamicStates_ == rhs.dynamicStates_;
+}
+} // namespace Vkx
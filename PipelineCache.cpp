@@ -0,0 +1,217 @@
+#include "PipelineCache.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// The header that starts the data of every pipeline cache (VkPipelineCacheHeaderVersionOne)
+size_t constexpr HEADER_SIZE = 16 + VK_UUID_SIZE;
+
+uint32_t readUint32(uint8_t const * p)
+{
+    // The header's fields are little-endian regardless of the host
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+// Writes the data to a new file and flushes it to the storage device, so that it is complete before it is renamed
+bool writeDurably(std::string const & path, std::vector<uint8_t> const & contents)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    DWORD written = 0;
+    bool ok = WriteFile(file, contents.data(), (DWORD)contents.size(), &written, nullptr) &&
+              written == contents.size() &&
+              FlushFileBuffers(file);
+    CloseHandle(file);
+    return ok;
+#else
+    int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0)
+        return false;
+    size_t written = 0;
+    while (written < contents.size())
+    {
+        ssize_t n = write(file, contents.data() + written, contents.size() - written);
+        if (n < 0)
+            break;
+        written += (size_t)n;
+    }
+    bool ok = written == contents.size() && fsync(file) == 0;
+    return (close(file) == 0) && ok;
+#endif
+}
+
+// Flushes the directory holding a file, so that a rename into it survives a crash. Failure is ignored.
+void syncDirectory(std::string const & path)
+{
+#if !defined(_WIN32)
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int file = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (file >= 0)
+    {
+        fsync(file);
+        close(file);
+    }
+#else
+    (void)path;
+#endif
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  device      Logical device that uses the cache
+//! @param  properties  Properties of the device's physical device, used to validate loaded data
+PipelineCache::PipelineCache(vk::Device device, vk::PhysicalDeviceProperties const & properties)
+    : device_(device)
+    , properties_(properties)
+{
+    cache_ = device_.createPipelineCacheUnique(vk::PipelineCacheCreateInfo());
+}
+
+//! If the cache was loaded from a file, it is saved back to the file. Failure to save is ignored.
+PipelineCache::~PipelineCache()
+{
+    try
+    {
+        save();
+    }
+    catch (std::exception const &)
+    {
+    }
+}
+
+//! The file is remembered, and save() (and the destructor) will save to it. A file that does not exist, or whose contents are
+//! not compatible with the device, is not an error; the cache simply stays as it is.
+//!
+//! @param  path    Path to the file
+//!
+//! @return true if the file's data was merged into the cache
+//!
+//! @warning    The data is merged with merge(), so its requirements apply.
+bool PipelineCache::load(std::string const & path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = path;
+    }
+
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        return false;
+    std::vector<uint8_t> contents((size_t)file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(contents.data()), contents.size());
+    if (!file || !isCompatible(contents, properties_))
+        return false;
+
+    vk::UniquePipelineCache loaded =
+        device_.createPipelineCacheUnique(vk::PipelineCacheCreateInfo({}, contents.size(), contents.data()));
+    merge(*loaded);
+    return true;
+}
+
+//! The data is written to a temporary file next to the destination and flushed to storage, and then the temporary file
+//! replaces the destination. A crash at any point leaves either the old file or the complete new one.
+//!
+//! @param  path    Path to the file
+//!
+//! @warning    A std::runtime_error is thrown if the file cannot be written
+void PipelineCache::save(std::string const & path) const
+{
+    std::vector<uint8_t> contents = data();
+
+    std::string temporary = path + ".tmp";
+    std::error_code error;
+    if (!writeDurably(temporary, contents))
+    {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Vkx::PipelineCache::save: failed to write " + temporary);
+    }
+
+    // Unlike std::rename, this replaces an existing file on every platform
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Vkx::PipelineCache::save: failed to replace " + path);
+    }
+    syncDirectory(path);
+}
+
+//! @warning    A std::runtime_error is thrown if the file cannot be written
+void PipelineCache::save() const
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path = path_;
+    }
+    if (!path.empty())
+        save(path);
+}
+
+//! @return the data, suitable for vk::PipelineCacheCreateInfo
+std::vector<uint8_t> PipelineCache::data() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return device_.getPipelineCacheData(*cache_);
+}
+
+//! @param  data        Pipeline cache data
+//! @param  properties  Properties of the physical device
+//!
+//! @return true if the data's header matches the device's vendor, device, and pipeline cache UUID
+bool PipelineCache::isCompatible(std::vector<uint8_t> const & data, vk::PhysicalDeviceProperties const & properties)
+{
+    if (data.size() < HEADER_SIZE)
+        return false;
+
+    uint32_t headerSize    = readUint32(&data[0]);
+    uint32_t headerVersion = readUint32(&data[4]);
+    uint32_t vendorId      = readUint32(&data[8]);
+    uint32_t deviceId      = readUint32(&data[12]);
+    return headerSize >= HEADER_SIZE &&
+           headerSize <= data.size() &&
+           headerVersion == (uint32_t)vk::PipelineCacheHeaderVersion::eOne &&
+           vendorId == properties.vendorID &&
+           deviceId == properties.deviceID &&
+           memcmp(&data[16], properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+//! Pipelines can be created concurrently with this cache, but a thread creating many pipelines can avoid contention inside
+//! the driver by using its own cache, and merging it into this one with merge() when it is done.
+//!
+//! @return new, empty cache
+vk::UniquePipelineCache PipelineCache::createWorkerCache() const
+{
+    return device_.createPipelineCacheUnique(vk::PipelineCacheCreateInfo());
+}
+
+//! Vulkan requires exclusive access to the destination of a merge, and creating a pipeline with this cache accesses it.
+//! Merges are serialized with each other, but not with pipeline creation, so merge when no thread is creating pipelines
+//! with this cache, such as at the end of a loading phase.
+//!
+//! @param  src     Cache to merge. It is not changed.
+//!
+//! @warning    No pipeline may be created with this cache while this function runs.
+void PipelineCache::merge(vk::PipelineCache const & src)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    device_.mergePipelineCaches(*cache_, 1, &src);
+}
+} // namespace Vkx
@@ -0,0 +1,263 @@
+#include "PipelineLibrary.h"
+
+#include "Device.h"
+#include "PipelineCache.h"
+#include "ShaderCache.h"
+#include "ThreadPool.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <stdexcept>
+
+namespace Vkx
+{
+//! @param  device      Logical device that creates the pipelines
+//! @param  workers     Worker threads used to compile pipelines in the background, or nullptr to create a pool
+//!                     (default: nullptr)
+PipelineLibrary::PipelineLibrary(std::shared_ptr<Device> device, std::shared_ptr<ThreadPool> workers /*= nullptr*/)
+    : device_(device)
+    , workers_(workers ? workers : std::make_shared<ThreadPool>())
+{
+}
+
+//! The destructor waits for any compilations in progress.
+PipelineLibrary::~PipelineLibrary()
+{
+    waitIdle();
+}
+
+//! If the pipeline is being compiled in the background, this waits for it.
+//!
+//! @param  builder     State of the pipeline
+//!
+//! @return pipeline, which remains valid until the library is destroyed
+//!
+//! @warning    A std::runtime_error is thrown if the pipeline cannot be created. It is not attempted again.
+vk::Pipeline PipelineLibrary::get(PipelineBuilder const & builder)
+{
+    std::shared_ptr<Entry> entry;   // Kept in case the entry is replaced meanwhile
+    std::shared_future<void> compiling;
+    std::promise<void> compiled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        removeOutdated();
+        auto found = pipelines_.find(builder);
+        if (found == pipelines_.end())
+        {
+            // Anyone else asking for the pipeline while it is created here waits for it
+            found = pipelines_.emplace(builder, std::make_shared<Entry>()).first;
+            found->second->compiling = compiled.get_future().share();
+        }
+        else
+        {
+            compiling = found->second->compiling;
+        }
+        entry = found->second;
+    }
+
+    if (compiling.valid())
+    {
+        compiling.wait();
+    }
+    else if (!entry->pipeline && !entry->failed)
+    {
+        compile(builder, *entry);
+        compiled.set_value();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry->failed)
+        throw std::runtime_error("Vkx::PipelineLibrary::get: failed to create the pipeline");
+    return *entry->pipeline;
+}
+
+//! If the pipeline does not exist yet, it starts compiling on a worker thread. A pipeline that fails to compile is not
+//! attempted again, and the fallback is returned for it from then on.
+//!
+//! @param  builder     State of the pipeline
+//! @param  fallback    Pipeline to use until the pipeline is ready. It must be compatible with the same layout and render
+//!                     pass.
+//!
+//! @return pipeline, or the fallback if it is not ready
+vk::Pipeline PipelineLibrary::request(PipelineBuilder const & builder, vk::Pipeline fallback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeOutdated();
+    auto found = pipelines_.find(builder);
+    if (found == pipelines_.end())
+    {
+        found = pipelines_.emplace(builder, std::make_shared<Entry>()).first;
+
+        // Keys and entries do not move when the map is modified
+        PipelineBuilder const * key = &found->first;
+        Entry * entry               = found->second.get();
+        entry->compiling = workers_->submit([this, key, entry] () { compile(*key, *entry); }).share();
+        return fallback;
+    }
+    return found->second->pipeline ? *found->second->pipeline : fallback;
+}
+
+//! Pipelines that already exist are skipped, and pipelines that fail to compile are ignored. To keep the calling thread
+//! responsive, call this function on another thread.
+//!
+//! Pipelines that request() is compiling in the background are skipped rather than waited for. Their compilations are queued
+//! on the same worker threads, so waiting for them here could block every worker.
+//!
+//! @param  builders    States of the pipelines
+//! @param  progress    Called after each pipeline has been created, with the number created so far and the total, or nullptr
+//!                     (default: nullptr). It is called on the worker threads, but never concurrently.
+void PipelineLibrary::prewarm(std::vector<PipelineBuilder> const &          builders,
+                              std::function<void(size_t done, size_t total)> progress /*= nullptr*/)
+{
+    std::mutex progressMutex;
+    size_t done = 0;
+    workers_->parallelFor(builders.size(),
+                          [this, &builders, &progress, &progressMutex, &done] (size_t begin, size_t end) {
+                              for (size_t i = begin; i < end; ++i)
+                              {
+                                  compileIfMissing(builders[i]);
+
+                                  std::lock_guard<std::mutex> lock(progressMutex);
+                                  ++done;
+                                  if (progress)
+                                      progress(done, builders.size());
+                              }
+                          });
+}
+
+//! @return states of the pipelines, suitable for PipelineManifest::save()
+std::vector<PipelineBuilder> PipelineLibrary::builders() const
+{
+    std::vector<PipelineBuilder> builders;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const & pipeline : pipelines_)
+    {
+        if (pipeline.second->pipeline)
+            builders.push_back(pipeline.first);
+    }
+    return builders;
+}
+
+//! @param  builder     State of the pipeline
+//!
+//! @return true if the pipeline exists and can be used
+bool PipelineLibrary::ready(PipelineBuilder const & builder) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = pipelines_.find(builder);
+    return found != pipelines_.end() && found->second->pipeline;
+}
+
+//! @return number of pipelines
+size_t PipelineLibrary::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pipelines_.size();
+}
+
+// Compiles the pipeline on the calling thread unless it exists or is being compiled elsewhere. Never waits.
+void PipelineLibrary::compileIfMissing(PipelineBuilder const & builder)
+{
+    Entry * entry;
+    std::promise<void> compiled;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        removeOutdated();
+        auto found = pipelines_.find(builder);
+        if (found != pipelines_.end())
+            return;
+        found = pipelines_.emplace(builder, std::make_shared<Entry>()).first;
+        found->second->compiling = compiled.get_future().share();
+        entry = found->second.get();
+    }
+
+    compile(builder, *entry);
+    compiled.set_value();
+}
+
+void PipelineLibrary::waitIdle()
+{
+    std::vector<std::shared_future<void>> compiling;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto const & pipeline : pipelines_)
+        {
+            if (pipeline.second->compiling.valid())
+                compiling.push_back(pipeline.second->compiling);
+        }
+    }
+    for (auto & c : compiling)
+    {
+        c.wait();
+    }
+}
+
+// Creates the pipeline without holding the lock, so that other pipelines can be requested and compiled meanwhile
+void PipelineLibrary::compile(PipelineBuilder const & builder, Entry & entry)
+{
+    vk::UniquePipeline pipeline;
+    std::vector<std::pair<std::string, ShaderCache::Module>> shaders;
+    bool failed = false;
+    try
+    {
+        // The modules are looked up first, so a file that changes during the build leaves the entry outdated
+        for (auto const & path : builder.shaderPaths())
+        {
+            shaders.emplace_back(path, device_->shaders().get(path));
+        }
+        pipeline = builder.build(*device_, device_->pipelineCache());
+    }
+    catch (std::exception const &)
+    {
+        failed = true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.pipeline  = std::move(pipeline);
+    entry.failed    = failed;
+    entry.shaders   = std::move(shaders);
+    entry.compiling = std::shared_future<void>();
+}
+
+// Removes the entries built from modules that the shader cache has since replaced. Entries being compiled are checked
+// once they have finished. The caller holds the lock.
+void PipelineLibrary::removeOutdated()
+{
+    ShaderCache & cache = device_->shaders();
+    uint64_t generation = cache.generation();
+    if (generation == shaderGeneration_)
+        return;
+
+    bool compiling = false;
+    for (auto i = pipelines_.begin(); i != pipelines_.end();)
+    {
+        Entry const & entry = *i->second;
+        bool outdated = false;
+        if (entry.compiling.valid())
+        {
+            compiling = true;
+        }
+        else
+        {
+            for (auto const & shader : entry.shaders)
+            {
+                ShaderCache::Module current = cache.find(shader.first);
+                outdated = outdated || (current && current != shader.second);
+            }
+        }
+        if (outdated)
+        {
+            replaced_.push_back(std::move(i->second));
+            i = pipelines_.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // Compilations in progress may have used the old modules, so the entries are checked again later
+    if (!compiling)
+        shaderGeneration_ = generation;
+}
+} // namespace Vkx
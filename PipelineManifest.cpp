@@ -0,0 +1,278 @@
+#include "PipelineManifest.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+char const * const MAGIC = "VkxPipelineManifest";
+int constexpr VERSION    = 1;
+
+// Enumerations are written as integers
+template <typename T>
+int toInt(T value)
+{
+    return static_cast<int>(value);
+}
+
+template <typename T>
+T fromInt(int value)
+{
+    return static_cast<T>(value);
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  name    Name of the layout in manifests
+//! @param  layout  Layout
+void PipelineManifest::addLayout(std::string const & name, vk::PipelineLayout layout)
+{
+    layouts_.byName[name]     = layout;
+    layouts_.byHandle[layout] = name;
+}
+
+//! @param  name        Name of the render pass in manifests
+//! @param  renderPass  Render pass
+void PipelineManifest::addRenderPass(std::string const & name, vk::RenderPass renderPass)
+{
+    renderPasses_.byName[name]         = renderPass;
+    renderPasses_.byHandle[renderPass] = name;
+}
+
+//! Pipelines whose layouts or render passes have not been named are not saved.
+//!
+//! @param  path        Path to the file
+//! @param  builders    States of the pipelines, typically from PipelineLibrary::builders()
+//!
+//! @warning    A std::runtime_error is thrown if the file cannot be written
+void PipelineManifest::save(std::string const & path, std::vector<PipelineBuilder> const & builders) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("Vkx::PipelineManifest::save: failed to open " + path);
+
+    file << MAGIC << ' ' << VERSION << '\n';
+    for (auto const & builder : builders)
+    {
+        auto layout     = layouts_.byHandle.find(builder.layout_);
+        auto renderPass = renderPasses_.byHandle.find(builder.renderPass_);
+        if (layout == layouts_.byHandle.end() || renderPass == renderPasses_.byHandle.end())
+            continue;
+
+        file << "pipeline "
+             << std::quoted(layout->second) << ' '
+             << std::quoted(renderPass->second) << ' '
+             << builder.subpass_ << ' '
+             << toInt(builder.topology_) << ' '
+             << builder.primitiveRestart_ << ' '
+             << toInt(builder.polygonMode_) << ' '
+             << (uint32_t)builder.cullMode_ << ' '
+             << toInt(builder.frontFace_) << ' '
+             << toInt(builder.samples_) << ' '
+             << builder.depthTest_ << ' '
+             << builder.depthWrite_ << ' '
+             << toInt(builder.depthCompare_) << '\n';
+        for (auto const & stage : builder.stages_)
+        {
+            file << "stage " << toInt(stage.stage) << ' ' << std::quoted(stage.entry) << ' ' << std::quoted(stage.path) << '\n';
+
+            // Specialization constants are written as hexadecimal bytes, and apply to the preceding stage
+            Specialization const & specialization = stage.specialization;
+            for (auto const & entry : specialization.entries_)
+            {
+                file << "constant " << entry.constantID << ' ' << std::hex << std::setfill('0');
+                for (size_t i = 0; i < entry.size; ++i)
+                {
+                    file << std::setw(2) << (int)specialization.data_[entry.offset + i];
+                }
+                file << std::dec << std::setfill(' ') << '\n';
+            }
+        }
+        for (auto const & binding : builder.bindings_)
+        {
+            file << "binding " << binding.binding << ' ' << binding.stride << ' ' << toInt(binding.inputRate) << '\n';
+        }
+        for (auto const & attribute : builder.attributes_)
+        {
+            file << "attribute "
+                 << attribute.location << ' '
+                 << attribute.binding << ' '
+                 << toInt(attribute.format) << ' '
+                 << attribute.offset << '\n';
+        }
+        for (auto const & attachment : builder.blendAttachments_)
+        {
+            file << "blend "
+                 << attachment.blendEnable << ' '
+                 << toInt(attachment.srcColorBlendFactor) << ' '
+                 << toInt(attachment.dstColorBlendFactor) << ' '
+                 << toInt(attachment.colorBlendOp) << ' '
+                 << toInt(attachment.srcAlphaBlendFactor) << ' '
+                 << toInt(attachment.dstAlphaBlendFactor) << ' '
+                 << toInt(attachment.alphaBlendOp) << ' '
+                 << (uint32_t)attachment.colorWriteMask << '\n';
+        }
+        for (auto state : builder.dynamicStates_)
+        {
+            file << "dynamic " << toInt(state) << '\n';
+        }
+        file << "end\n";
+    }
+
+    if (!file)
+        throw std::runtime_error("Vkx::PipelineManifest::save: failed to write " + path);
+}
+
+//! A missing file is not an error; it simply has no pipelines. Pipelines whose layouts or render passes have not been named,
+//! or that cannot be parsed, are skipped.
+//!
+//! @param  path    Path to the file
+//!
+//! @return states of the pipelines in the file
+std::vector<PipelineBuilder> PipelineManifest::load(std::string const & path) const
+{
+    std::vector<PipelineBuilder> builders;
+
+    std::ifstream file(path);
+    std::string magic;
+    int version = 0;
+    if (!(file >> magic >> version) || magic != MAGIC || version != VERSION)
+        return builders;
+
+    std::unique_ptr<PipelineBuilder> builder;   // The pipeline being read, or null if it is being skipped
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string type;
+        if (!(fields >> type))
+            continue;
+
+        if (type == "pipeline")
+        {
+            std::string layoutName;
+            std::string renderPassName;
+            uint32_t subpass;
+            int topology, polygonMode, frontFace, samples, compare;
+            uint32_t cullMode;
+            bool restart, depthTest, depthWrite;
+            fields >> std::quoted(layoutName) >> std::quoted(renderPassName) >> subpass >> topology >> restart >> polygonMode
+                   >> cullMode >> frontFace >> samples >> depthTest >> depthWrite >> compare;
+
+            auto layout     = layouts_.byName.find(layoutName);
+            auto renderPass = renderPasses_.byName.find(renderPassName);
+            if (!fields || layout == layouts_.byName.end() || renderPass == renderPasses_.byName.end())
+            {
+                builder.reset();
+                continue;
+            }
+            builder = std::make_unique<PipelineBuilder>(layout->second, renderPass->second, subpass);
+            builder->topology(fromInt<vk::PrimitiveTopology>(topology), restart)
+                .rasterization(fromInt<vk::PolygonMode>(polygonMode),
+                               vk::CullModeFlags(cullMode),
+                               fromInt<vk::FrontFace>(frontFace))
+                .samples(fromInt<vk::SampleCountFlagBits>(samples))
+                .depthTest(depthTest, depthWrite, fromInt<vk::CompareOp>(compare));
+        }
+        else if (!builder)
+        {
+            continue;
+        }
+        else if (type == "stage")
+        {
+            int stage;
+            std::string entry;
+            std::string shader;
+            if (fields >> stage >> std::quoted(entry) >> std::quoted(shader))
+                builder->shader(fromInt<vk::ShaderStageFlagBits>(stage), shader, entry);
+            else
+                builder.reset();
+        }
+        else if (type == "constant")
+        {
+            uint32_t id;
+            std::string hex;
+            std::vector<uint8_t> value;
+            if (fields >> id >> hex &&
+                !builder->stages_.empty() &&
+                hex.size() % 2 == 0 &&
+                std::all_of(hex.begin(), hex.end(), [] (char c) { return isxdigit((unsigned char)c) != 0; }))
+            {
+                for (size_t i = 0; i < hex.size(); i += 2)
+                {
+                    value.push_back((uint8_t)std::stoul(hex.substr(i, 2), nullptr, 16));
+                }
+                builder->stages_.back().specialization.set(id, value.data(), value.size());
+            }
+            else
+            {
+                builder.reset();
+            }
+        }
+        else if (type == "binding")
+        {
+            uint32_t binding, stride;
+            int rate;
+            if (fields >> binding >> stride >> rate)
+                builder->vertexBinding(binding, stride, fromInt<vk::VertexInputRate>(rate));
+            else
+                builder.reset();
+        }
+        else if (type == "attribute")
+        {
+            uint32_t location, binding, offset;
+            int format;
+            if (fields >> location >> binding >> format >> offset)
+                builder->vertexAttribute(location, binding, fromInt<vk::Format>(format), offset);
+            else
+                builder.reset();
+        }
+        else if (type == "blend")
+        {
+            uint32_t enable, mask;
+            int srcColor, dstColor, colorOp, srcAlpha, dstAlpha, alphaOp;
+            if (fields >> enable >> srcColor >> dstColor >> colorOp >> srcAlpha >> dstAlpha >> alphaOp >> mask)
+            {
+                builder->blend(vk::PipelineColorBlendAttachmentState(enable,
+                                                                     fromInt<vk::BlendFactor>(srcColor),
+                                                                     fromInt<vk::BlendFactor>(dstColor),
+                                                                     fromInt<vk::BlendOp>(colorOp),
+                                                                     fromInt<vk::BlendFactor>(srcAlpha),
+                                                                     fromInt<vk::BlendFactor>(dstAlpha),
+                                                                     fromInt<vk::BlendOp>(alphaOp),
+                                                                     vk::ColorComponentFlags(mask)));
+            }
+            else
+            {
+                builder.reset();
+            }
+        }
+        else if (type == "dynamic")
+        {
+            int state;
+            if (fields >> state)
+                builder->dynamicState(fromInt<vk::DynamicState>(state));
+            else
+                builder.reset();
+        }
+        else if (type == "end")
+        {
+            builders.push_back(*builder);
+            builder.reset();
+        }
+        else
+        {
+            builder.reset();
+        }
+    }
+    return builders;
+}
+} // namespace Vkx
@@ -0,0 +1,575 @@
+#include "PixelCopy.h"
+
+#include "Vkx.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define VKX_PIXELCOPY_SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define VKX_PIXELCOPY_TARGET(isa)
+#else
+#include <cpuid.h>
+#define VKX_PIXELCOPY_TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VKX_PIXELCOPY_NEON
+#endif
+
+namespace
+{
+#if defined(VKX_PIXELCOPY_SSE2)
+// Instruction sets beyond SSE2 that the CPU and OS support. The kernels that use them are compiled for them individually, so
+// they are chosen at run time regardless of the compiler's target flags.
+struct CpuFeatures
+{
+    bool ssse3 = false;
+    bool avx2  = false;
+    bool f16c  = false;
+};
+
+void cpuid(unsigned leaf, unsigned registers[4])
+{
+#if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int *>(registers), (int)leaf, 0);
+#else
+    __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features;
+    unsigned    registers[4];
+    cpuid(0, registers);
+    unsigned maxLeaf = registers[0];
+    if (maxLeaf < 1)
+        return features;
+
+    cpuid(1, registers);
+    features.ssse3 = (registers[2] & (1u << 9)) != 0;
+
+    // AVX registers are only usable if the OS saves them (OSXSAVE, and XCR0 enables the SSE and AVX state)
+    bool avx = (registers[2] & (1u << 28)) && (registers[2] & (1u << 27));
+    if (avx)
+    {
+#if defined(_MSC_VER)
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned low;
+        unsigned high;
+        __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        unsigned long long xcr0 = ((unsigned long long)high << 32) | low;
+#endif
+        avx = (xcr0 & 6) == 6;
+    }
+    features.f16c = avx && (registers[2] & (1u << 29));
+    if (avx && maxLeaf >= 7)
+    {
+        cpuid(7, registers);
+        features.avx2 = (registers[1] & (1u << 5)) != 0;
+    }
+    return features;
+}
+
+CpuFeatures const & cpu()
+{
+    static CpuFeatures const features = detectCpuFeatures();
+    return features;
+}
+
+// Copies a row with non-temporal stores. Mapped device memory is usually write-combined, so streaming whole 64-byte lines
+// past the cache is faster than memcpy and does not evict the caller's data.
+void copyRow(uint8_t * dst, uint8_t const * src, size_t size)
+{
+    // Write up to the first 16-byte boundary of the destination normally
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+    dst  += head;
+    src  += head;
+    size -= head;
+
+    for (; size >= 64; size -= 64, src += 64, dst += 64)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst), a);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 48), d);
+    }
+    for (; size >= 16; size -= 16, src += 16, dst += 16)
+    {
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst), _mm_loadu_si128(reinterpret_cast<__m128i const *>(src)));
+    }
+    memcpy(dst, src, size);
+}
+
+void finish()
+{
+    // Non-temporal stores are weakly ordered, so they must be fenced before the GPU is told about them
+    _mm_sfence();
+}
+#elif defined(VKX_PIXELCOPY_NEON)
+void copyRow(uint8_t * dst, uint8_t const * src, size_t size)
+{
+    for (; size >= 64; size -= 64, src += 64, dst += 64)
+    {
+        uint8x16_t a = vld1q_u8(src);
+        uint8x16_t b = vld1q_u8(src + 16);
+        uint8x16_t c = vld1q_u8(src + 32);
+        uint8x16_t d = vld1q_u8(src + 48);
+        vst1q_u8(dst, a);
+        vst1q_u8(dst + 16, b);
+        vst1q_u8(dst + 32, c);
+        vst1q_u8(dst + 48, d);
+    }
+    for (; size >= 16; size -= 16, src += 16, dst += 16)
+    {
+        vst1q_u8(dst, vld1q_u8(src));
+    }
+    memcpy(dst, src, size);
+}
+
+void finish()
+{
+}
+#else
+void copyRow(uint8_t * dst, uint8_t const * src, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+void finish()
+{
+}
+#endif
+
+enum class Conversion
+{
+    eNone,          // Same format
+    eRgbToRgba,     // RGB8 -> RGBA8, alpha = 1
+    eRgbToBgra,     // RGB8 -> BGRA8, alpha = 1
+    eSwapRedBlue,   // BGRA8 <-> RGBA8
+    eFloatToHalf    // 32-bit float -> 16-bit float, per channel
+};
+
+// Returns the conversion between two formats and sets the number of channels, or throws if there is none
+Conversion conversion(vk::Format srcFormat, vk::Format dstFormat, uint32_t & channels)
+{
+    channels = 0;
+    if (srcFormat == dstFormat)
+        return Conversion::eNone;
+
+    switch (srcFormat)
+    {
+        case vk::Format::eR8G8B8Unorm:
+            if (dstFormat == vk::Format::eR8G8B8A8Unorm)
+                return Conversion::eRgbToRgba;
+            if (dstFormat == vk::Format::eB8G8R8A8Unorm)
+                return Conversion::eRgbToBgra;
+            break;
+        case vk::Format::eR8G8B8Srgb:
+            if (dstFormat == vk::Format::eR8G8B8A8Srgb)
+                return Conversion::eRgbToRgba;
+            if (dstFormat == vk::Format::eB8G8R8A8Srgb)
+                return Conversion::eRgbToBgra;
+            break;
+        case vk::Format::eB8G8R8A8Unorm:
+            if (dstFormat == vk::Format::eR8G8B8A8Unorm)
+                return Conversion::eSwapRedBlue;
+            break;
+        case vk::Format::eB8G8R8A8Srgb:
+            if (dstFormat == vk::Format::eR8G8B8A8Srgb)
+                return Conversion::eSwapRedBlue;
+            break;
+        case vk::Format::eR8G8B8A8Unorm:
+            if (dstFormat == vk::Format::eB8G8R8A8Unorm)
+                return Conversion::eSwapRedBlue;
+            break;
+        case vk::Format::eR8G8B8A8Srgb:
+            if (dstFormat == vk::Format::eB8G8R8A8Srgb)
+                return Conversion::eSwapRedBlue;
+            break;
+        case vk::Format::eR32Sfloat:
+            channels = 1;
+            if (dstFormat == vk::Format::eR16Sfloat)
+                return Conversion::eFloatToHalf;
+            break;
+        case vk::Format::eR32G32Sfloat:
+            channels = 2;
+            if (dstFormat == vk::Format::eR16G16Sfloat)
+                return Conversion::eFloatToHalf;
+            break;
+        case vk::Format::eR32G32B32A32Sfloat:
+            channels = 4;
+            if (dstFormat == vk::Format::eR16G16B16A16Sfloat)
+                return Conversion::eFloatToHalf;
+            break;
+        default:
+            break;
+    }
+    throw std::invalid_argument("Vkx::convertRows: unsupported conversion");
+}
+
+#if defined(VKX_PIXELCOPY_SSE2)
+// The vectorized kernels convert a prefix of the texels and return its length. The caller converts the rest.
+
+VKX_PIXELCOPY_TARGET("ssse3")
+uint32_t rgbToRgbaSsse3(uint8_t * dst, uint8_t const * src, uint32_t n, bool bgra)
+{
+    __m128i shuffle = bgra ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+                           : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+    // Each load reads 16 bytes to use 12, so the loop stops while at least 6 texels remain
+    uint32_t i = 0;
+    for (; i + 6 <= n; i += 4)
+    {
+        __m128i rgb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 3));
+        __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), rgba);
+    }
+    return i;
+}
+
+VKX_PIXELCOPY_TARGET("avx2")
+uint32_t rgbToRgbaAvx2(uint8_t * dst, uint8_t const * src, uint32_t n, bool bgra)
+{
+    // The shuffle works within each 128-bit lane, so each lane is loaded with the 4 texels it expands
+    __m256i shuffle = bgra ? _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                              2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+                           : _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                              0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+
+    // The second load reads 16 bytes to use 12, so the loop stops while at least 10 texels remain
+    uint32_t i = 0;
+    for (; i + 10 <= n; i += 8)
+    {
+        __m128i low  = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 3));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 3 + 12));
+        __m256i rgb  = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), rgba);
+    }
+    return i;
+}
+
+VKX_PIXELCOPY_TARGET("avx2")
+uint32_t swapRedBlueAvx2(uint8_t * dst, uint8_t const * src, uint32_t n)
+{
+    __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                       2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), _mm256_shuffle_epi8(x, shuffle));
+    }
+    return i;
+}
+
+VKX_PIXELCOPY_TARGET("avx,f16c")
+uint32_t floatToHalfF16c(uint8_t * dst, uint8_t const * src, uint32_t n)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 f = _mm256_loadu_ps(reinterpret_cast<float const *>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2), _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT));
+    }
+    return i;
+}
+#endif
+
+// Expands n RGB texels to RGBA or BGRA with opaque alpha
+void rgbToRgba(uint8_t * dst, uint8_t const * src, uint32_t n, bool bgra)
+{
+    uint32_t i = 0;
+#if defined(VKX_PIXELCOPY_SSE2)
+    if (cpu().avx2)
+        i = rgbToRgbaAvx2(dst, src, n, bgra);
+    else if (cpu().ssse3)
+        i = rgbToRgbaSsse3(dst, src, n, bgra);
+#elif defined(VKX_PIXELCOPY_NEON)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+        uint8x16x4_t rgba;
+        rgba.val[0] = bgra ? rgb.val[2] : rgb.val[0];
+        rgba.val[1] = rgb.val[1];
+        rgba.val[2] = bgra ? rgb.val[0] : rgb.val[2];
+        rgba.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(dst + i * 4, rgba);
+    }
+#endif
+    int r = bgra ? 2 : 0;
+    int b = bgra ? 0 : 2;
+    for (; i < n; ++i)
+    {
+        dst[i * 4 + r] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + b] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 0xff;
+    }
+}
+
+// Swaps the first and third bytes of n 4-byte texels
+void swapRedBlue(uint8_t * dst, uint8_t const * src, uint32_t n)
+{
+    uint32_t i = 0;
+#if defined(VKX_PIXELCOPY_SSE2)
+    if (cpu().avx2)
+        i = swapRedBlueAvx2(dst, src, n);
+
+    __m128i greenAlpha = _mm_set1_epi32((int)0xff00ff00);
+    __m128i low        = _mm_set1_epi32(0x000000ff);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i * 4));
+        __m128i y = _mm_or_si128(_mm_and_si128(x, greenAlpha),
+                                 _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 16), low),
+                                              _mm_slli_epi32(_mm_and_si128(x, low), 16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), y);
+    }
+#elif defined(VKX_PIXELCOPY_NEON)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16x4_t x = vld4q_u8(src + i * 4);
+        uint8x16_t   t = x.val[0];
+        x.val[0] = x.val[2];
+        x.val[2] = t;
+        vst4q_u8(dst + i * 4, x);
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        uint8_t t = src[i * 4 + 0];
+        dst[i * 4 + 0] = src[i * 4 + 2];
+        dst[i * 4 + 1] = src[i * 4 + 1];
+        dst[i * 4 + 2] = t;
+        dst[i * 4 + 3] = src[i * 4 + 3];
+    }
+}
+
+// Converts a float to a half, rounding to nearest even. NaNs stay NaNs and values that are too large become infinities.
+uint16_t floatToHalf(float value)
+{
+    uint32_t constexpr INFINITY_32 = 255u << 23;
+    uint32_t constexpr MAX_16      = (127u + 16u) << 23;         // Smallest float that becomes an infinity
+    uint32_t constexpr MIN_NORMAL  = (127u - 14u) << 23;         // Smallest float that becomes a normal half
+    uint32_t constexpr DENORMAL    = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t f;
+    memcpy(&f, &value, sizeof(f));
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    uint32_t h;
+    if (f >= MAX_16)
+    {
+        h = (f > INFINITY_32) ? 0x7e00 : 0x7c00;
+    }
+    else if (f < MIN_NORMAL)
+    {
+        // Adding the magic number shifts the mantissa into place and rounds it
+        float denormal;
+        float magic;
+        memcpy(&denormal, &f, sizeof(f));
+        memcpy(&magic, &DENORMAL, sizeof(magic));
+        denormal += magic;
+        memcpy(&h, &denormal, sizeof(h));
+        h -= DENORMAL;
+    }
+    else
+    {
+        uint32_t odd = (f >> 13) & 1;
+        f += ((15u - 127u) << 23) + 0xfff + odd;
+        h = f >> 13;
+    }
+    return (uint16_t)(h | (sign >> 16));
+}
+
+#if defined(VKX_PIXELCOPY_SSE2)
+// floatToHalf() for four floats at a time
+__m128i floatToHalf4(__m128 value)
+{
+    __m128i const MAX_16     = _mm_set1_epi32((127 + 16) << 23);
+    __m128i const MIN_NORMAL = _mm_set1_epi32((127 - 14) << 23);
+    __m128i const DENORMAL   = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    __m128i const BIAS       = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128  sign      = _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000)));
+    __m128  magnitude = _mm_xor_ps(value, sign);
+    __m128i f         = _mm_castps_si128(magnitude);
+
+    __m128i isNaN    = _mm_castps_si128(_mm_cmpunord_ps(magnitude, magnitude));
+    __m128i special  = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+    __m128i regular  = _mm_cmpgt_epi32(MAX_16, f);
+    __m128i denormal = _mm_cmpgt_epi32(MIN_NORMAL, f);
+
+    __m128i d = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(magnitude, _mm_castsi128_ps(DENORMAL))), DENORMAL);
+    __m128i odd = _mm_srai_epi32(_mm_slli_epi32(f, 31 - 13), 31);   // -1 if the lowest kept mantissa bit is set
+    __m128i n   = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(f, BIAS), odd), 13);
+
+    __m128i h = _mm_or_si128(_mm_and_si128(denormal, d), _mm_andnot_si128(denormal, n));
+    h = _mm_or_si128(_mm_and_si128(regular, h), _mm_andnot_si128(regular, special));
+    return _mm_or_si128(h, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+// Converts n floats to halfs
+void floatToHalf(uint8_t * dst, uint8_t const * src, uint32_t n)
+{
+    uint32_t i = 0;
+#if defined(VKX_PIXELCOPY_SSE2)
+    if (cpu().f16c)
+        i = floatToHalfF16c(dst, src, n);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i a = floatToHalf4(_mm_loadu_ps(reinterpret_cast<float const *>(src + i * 4)));
+        __m128i b = floatToHalf4(_mm_loadu_ps(reinterpret_cast<float const *>(src + i * 4 + 16)));
+
+        // Sign-extend so that the signed saturating pack keeps all 16 bits
+        a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+        b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2), _mm_packs_epi32(a, b));
+    }
+#elif defined(VKX_PIXELCOPY_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    for (; i + 4 <= n; i += 4)
+    {
+        float16x4_t h = vcvt_f16_f32(vld1q_f32(reinterpret_cast<float const *>(src + i * 4)));
+        vst1_u16(reinterpret_cast<uint16_t *>(dst + i * 2), vreinterpret_u16_f16(h));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float f;
+        memcpy(&f, src + i * 4, sizeof(f));
+        uint16_t h = floatToHalf(f);
+        memcpy(dst + i * 2, &h, sizeof(h));
+    }
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! If both pitches equal the row size, the rows are copied as one block.
+//!
+//! @param  dst         Where to copy the first row to
+//! @param  dstPitch    Distance between the starts of rows in the destination
+//! @param  src         First row to copy
+//! @param  srcPitch    Distance between the starts of rows in the source
+//! @param  rowSize     Number of bytes to copy from each row
+//! @param  rows        Number of rows to copy
+void copyRows(void *       dst,
+              size_t       dstPitch,
+              void const * src,
+              size_t       srcPitch,
+              size_t       rowSize,
+              uint32_t     rows)
+{
+    uint8_t *       out = static_cast<uint8_t *>(dst);
+    uint8_t const * in  = static_cast<uint8_t const *>(src);
+    if (dstPitch == rowSize && srcPitch == rowSize)
+    {
+        copyRow(out, in, rowSize * rows);
+    }
+    else
+    {
+        for (uint32_t y = 0; y < rows; ++y)
+        {
+            copyRow(out + y * dstPitch, in + y * srcPitch, rowSize);
+        }
+    }
+    finish();
+}
+
+//! @param  srcFormat   Format of the source texels
+//! @param  dstFormat   Format of the destination texels
+//!
+//! @return true if convertRows() supports the conversion
+bool canConvertRows(vk::Format srcFormat, vk::Format dstFormat)
+{
+    try
+    {
+        uint32_t channels;
+        conversion(srcFormat, dstFormat, channels);
+        return true;
+    }
+    catch (std::invalid_argument const &)
+    {
+        return false;
+    }
+}
+
+//! Supported conversions are:
+//! - RGB8 to RGBA8 or BGRA8, with opaque alpha
+//! - BGRA8 to RGBA8 and RGBA8 to BGRA8
+//! - 32-bit float to 16-bit float, with 1, 2 or 4 channels
+//! - any format to itself
+//!
+//! 8-bit formats must have the same encoding (unorm or sRGB). The conversions are vectorized with NEON, or on x86 with the
+//! best of AVX2, SSSE3, F16C and SSE2 that the CPU supports, whatever the compiler's target flags.
+//!
+//! @param  dst         Where to write the first row to
+//! @param  dstPitch    Distance between the starts of rows in the destination
+//! @param  dstFormat   Format of the destination texels
+//! @param  src         First row to convert
+//! @param  srcPitch    Distance between the starts of rows in the source
+//! @param  srcFormat   Format of the source texels
+//! @param  width       Number of texels in each row
+//! @param  rows        Number of rows to convert
+//!
+//! @warning    A std::invalid_argument is thrown if the conversion is not supported
+void convertRows(void *       dst,
+                 size_t       dstPitch,
+                 vk::Format   dstFormat,
+                 void const * src,
+                 size_t       srcPitch,
+                 vk::Format   srcFormat,
+                 uint32_t     width,
+                 uint32_t     rows)
+{
+    uint32_t   channels;
+    Conversion c = conversion(srcFormat, dstFormat, channels);
+    if (c == Conversion::eNone)
+    {
+        copyRows(dst, dstPitch, src, srcPitch, width * texelSize(srcFormat), rows);
+        return;
+    }
+
+    uint8_t *       out = static_cast<uint8_t *>(dst);
+    uint8_t const * in  = static_cast<uint8_t const *>(src);
+    for (uint32_t y = 0; y < rows; ++y, out += dstPitch, in += srcPitch)
+    {
+        switch (c)
+        {
+            case Conversion::eRgbToRgba:
+                rgbToRgba(out, in, width, false);
+                break;
+            case Conversion::eRgbToBgra:
+                rgbToRgba(out, in, width, true);
+                break;
+            case Conversion::eSwapRedBlue:
+                swapRedBlue(out, in, width);
+                break;
+            default:
+                floatToHalf(out, in, width * channels);
+                break;
+        }
+    }
+}
+} // namespace Vkx
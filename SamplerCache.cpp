@@ -0,0 +1,113 @@
+#include "SamplerCache.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+// FNV-1a
+class Hasher
+{
+public:
+    template <typename T>
+    void add(T value)
+    {
+        uint8_t bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        for (uint8_t b : bytes)
+        {
+            hash_ = (hash_ ^ b) * 0x100000001b3ull;
+        }
+    }
+
+    // -0.0 and 0.0 compare equal, so they must hash equally
+    void add(float value) { add<uint32_t>(value == 0.0f ? 0u : bits(value)); }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    static uint32_t bits(float value)
+    {
+        uint32_t b;
+        memcpy(&b, &value, sizeof(b));
+        return b;
+    }
+
+    uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  device          Logical device that creates the samplers
+//! @param  maxSamplers     Maximum number of samplers that can be created, typically
+//!                         vk::PhysicalDeviceLimits::maxSamplerAllocationCount
+SamplerCache::SamplerCache(vk::Device device, uint32_t maxSamplers)
+    : device_(device)
+    , maxSamplers_(maxSamplers)
+{
+}
+
+//! @param  info    Sampler state. Extension structures are not supported.
+//!
+//! @return sampler, which remains valid until the cache is cleared or destroyed
+//!
+//! @warning    A std::invalid_argument is thrown if info.pNext is not null
+//! @warning    A std::runtime_error is thrown if a new sampler is needed and the maximum number already exist
+vk::Sampler SamplerCache::get(vk::SamplerCreateInfo const & info)
+{
+    if (info.pNext)
+        throw std::invalid_argument("Vkx::SamplerCache::get: extension structures are not supported");
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto i = samplers_.find(info);
+    if (i != samplers_.end())
+        return *i->second;
+
+    if (samplers_.size() >= maxSamplers_)
+        throw std::runtime_error("Vkx::SamplerCache::get: too many samplers");
+
+    vk::UniqueSampler sampler = device_.createSamplerUnique(info);
+    vk::Sampler       result  = *sampler;
+    samplers_.emplace(info, std::move(sampler));
+    return result;
+}
+
+size_t SamplerCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samplers_.size();
+}
+
+//! @warning    None of the samplers may be in use by the GPU.
+void SamplerCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    samplers_.clear();
+}
+
+size_t SamplerCache::Hash::operator ()(vk::SamplerCreateInfo const & info) const
+{
+    Hasher hasher;
+    hasher.add(static_cast<VkSamplerCreateFlags>(info.flags));
+    hasher.add(info.magFilter);
+    hasher.add(info.minFilter);
+    hasher.add(info.mipmapMode);
+    hasher.add(info.addressModeU);
+    hasher.add(info.addressModeV);
+    hasher.add(info.addressModeW);
+    hasher.add(info.mipLodBias);
+    hasher.add(info.anisotropyEnable);
+    hasher.add(info.maxAnisotropy);
+    hasher.add(info.compareEnable);
+    hasher.add(info.compareOp);
+    hasher.add(info.minLod);
+    hasher.add(info.maxLod);
+    hasher.add(info.borderColor);
+    hasher.add(info.unnormalizedCoordinates);
+    return (size_t)hasher.value();
+}
+} // namespace Vkx
@@ -0,0 +1,139 @@
+#include "ShaderCache.h"
+
+#include "Device.h"
+#include "MappedFile.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+// FNV-1a
+uint64_t hashBytes(void const * data, size_t size)
+{
+    uint8_t const * bytes = static_cast<uint8_t const *>(data);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! @param  device      Logical device that creates the modules. Modules returned by the cache keep it alive if it is owned
+//!                     by a std::shared_ptr.
+ShaderCache::ShaderCache(Device & device)
+    : device_(&device)
+{
+}
+
+//! @param  path    Path to a SPIR-V file
+//!
+//! @return shader module
+//!
+//! @warning    A std::runtime_error is thrown if the file cannot be opened
+//! @warning    A std::invalid_argument is thrown if the file is empty or its size is not a multiple of 4 bytes
+ShaderCache::Module ShaderCache::get(std::string const & path)
+{
+    std::error_code error;
+    std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+    uintmax_t size = std::filesystem::file_size(path, error);
+    if (error)
+        throw std::runtime_error("Vkx::ShaderCache::get: failed to open " + path);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto found = files_.find(path);
+    if (found != files_.end() && found->second.modified == modified && found->second.size == size)
+        return share(found->second.module);
+
+    MappedFile contents(path);
+    if (contents.size() == 0 || contents.size() % sizeof(uint32_t) != 0)
+        throw std::invalid_argument("Vkx::ShaderCache::get: " + path + " is not SPIR-V");
+    uint64_t hash = hashBytes(contents.data(), contents.size());
+
+    // The file may have been touched without being changed, or its contents may already be loaded from another file
+    Module module;
+    auto range = byHash_.equal_range(hash);
+    for (auto i = range.first; i != range.second && !module; ++i)
+    {
+        std::vector<uint8_t> const & code = i->second.code;
+        if (code.size() == contents.size() && memcmp(code.data(), contents.data(), code.size()) == 0)
+            module = i->second.module.lock();
+    }
+
+    if (!module)
+    {
+        // The cache's references must not hold the Device, which owns the cache
+        vk::Device device = *device_;
+        vk::ShaderModule created = device.createShaderModule(
+            vk::ShaderModuleCreateInfo({}, contents.size(), static_cast<uint32_t const *>(contents.data())));
+        module = Module(new vk::ShaderModule(created),
+                        [device] (vk::ShaderModule const * m) {
+                            device.destroyShaderModule(*m);
+                            delete m;
+                        });
+        uint8_t const * bytes = static_cast<uint8_t const *>(contents.data());
+        byHash_.emplace(hash, Contents{ std::vector<uint8_t>(bytes, bytes + contents.size()), module });
+    }
+
+    if (found != files_.end() && found->second.module != module)
+    {
+        uint64_t replaced = found->second.hash;
+        found->second.module.reset();
+        auto stale = byHash_.equal_range(replaced);
+        for (auto i = stale.first; i != stale.second;)
+        {
+            i = i->second.module.expired() ? byHash_.erase(i) : std::next(i);
+        }
+        ++generation_;
+    }
+
+    files_[path] = File{ modified, size, hash, module };
+    return share(module);
+}
+
+//! Unlike get(), this does not look at the file, so it does not notice changes.
+//!
+//! @param  path    Path to a SPIR-V file
+//!
+//! @return shader module, or nullptr if the file has not been loaded
+ShaderCache::Module ShaderCache::find(std::string const & path) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = files_.find(path);
+    return (found != files_.end()) ? share(found->second.module) : nullptr;
+}
+
+//! @return number of files
+size_t ShaderCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_.size();
+}
+
+//! Modules that are still referenced elsewhere are not destroyed until they are released.
+void ShaderCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.clear();
+    byHash_.clear();
+}
+
+// Returns a reference to a module that also holds the Device, so that the module cannot outlive it. The reference points to
+// the same vk::ShaderModule as the cache's own.
+ShaderCache::Module ShaderCache::share(Module const & module) const
+{
+    std::shared_ptr<Device> device = device_->weak_from_this().lock();
+    if (!device)
+        return module;
+    auto owner = std::make_shared<std::pair<Module, std::shared_ptr<Device>>>(module, device);
+    return Module(owner, owner->first.get());
+}
+} // namespace Vkx
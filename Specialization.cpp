@@ -0,0 +1,97 @@
+#include "Specialization.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Vkx
+{
+//! If the constant is already set, its value is replaced.
+//!
+//! @param  id      ID of the constant
+//! @param  value   Bytes of the value
+//! @param  size    Size of the value
+//!
+//! @return this specialization
+Specialization & Specialization::set(uint32_t id, void const * value, size_t size)
+{
+    auto entry = std::lower_bound(entries_.begin(),
+                                  entries_.end(),
+                                  id,
+                                  [] (vk::SpecializationMapEntry const & e, uint32_t i) { return e.constantID < i; });
+    if (entry != entries_.end() && entry->constantID == id)
+    {
+        if (entry->size == size)
+        {
+            memcpy(data_.data() + entry->offset, value, size);
+            return *this;
+        }
+
+        // The size has changed, so the old value is removed and the rest of the data is moved down
+        uint32_t offset = entry->offset;
+        size_t removed  = entry->size;
+        data_.erase(data_.begin() + offset, data_.begin() + offset + removed);
+        entry = entries_.erase(entry);
+        for (auto & e : entries_)
+        {
+            if (e.offset > offset)
+                e.offset -= (uint32_t)removed;
+        }
+    }
+
+    entries_.insert(entry, vk::SpecializationMapEntry(id, (uint32_t)data_.size(), size));
+    uint8_t const * bytes = static_cast<uint8_t const *>(value);
+    data_.insert(data_.end(), bytes, bytes + size);
+    return *this;
+}
+
+//! @return specialization info, which remains valid until this object is changed or destroyed
+vk::SpecializationInfo Specialization::info() const
+{
+    return vk::SpecializationInfo((uint32_t)entries_.size(), entries_.data(), data_.size(), data_.data());
+}
+
+//! @return hash of the constants and their values
+size_t Specialization::hash() const
+{
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&hash] (void const * data, size_t size) {
+                   uint8_t const * bytes = static_cast<uint8_t const *>(data);
+                   for (size_t i = 0; i < size; ++i)
+                   {
+                       hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+                   }
+               };
+    for (auto const & entry : entries_)
+    {
+        add(&entry.constantID, sizeof(entry.constantID));
+        add(data_.data() + entry.offset, entry.size);
+    }
+    return (size_t)hash;
+}
+
+//! Constants are compared by ID and value, regardless of the order in which they were set.
+//!
+//! @param  rhs     Specialization to compare with
+//!
+//! @return true if the same constants are set to the same values
+bool Specialization::operator ==(Specialization const & rhs) const
+{
+    if (entries_.size() != rhs.entries_.size())
+        return false;
+    for (size_t i = 0; i < entries_.size(); ++i)
+    {
+        vk::SpecializationMapEntry const & a = entries_[i];
+        vk::SpecializationMapEntry const & b = rhs.entries_[i];
+        if (a.constantID != b.constantID ||
+            a.size != b.size ||
+            memcmp(data_.data() + a.offset, rhs.data_.data() + b.offset, a.size) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace Vkx
@@ -0,0 +1,170 @@
+#include "StreamingTexture.h"
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Image.h"
+#include "Vkx.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace Vkx
+{
+//! @param  device      Logical device associated with the texture
+//! @param  format      Format of the frames
+//! @param  width       Width of the frames
+//! @param  height      Height of the frames
+//! @param  depth       Number of images in the ring (default: DEFAULT_DEPTH)
+//!
+//! @warning    A std::invalid_argument is thrown if the depth is less than 2 or the format is not supported by texelSize()
+StreamingTexture::StreamingTexture(std::shared_ptr<Device> device,
+                                   vk::Format              format,
+                                   uint32_t                width,
+                                   uint32_t                height,
+                                   uint32_t                depth /*= DEFAULT_DEPTH*/)
+    : device_(device)
+    , frameSize_(size_t(width) * height * texelSize(format))
+{
+    if (depth < 2)
+        throw std::invalid_argument("Vkx::StreamingTexture: the depth must be at least 2");
+
+    // Each region starts on a boundary that satisfies the copy's alignment requirements
+    size_t alignment = copyAlignment(format);
+    size_t stride    = (frameSize_ + alignment - 1) / alignment * alignment;
+    staging_ = HostBuffer(device_, stride * depth, vk::BufferUsageFlagBits::eTransferSrc);
+
+    vk::ImageCreateInfo info({},
+                             vk::ImageType::e2D,
+                             format,
+                             vk::Extent3D(width, height, 1),
+                             1,
+                             1,
+                             vk::SampleCountFlagBits::e1,
+                             vk::ImageTiling::eOptimal,
+                             vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled);
+    slots_.reserve(depth);
+    for (uint32_t i = 0; i < depth; ++i)
+    {
+        vk::UniqueEvent uploaded = device_->createEventUnique(vk::EventCreateInfo());
+        slots_.push_back({ LocalImage(device_, info), i * stride, std::move(uploaded), false, State::eFree, false });
+    }
+}
+
+//! If the renderer has not yet uploaded the previous frame, that frame is dropped in favor of this one. The call blocks only
+//! if the GPU is still copying from the staging region being reused. The host cannot wait for an event, so it polls.
+//!
+//! @return address of the staging region for the frame's tightly-packed texels. It is valid until endWrite() is called.
+//!
+//! @warning    Only one thread may produce frames, and beginWrite() and endWrite() must alternate.
+void * StreamingTexture::beginWrite()
+{
+    vk::Event uploaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Prefer a free slot, starting with the least recently used one, and otherwise replace the unconsumed frame
+        uint32_t n      = (uint32_t)slots_.size();
+        uint32_t chosen = n;
+        for (uint32_t i = 0; i < n && chosen == n; ++i)
+        {
+            uint32_t s = (next_ + i) % n;
+            if (slots_[s].state == State::eFree)
+                chosen = s;
+        }
+        for (uint32_t s = 0; s < n && chosen == n; ++s)
+        {
+            if (slots_[s].state == State::eReady)
+                chosen = s;
+        }
+
+        writing_ = chosen;
+        next_    = (chosen + 1) % n;
+        slots_[chosen].state = State::eWriting;
+        if (slots_[chosen].uploading)
+            uploaded = *slots_[chosen].uploaded;
+        slots_[chosen].uploading = false;
+    }
+
+    // Wait for the previous upload from this region, if any, to finish
+    if (uploaded)
+    {
+        while (device_->getEventStatus(uploaded) == vk::Result::eEventReset)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    return static_cast<uint8_t *>(staging_.data()) + slots_[writing_].offset;
+}
+
+//! The frame replaces any frame that has been written but not uploaded yet.
+void StreamingTexture::endWrite()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto & slot : slots_)
+    {
+        if (slot.state == State::eReady)
+            slot.state = State::eFree;
+    }
+    slots_[writing_].state = State::eReady;
+}
+
+//! If a new frame has been written, the commands to upload it are recorded and it becomes the image to sample. The copy is
+//! ordered after earlier reads of the image by a pipeline barrier, and before the fragment shader reads it in this frame.
+//! The commands then set the region's event, which beginWrite() waits for before reusing the region.
+//!
+//! @param  commands    Command buffer of the frame that samples the image. It must be outside of a render pass, and it
+//!                     must be submitted.
+//!
+//! @return image to sample, or nullptr if no frame has been written yet
+LocalImage const * StreamingTexture::acquire(vk::CommandBuffer & commands)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Slot * ready     = nullptr;
+    Slot * displayed = nullptr;
+    for (auto & slot : slots_)
+    {
+        if (slot.state == State::eReady)
+            ready = &slot;
+        else if (slot.state == State::eDisplayed)
+            displayed = &slot;
+    }
+
+    if (ready)
+    {
+        // The producer has waited for the region's previous upload, so the GPU is done with the event
+        device_->resetEvent(*ready->uploaded);
+
+        vk::BufferImageCopy region(ready->offset,
+                                   0,
+                                   0,
+                                   vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                                   vk::Offset3D(0, 0, 0),
+                                   ready->image.info().extent);
+
+        // The whole image is replaced, but earlier frames may still be sampling it, so its layout is not discarded
+        ready->image.transitionLayout(commands,
+                                      ready->initialized ? vk::ImageLayout::eShaderReadOnlyOptimal
+                                                         : vk::ImageLayout::eUndefined,
+                                      vk::ImageLayout::eTransferDstOptimal);
+        ready->image.copy(commands, staging_, { region });
+        ready->image.transitionLayout(commands,
+                                      vk::ImageLayout::eTransferDstOptimal,
+                                      vk::ImageLayout::eShaderReadOnlyOptimal);
+        commands.setEvent(*ready->uploaded, vk::PipelineStageFlagBits::eTransfer);
+
+        ready->initialized = true;
+        ready->uploading   = true;
+        ready->state       = State::eDisplayed;
+        if (displayed)
+            displayed->state = State::eFree;
+        displayed = ready;
+    }
+
+    return displayed ? &displayed->image : nullptr;
+}
+} // namespace Vkx
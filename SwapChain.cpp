@@ -2,81 +2,56 @@
 
 #include "Device.h"
 
-#include <memory>
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
 namespace Vkx
 {
+//! Fewer frames in flight reduce the latency between input and display, and more frames keep the GPU busier.
+//!
+//! @param  device          Logical device that creates the swap chain
+//! @param  surfaceFormat   Format of the images
+//! @param  extent          Extent of the images
+//! @param  graphicsFamily  Family of the queues that render to the images
+//! @param  presentFamily   Family of the queue that presents the images
+//! @param  presentMode     Presentation mode
+//! @param  framesInFlight  Number of frames that can be in flight at once, in [1, MAX_FRAMES_IN_FLIGHT]
+//!                         (default: DEFAULT_FRAMES_IN_FLIGHT)
+//!
+//! @warning    A std::invalid_argument is thrown if framesInFlight is out of range
 SwapChain::SwapChain(std::shared_ptr<Device>      device,
                      vk::SurfaceFormatKHR const & surfaceFormat,
                      vk::Extent2D                 extent,
                      uint32_t                     graphicsFamily,
                      uint32_t                     presentFamily,
-                     vk::PresentModeKHR           presentMode)
+                     vk::PresentModeKHR           presentMode,
+                     int                          framesInFlight /*= DEFAULT_FRAMES_IN_FLIGHT*/)
     : device_(device)
+    , format_(surfaceFormat.format)
+    , colorSpace_(surfaceFormat.colorSpace)
+    , families_{ graphicsFamily, presentFamily }
+    , presentMode_(presentMode)
 {
-    std::shared_ptr<PhysicalDevice> physicalDevice = device->physical();
-    vk::SurfaceKHR surface = physicalDevice->surface();
-    vk::SurfaceCapabilitiesKHR capabilities = physicalDevice->getSurfaceCapabilitiesKHR(surface);
-    uint32_t nImages = capabilities.minImageCount + 1;
-    if (capabilities.maxImageCount > 0 && nImages > capabilities.maxImageCount)
-        nImages = capabilities.maxImageCount;
+    if (framesInFlight < 1 || framesInFlight > MAX_FRAMES_IN_FLIGHT)
+        throw std::invalid_argument("SwapChain::SwapChain: framesInFlight must be in [1, MAX_FRAMES_IN_FLIGHT]");
 
-    vk::SwapchainCreateInfoKHR createInfo({},
-                                          surface,
-                                          nImages,
-                                          surfaceFormat.format,
-                                          surfaceFormat.colorSpace,
-                                          extent,
-                                          1,
-                                          vk::ImageUsageFlagBits::eColorAttachment);
+    create(extent, nullptr);
 
-    uint32_t queueFamilyIndices[] =
-    {
-        graphicsFamily,
-        presentFamily
-    };
+    imageAvailableSemaphores_.reserve(framesInFlight + 1);
+    inFlightFences_.reserve(framesInFlight);
 
-    if (graphicsFamily != presentFamily)
-    {
-        createInfo.imageSharingMode      = vk::SharingMode::eConcurrent;
-        createInfo.queueFamilyIndexCount = 2;
-        createInfo.pQueueFamilyIndices   = queueFamilyIndices;
-    }
-    else
+    // One more image-available semaphore than frames, so that the next image can be acquired while every frame is in flight
+    for (int i = 0; i <= framesInFlight; ++i)
     {
-        createInfo.imageSharingMode = vk::SharingMode::eExclusive;
-    }
-    createInfo.preTransform = capabilities.currentTransform;
-    createInfo.presentMode  = presentMode;
-    createInfo.clipped      = VK_TRUE;
-
-    swapChain_ = device->createSwapchainKHRUnique(createInfo);
-
-    std::vector<vk::Image> images = device->getSwapchainImagesKHR(*swapChain_);
-    format_ = surfaceFormat.format;
-    extent_ = extent;
-    views_.reserve(images.size());
-    for (auto const & image : images)
-    {
-        views_.push_back(
-            device->createImageViewUnique(
-                vk::ImageViewCreateInfo({},
-                                        image,
-                                        vk::ImageViewType::e2D,
-                                        format_,
-                                        vk::ComponentMapping(),
-                                        vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1))));
+        imageAvailableSemaphores_.push_back(device_->createSemaphoreUnique(vk::SemaphoreCreateInfo()));
+        freeSemaphores_.push_back(i);
     }
-
-    imageAvailableSemaphores_.reserve(MAX_LATENCY);
-    renderFinishedSemaphores_.reserve(MAX_LATENCY);
-    inFlightFences_.reserve(MAX_LATENCY);
-
-    for (int i = 0; i < MAX_LATENCY; ++i)
+    for (int i = 0; i < framesInFlight; ++i)
     {
-        imageAvailableSemaphores_.push_back(device_->createSemaphoreUnique(vk::SemaphoreCreateInfo()));
-        renderFinishedSemaphores_.push_back(device_->createSemaphoreUnique(vk::SemaphoreCreateInfo()));
         inFlightFences_.push_back(device_->createFenceUnique(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled)));
     }
 }
@@ -86,12 +61,23 @@ SwapChain::SwapChain(SwapChain && src)
     : device_(std::move(src.device_))
     , swapChain_(std::move(src.swapChain_))
     , format_(src.format_)
+    , colorSpace_(src.colorSpace_)
     , views_(std::move(src.views_))
     , extent_(src.extent_)
+    , families_{ src.families_[0], src.families_[1] }
+    , presentMode_(src.presentMode_)
+    , retired_(std::move(src.retired_))
     , imageAvailableSemaphores_(std::move(src.imageAvailableSemaphores_))
+    , freeSemaphores_(std::move(src.freeSemaphores_))
+    , imageSemaphores_(std::move(src.imageSemaphores_))
+    , imageFences_(std::move(src.imageFences_))
     , renderFinishedSemaphores_(std::move(src.renderFinishedSemaphores_))
     , inFlightFences_(std::move(src.inFlightFences_))
     , currentFrame_(src.currentFrame_)
+    , currentImage_(src.currentImage_)
+    , currentSemaphore_(src.currentSemaphore_)
+    , suboptimal_(src.suboptimal_)
+    , timing_(src.timing_)
 {
 }
 
@@ -103,35 +89,204 @@ Vkx::SwapChain & SwapChain::operator =(SwapChain && rhs)
         device_ = std::move(rhs.device_);
         swapChain_ = std::move(rhs.swapChain_);
         format_ = std::move(rhs.format_);
+        colorSpace_ = rhs.colorSpace_;
         views_ = std::move(rhs.views_);
         extent_ = std::move(rhs.extent_);
+        families_[0] = rhs.families_[0];
+        families_[1] = rhs.families_[1];
+        presentMode_ = rhs.presentMode_;
+        retired_ = std::move(rhs.retired_);
         imageAvailableSemaphores_ = std::move(rhs.imageAvailableSemaphores_);
+        freeSemaphores_ = std::move(rhs.freeSemaphores_);
+        imageSemaphores_ = std::move(rhs.imageSemaphores_);
+        imageFences_ = std::move(rhs.imageFences_);
         renderFinishedSemaphores_ = std::move(rhs.renderFinishedSemaphores_);
         inFlightFences_ = std::move(rhs.inFlightFences_);
         currentFrame_ = std::move(rhs.currentFrame_);
+        currentImage_ = rhs.currentImage_;
+        currentSemaphore_ = rhs.currentSemaphore_;
+        suboptimal_ = rhs.suboptimal_;
+        timing_ = rhs.timing_;
     }
     return *this;
 }
 
-//! @warning    A std::runtime_error is thrown if the swap fails.
+//! The next image is acquired first, so the CPU does not block on a fence while the presentation engine may still be
+//! holding the image. Then the function waits for the fence of the frame that last rendered to the acquired image (which
+//! may not be the current frame's when the number of images differs from the number of frames in flight), and for the
+//! current frame's fence, which protects the frame's own resources. The CPU time spent acquiring the image and waiting for
+//! the fences is recorded (see timing()).
 //!
-
+//! If the image is acquired but the swap chain no longer matches the surface exactly, suboptimal() returns true afterwards.
+//! The image can still be rendered and presented, but the swap chain should be recreated.
+//!
+//! @return index of the acquired image
+//!
+//! @warning    A std::runtime_error is thrown if the swap fails.
+//! @warning    A vk::OutOfDateKHRError is thrown if the swap chain must be recreated before an image can be acquired.
 uint32_t SwapChain::swap()
 {
     if (!swapChain_)
         throw std::runtime_error("SwapChain::swap: invalidated swap chain!");
-    
-    currentFrame_ = (currentFrame_ + 1) % MAX_LATENCY;
-    device_->waitForFences(1, &(*inFlightFences_[currentFrame_]), VK_TRUE, std::numeric_limits<uint64_t>::max());
-    device_->resetFences(1, &(*inFlightFences_[currentFrame_]));
 
+    // Acquire with a semaphore that has no pending operations
+    if (freeSemaphores_.empty())
+    {
+        freeSemaphores_.push_back(imageAvailableSemaphores_.size());
+        imageAvailableSemaphores_.push_back(device_->createSemaphoreUnique(vk::SemaphoreCreateInfo()));
+    }
+    size_t semaphore = freeSemaphores_.back();
+
+    auto start = std::chrono::steady_clock::now();
     vk::ResultValue<uint32_t> result = device_->acquireNextImageKHR(*swapChain_,
                                                                     std::numeric_limits<uint64_t>::max(),
-                                                                    *imageAvailableSemaphores_[currentFrame_],
+                                                                    *imageAvailableSemaphores_[semaphore],
                                                                     nullptr);
+    timing_.acquire = std::chrono::steady_clock::now() - start;
 
     if (result.result != vk::Result::eSuccess && result.result != vk::Result::eSuboptimalKHR)
         throw std::runtime_error("SwapChain::swap: failed to acquire swap chain image!");
-    return result.value;
+    freeSemaphores_.pop_back();
+    uint32_t image = result.value;
+    suboptimal_    = result.result == vk::Result::eSuboptimalKHR;
+
+    // The frame advances only once an image has been acquired, so a failed acquire skips no frame
+    currentFrame_ = (currentFrame_ + 1) % framesInFlight();
+
+    start = std::chrono::steady_clock::now();
+    vk::Fence frameFence = *inFlightFences_[currentFrame_];
+    vk::Fence imageFence = imageFences_[image];
+    if (imageFence && imageFence != frameFence)
+        device_->waitForFences(1, &imageFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    device_->waitForFences(1, &frameFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    timing_.fenceWait = std::chrono::steady_clock::now() - start;
+    device_->resetFences(1, &frameFence);
+
+    // The frame that last used the image has completed, so its wait on the image's previous semaphore has too
+    if (imageSemaphores_[image] != NO_SEMAPHORE)
+        freeSemaphores_.push_back(imageSemaphores_[image]);
+    imageSemaphores_[image] = semaphore;
+    imageFences_[image]     = frameFence;
+    currentSemaphore_       = semaphore;
+    currentImage_           = image;
+
+    // Every frame that could be using a retired swap chain's images has been waited for once its count reaches 0
+    for (auto & retired : retired_)
+    {
+        --retired.framesLeft;
+    }
+    retired_.erase(std::remove_if(retired_.begin(),
+                                  retired_.end(),
+                                  [] (Retired const & retired) { return retired.framesLeft <= 0; }),
+                   retired_.end());
+
+    return image;
+}
+
+//! The presentation waits on renderFinished(), which the submission that renders to the image must signal. suboptimal()
+//! returns true afterwards if the presentation engine reported that the swap chain no longer matches the surface exactly.
+//!
+//! @param  queue   Queue that presents the image. Its family must be the present family.
+//!
+//! @warning    A vk::OutOfDateKHRError is thrown if the swap chain must be recreated
+void SwapChain::present(vk::Queue const & queue)
+{
+    vk::SwapchainKHR swapChain = *swapChain_;
+    vk::Result result = queue.presentKHR(
+        vk::PresentInfoKHR(1, &(*renderFinishedSemaphores_[currentImage_]), 1, &swapChain, &currentImage_));
+    suboptimal_ = suboptimal_ || result == vk::Result::eSuboptimalKHR;
+}
+
+//! The current swap chain is passed to the new one as its old swap chain, so presentation continues without a gap. It, its
+//! views and its images' render-finished semaphores are kept until the frames that may be using them have retired (see
+//! swap()), so there is no need to wait for the device to be idle. The image-available semaphores of the old images are
+//! retired with them too, and replaced by new semaphores. The new images get new render-finished semaphores, and the fences
+//! are reused.
+//!
+//! @param  extent  New extent, typically the window's new size
+//!
+//! @warning    A std::invalid_argument is thrown if the extent is empty (as it is when a window is minimized)
+//! @warning    Views returned by view() before the call are invalid after it.
+void SwapChain::recreate(vk::Extent2D extent)
+{
+    if (extent.width == 0 || extent.height == 0)
+        throw std::invalid_argument("SwapChain::recreate: empty extent");
+
+    // The old swap chain is retired first, so it is kept even if the new one cannot be created. Its images' semaphores may
+    // still be signaled by acquires that were never waited on, so they are destroyed with it, and new ones take their places.
+    std::vector<vk::UniqueSemaphore> semaphores;
+    for (size_t semaphore : imageSemaphores_)
+    {
+        if (semaphore != NO_SEMAPHORE)
+        {
+            semaphores.push_back(std::move(imageAvailableSemaphores_[semaphore]));
+            imageAvailableSemaphores_[semaphore] = device_->createSemaphoreUnique(vk::SemaphoreCreateInfo());
+            freeSemaphores_.push_back(semaphore);
+        }
+    }
+    retired_.push_back(Retired{ std::move(swapChain_),
+                                std::move(views_),
+                                std::move(semaphores),
+                                std::move(renderFinishedSemaphores_),
+                                framesInFlight() });
+    views_.clear();
+    renderFinishedSemaphores_.clear();
+    suboptimal_ = false;
+    create(extent, *retired_.back().swapChain);
+}
+
+void SwapChain::create(vk::Extent2D extent, vk::SwapchainKHR oldSwapChain)
+{
+    std::shared_ptr<PhysicalDevice> physicalDevice = device_->physical();
+    vk::SurfaceKHR surface = physicalDevice->surface();
+    vk::SurfaceCapabilitiesKHR capabilities = physicalDevice->getSurfaceCapabilitiesKHR(surface);
+    uint32_t nImages = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0 && nImages > capabilities.maxImageCount)
+        nImages = capabilities.maxImageCount;
+
+    vk::SwapchainCreateInfoKHR createInfo({},
+                                          surface,
+                                          nImages,
+                                          format_,
+                                          colorSpace_,
+                                          extent,
+                                          1,
+                                          vk::ImageUsageFlagBits::eColorAttachment);
+
+    if (families_[0] != families_[1])
+    {
+        createInfo.imageSharingMode      = vk::SharingMode::eConcurrent;
+        createInfo.queueFamilyIndexCount = 2;
+        createInfo.pQueueFamilyIndices   = families_;
+    }
+    else
+    {
+        createInfo.imageSharingMode = vk::SharingMode::eExclusive;
+    }
+    createInfo.preTransform = capabilities.currentTransform;
+    createInfo.presentMode  = presentMode_;
+    createInfo.clipped      = VK_TRUE;
+    createInfo.oldSwapchain = oldSwapChain;
+
+    swapChain_ = device_->createSwapchainKHRUnique(createInfo);
+
+    std::vector<vk::Image> images = device_->getSwapchainImagesKHR(*swapChain_);
+    extent_ = extent;
+    imageSemaphores_.assign(images.size(), NO_SEMAPHORE);
+    imageFences_.assign(images.size(), nullptr);
+    views_.reserve(images.size());
+    renderFinishedSemaphores_.reserve(images.size());
+    for (auto const & image : images)
+    {
+        views_.push_back(
+            device_->createImageViewUnique(
+                vk::ImageViewCreateInfo({},
+                                        image,
+                                        vk::ImageViewType::e2D,
+                                        format_,
+                                        vk::ComponentMapping(),
+                                        vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1))));
+        renderFinishedSemaphores_.push_back(device_->createSemaphoreUnique(vk::SemaphoreCreateInfo()));
+    }
 }
 } // namespace Vkx
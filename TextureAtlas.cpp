@@ -0,0 +1,335 @@
+#include "TextureAtlas.h"
+
+#include "Buffer.h"
+#include "Device.h"
+#include "Image.h"
+#include "Vkx.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+uint32_t alignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool contains(vk::Rect2D const & outer, vk::Rect2D const & inner)
+{
+    return inner.offset.x >= outer.offset.x &&
+           inner.offset.y >= outer.offset.y &&
+           inner.offset.x + inner.extent.width <= outer.offset.x + outer.extent.width &&
+           inner.offset.y + inner.extent.height <= outer.offset.y + outer.extent.height;
+}
+
+bool intersects(vk::Rect2D const & a, vk::Rect2D const & b)
+{
+    return a.offset.x < b.offset.x + (int32_t)b.extent.width &&
+           b.offset.x < a.offset.x + (int32_t)a.extent.width &&
+           a.offset.y < b.offset.y + (int32_t)b.extent.height &&
+           b.offset.y < a.offset.y + (int32_t)a.extent.height;
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! If the atlas has more than one mip level, allocations are aligned to 2<sup>mipLevels - 1</sup> texels so that the
+//! textures' edges stay on texel boundaries in every level. A gutter of at least 2<sup>n</sup> texels keeps level n free
+//! of bleeding.
+//!
+//! @param  device      Logical device associated with the atlas
+//! @param  format      Format of the atlas and of the textures inserted into it
+//! @param  width       Width of the atlas
+//! @param  height      Height of the atlas
+//! @param  gutter      Width of the border of replicated texels around each texture (default: 1)
+//! @param  mipLevels   Number of mip levels in the atlas (default: 1)
+//!
+//! @warning    A std::invalid_argument is thrown if the format is not an uncompressed 8-, 16- or 32-bit format
+//! @warning    A std::runtime_error is thrown if the atlas has mip levels and the format does not support linear blitting
+TextureAtlas::TextureAtlas(std::shared_ptr<Device> device,
+                           vk::Format              format,
+                           uint32_t                width,
+                           uint32_t                height,
+                           uint32_t                gutter /*= 1*/,
+                           uint32_t                mipLevels /*= 1*/)
+    : device_(device)
+    , texelSize_(texelSize(format))
+    , gutter_(gutter)
+    , alignment_(1u << (mipLevels - 1))
+{
+    vk::ImageCreateInfo info({},
+                             vk::ImageType::e2D,
+                             format,
+                             vk::Extent3D(width, height, 1),
+                             mipLevels,
+                             1,
+                             vk::SampleCountFlagBits::e1,
+                             vk::ImageTiling::eOptimal,
+                             vk::ImageUsageFlagBits::eTransferSrc |
+                             vk::ImageUsageFlagBits::eTransferDst |
+                             vk::ImageUsageFlagBits::eSampled);
+    image_ = LocalImage(device_, info);
+    if (mipLevels > 1 && !image_.canBlitMipmaps())
+        throw std::runtime_error("Vkx::TextureAtlas: format does not support linear blitting");
+
+    freeRects_.push_back(vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D(width, height)));
+}
+
+//! The texture's texels are copied, along with its gutter, to CPU memory. They are uploaded by the next call to flush().
+//!
+//! @param  width       Width of the texture
+//! @param  height      Height of the texture
+//! @param  texels      Tightly-packed texels of the texture, in the atlas's format
+//!
+//! @return handle of the texture, or INVALID_HANDLE if there is no room for it
+//!
+//! @warning    A std::invalid_argument is thrown if the width or height is 0
+TextureAtlas::Handle TextureAtlas::insert(uint32_t width, uint32_t height, void const * texels)
+{
+    if (width == 0 || height == 0)
+        throw std::invalid_argument("Vkx::TextureAtlas::insert: the texture is empty");
+
+    uint32_t paddedWidth  = width + 2 * gutter_;
+    uint32_t paddedHeight = height + 2 * gutter_;
+    vk::Rect2D allocated;
+    if (!allocate(alignUp(paddedWidth, alignment_), alignUp(paddedHeight, alignment_), allocated))
+        return INVALID_HANDLE;
+
+    Handle handle;
+    if (!freeHandles_.empty())
+    {
+        handle = freeHandles_.back();
+        freeHandles_.pop_back();
+    }
+    else
+    {
+        handle = (Handle)entries_.size();
+        entries_.emplace_back();
+    }
+
+    Entry & entry    = entries_[handle];
+    entry.allocated  = allocated;
+    entry.rect       = vk::Rect2D(vk::Offset2D(allocated.offset.x + gutter_, allocated.offset.y + gutter_),
+                                  vk::Extent2D(width, height));
+    entry.used       = true;
+
+    // Stage the texels, replicating the edges into the gutter
+    size_t offset = staged_.size();
+    size_t rowSize = paddedWidth * texelSize_;
+    staged_.resize(offset + rowSize * paddedHeight);
+    uint8_t const * src = static_cast<uint8_t const *>(texels);
+    for (uint32_t y = 0; y < paddedHeight; ++y)
+    {
+        uint32_t srcY       = (uint32_t)std::min(std::max((int)y - (int)gutter_, 0), (int)height - 1);
+        uint8_t const * in  = src + srcY * width * texelSize_;
+        uint8_t * out       = staged_.data() + offset + y * rowSize;
+        for (uint32_t x = 0; x < gutter_; ++x)
+        {
+            memcpy(out + x * texelSize_, in, texelSize_);
+            memcpy(out + (gutter_ + width + x) * texelSize_, in + (width - 1) * texelSize_, texelSize_);
+        }
+        memcpy(out + gutter_ * texelSize_, in, width * texelSize_);
+    }
+
+    vk::BufferImageCopy region(offset,
+                               0,
+                               0,
+                               vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
+                               vk::Offset3D(allocated.offset.x, allocated.offset.y, 0),
+                               vk::Extent3D(paddedWidth, paddedHeight, 1));
+    uploads_.push_back({ handle, region });
+
+    // The next texture's texels must be aligned for the copy
+    size_t alignment = copyAlignment(image_.info().format);
+    staged_.resize((staged_.size() + alignment - 1) / alignment * alignment);
+
+    allocatedArea_ += uint64_t(allocated.extent.width) * allocated.extent.height;
+    return handle;
+}
+
+//! The texture's space becomes available immediately. Its texels remain in the image until they are overwritten.
+//!
+//! @param  handle  Texture to remove
+void TextureAtlas::remove(Handle handle)
+{
+    Entry & entry = entries_[handle];
+    if (!entry.used)
+        return;
+
+    // A pending upload must not overlap the upload of a texture that takes its place
+    uploads_.erase(std::remove_if(uploads_.begin(),
+                                  uploads_.end(),
+                                  [handle] (Upload const & upload) { return upload.handle == handle; }),
+                   uploads_.end());
+
+    allocatedArea_ -= uint64_t(entry.allocated.extent.width) * entry.allocated.extent.height;
+    entry.used = false;
+    freeHandles_.push_back(handle);
+    rebuildFreeRects();
+}
+
+//! All of the inserted textures are copied from a single staging buffer with one command. If the atlas has mip levels, they
+//! are regenerated afterwards.
+//!
+//! @param  commandPool     Command buffer allocator
+//! @param  queue           Queue used to upload the textures. It must support graphics operations if the atlas has mip
+//!                         levels.
+//!
+//! @warning    The atlas's image must not be in use by the GPU when this function is called.
+void TextureAtlas::flush(vk::CommandPool const & commandPool, vk::Queue const & queue)
+{
+    if (uploads_.empty() && initialized_)
+        return;
+
+    std::vector<vk::BufferImageCopy> regions;
+    regions.reserve(uploads_.size());
+    for (auto const & upload : uploads_)
+    {
+        regions.push_back(upload.region);
+    }
+
+    HostBuffer staging;
+    if (!staged_.empty())
+        staging = HostBuffer(device_, staged_.size(), vk::BufferUsageFlagBits::eTransferSrc, staged_.data());
+
+    executeOnceSynched(device_,
+                       commandPool,
+                       queue,
+                       [this, &staging, &regions] (vk::CommandBuffer & commands) {
+                           image_.transitionLayout(commands,
+                                                   initialized_ ? vk::ImageLayout::eShaderReadOnlyOptimal
+                                                                : vk::ImageLayout::eUndefined,
+                                                   vk::ImageLayout::eTransferDstOptimal);
+                           if (!regions.empty())
+                               image_.copy(commands, staging, regions);
+                           if (image_.info().mipLevels > 1)
+                               image_.generateMipmaps(commands);
+                           else
+                               image_.transitionLayout(commands,
+                                                       vk::ImageLayout::eTransferDstOptimal,
+                                                       vk::ImageLayout::eShaderReadOnlyOptimal);
+                       });
+
+    initialized_ = true;
+    staged_.clear();
+    uploads_.clear();
+}
+
+//! @param  handle  Texture
+//!
+//! @return (left, top, right, bottom) of the texture's texels, in normalized texture coordinates
+glm::vec4 TextureAtlas::uvRect(Handle handle) const
+{
+    vk::Rect2D const & r = entries_[handle].rect;
+    vk::Extent3D size    = image_.info().extent;
+    return glm::vec4(float(r.offset.x) / size.width,
+                     float(r.offset.y) / size.height,
+                     float(r.offset.x + r.extent.width) / size.width,
+                     float(r.offset.y + r.extent.height) / size.height);
+}
+
+//! @return allocated area / total area
+float TextureAtlas::occupancy() const
+{
+    vk::Extent3D size = image_.info().extent;
+    return float(double(allocatedArea_) / (double(size.width) * size.height));
+}
+
+// Finds space using the best short side fit rule
+bool TextureAtlas::allocate(uint32_t width, uint32_t height, vk::Rect2D & allocated)
+{
+    uint32_t bestShortSide = std::numeric_limits<uint32_t>::max();
+    uint32_t bestLongSide  = std::numeric_limits<uint32_t>::max();
+    vk::Rect2D const * best = nullptr;
+    for (auto const & free : freeRects_)
+    {
+        if (free.extent.width < width || free.extent.height < height)
+            continue;
+        uint32_t leftoverX = free.extent.width - width;
+        uint32_t leftoverY = free.extent.height - height;
+        uint32_t shortSide = std::min(leftoverX, leftoverY);
+        uint32_t longSide  = std::max(leftoverX, leftoverY);
+        if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+        {
+            best          = &free;
+            bestShortSide = shortSide;
+            bestLongSide  = longSide;
+        }
+    }
+    if (!best)
+        return false;
+
+    allocated = vk::Rect2D(best->offset, vk::Extent2D(width, height));
+    splitFreeRects(allocated);
+    return true;
+}
+
+// Recomputes the maximal free rectangles from the remaining allocations. Adjacent free space would otherwise stay
+// fragmented after a removal.
+void TextureAtlas::rebuildFreeRects()
+{
+    vk::Extent3D size = image_.info().extent;
+    freeRects_.clear();
+    freeRects_.push_back(vk::Rect2D(vk::Offset2D(0, 0), vk::Extent2D(size.width, size.height)));
+    for (auto const & entry : entries_)
+    {
+        if (entry.used)
+        {
+            splitFreeRects(entry.allocated);
+        }
+    }
+}
+
+// Replaces every free rectangle that overlaps the used rectangle with the maximal rectangles of what remains of it. Only
+// the new pieces can be redundant: an untouched rectangle inside a piece would already have been inside the piece's parent.
+void TextureAtlas::splitFreeRects(vk::Rect2D const & used)
+{
+    int32_t usedRight  = used.offset.x + (int32_t)used.extent.width;
+    int32_t usedBottom = used.offset.y + (int32_t)used.extent.height;
+
+    std::vector<vk::Rect2D> untouched;
+    std::vector<vk::Rect2D> pieces;
+    untouched.reserve(freeRects_.size());
+    for (auto const & free : freeRects_)
+    {
+        if (!intersects(free, used))
+        {
+            untouched.push_back(free);
+            continue;
+        }
+
+        int32_t freeRight  = free.offset.x + (int32_t)free.extent.width;
+        int32_t freeBottom = free.offset.y + (int32_t)free.extent.height;
+        if (used.offset.x > free.offset.x)
+            pieces.push_back(vk::Rect2D(free.offset, vk::Extent2D(used.offset.x - free.offset.x, free.extent.height)));
+        if (usedRight < freeRight)
+            pieces.push_back(vk::Rect2D(vk::Offset2D(usedRight, free.offset.y),
+                                        vk::Extent2D(freeRight - usedRight, free.extent.height)));
+        if (used.offset.y > free.offset.y)
+            pieces.push_back(vk::Rect2D(free.offset, vk::Extent2D(free.extent.width, used.offset.y - free.offset.y)));
+        if (usedBottom < freeBottom)
+            pieces.push_back(vk::Rect2D(vk::Offset2D(free.offset.x, usedBottom),
+                                        vk::Extent2D(free.extent.width, freeBottom - usedBottom)));
+    }
+
+    // Drop the pieces that are contained in another free rectangle
+    for (size_t i = 0; i < pieces.size(); ++i)
+    {
+        bool redundant = std::any_of(untouched.begin(),
+                                     untouched.end(),
+                                     [&pieces, i] (vk::Rect2D const & r) { return contains(r, pieces[i]); });
+        for (size_t j = 0; j < pieces.size() && !redundant; ++j)
+        {
+            // Of two identical pieces, only the first is kept
+            redundant = j != i && contains(pieces[j], pieces[i]) && (j < i || !contains(pieces[i], pieces[j]));
+        }
+        if (!redundant)
+            untouched.push_back(pieces[i]);
+    }
+    freeRects_.swap(untouched);
+}
+} // namespace Vkx
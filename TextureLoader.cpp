@@ -0,0 +1,376 @@
+#include "TextureLoader.h"
+
+#include "Image.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+// Size and dimensions of a format's texel blocks
+struct BlockInfo
+{
+    vk::Format format;
+    uint32_t size;      // Bytes per block
+    uint32_t dimension; // Width and height of a block in texels (1 for uncompressed formats)
+};
+
+// Mapping from DXGI_FORMAT values found in DDS files with a DX10 header
+struct DxgiFormat
+{
+    uint32_t dxgi;
+    BlockInfo block;
+};
+
+DxgiFormat const DXGI_FORMATS[] =
+{
+    {  2, { vk::Format::eR32G32B32A32Sfloat, 16, 1 } },
+    { 10, { vk::Format::eR16G16B16A16Sfloat,  8, 1 } },
+    { 28, { vk::Format::eR8G8B8A8Unorm,       4, 1 } },
+    { 29, { vk::Format::eR8G8B8A8Srgb,        4, 1 } },
+    { 71, { vk::Format::eBc1RgbaUnormBlock,   8, 4 } },
+    { 72, { vk::Format::eBc1RgbaSrgbBlock,    8, 4 } },
+    { 74, { vk::Format::eBc2UnormBlock,      16, 4 } },
+    { 75, { vk::Format::eBc2SrgbBlock,       16, 4 } },
+    { 77, { vk::Format::eBc3UnormBlock,      16, 4 } },
+    { 78, { vk::Format::eBc3SrgbBlock,       16, 4 } },
+    { 80, { vk::Format::eBc4UnormBlock,       8, 4 } },
+    { 81, { vk::Format::eBc4SnormBlock,       8, 4 } },
+    { 83, { vk::Format::eBc5UnormBlock,      16, 4 } },
+    { 84, { vk::Format::eBc5SnormBlock,      16, 4 } },
+    { 87, { vk::Format::eB8G8R8A8Unorm,       4, 1 } },
+    { 91, { vk::Format::eB8G8R8A8Srgb,        4, 1 } },
+    { 95, { vk::Format::eBc6HUfloatBlock,    16, 4 } },
+    { 96, { vk::Format::eBc6HSfloatBlock,    16, 4 } },
+    { 98, { vk::Format::eBc7UnormBlock,      16, 4 } },
+    { 99, { vk::Format::eBc7SrgbBlock,       16, 4 } }
+};
+
+uint32_t constexpr fourCC(char a, char b, char c, char d)
+{
+    return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+}
+
+uint32_t constexpr DDS_MAGIC                = fourCC('D', 'D', 'S', ' ');
+uint32_t constexpr DDS_HEADER_SIZE          = 124;
+uint32_t constexpr DDS_DX10_HEADER_SIZE     = 20;
+uint32_t constexpr DDPF_FOURCC              = 0x4;
+uint32_t constexpr DDPF_RGB                 = 0x40;
+uint32_t constexpr DDSCAPS2_CUBEMAP         = 0x200;
+uint32_t constexpr DDSCAPS2_VOLUME          = 0x200000;
+uint32_t constexpr DDS_RESOURCE_MISC_CUBE   = 0x4;
+uint32_t constexpr DDS_DIMENSION_TEXTURE1D  = 2;
+uint32_t constexpr DDS_DIMENSION_TEXTURE3D  = 4;
+
+uint8_t const KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+size_t constexpr KTX2_HEADER_SIZE       = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+size_t constexpr KTX2_LEVEL_INDEX_SIZE  = 3 * 8;
+size_t constexpr KTX2_DFD_MIN_SIZE      = 4 + 24;    // Total size, and a basic descriptor block with no samples
+
+// Bounds-checked little-endian reader
+class Reader
+{
+public:
+    Reader(void const * contents, size_t size)
+        : data_(static_cast<uint8_t const *>(contents))
+        , size_(size)
+    {
+    }
+
+    template <typename T>
+    T read(size_t offset) const
+    {
+        check(offset, sizeof(T));
+        T value;
+        memcpy(&value, data_ + offset, sizeof(T));
+        return value;
+    }
+
+    uint8_t const * at(size_t offset, size_t size) const
+    {
+        check(offset, size);
+        return data_ + offset;
+    }
+
+private:
+    void check(size_t offset, size_t size) const
+    {
+        if (offset > size_ || size > size_ - offset)
+            throw std::runtime_error("Vkx::loadTexture: the file is truncated");
+    }
+
+    uint8_t const * data_;
+    size_t size_;
+};
+
+uint32_t levelSize(BlockInfo const & block, vk::Extent3D const & extent, uint32_t level)
+{
+    uint32_t width  = std::max(extent.width >> level, 1u);
+    uint32_t height = std::max(extent.height >> level, 1u);
+    uint32_t depth  = std::max(extent.depth >> level, 1u);
+    return ((width + block.dimension - 1) / block.dimension) * ((height + block.dimension - 1) / block.dimension) * depth *
+           block.size;
+}
+
+vk::Extent3D levelExtent(vk::Extent3D const & extent, uint32_t level)
+{
+    return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), std::max(extent.depth >> level, 1u) };
+}
+
+// Size and dimensions of a KTX2 file's texel blocks, from its data format descriptor
+struct Ktx2Block
+{
+    uint32_t size;          // Bytes per block
+    uint32_t dimensions[3]; // Width, height and depth of a block in texels
+};
+
+Ktx2Block ktx2Block(Reader const & file)
+{
+    uint32_t dfdOffset = file.read<uint32_t>(48);
+    uint32_t dfdLength = file.read<uint32_t>(52);
+    if (dfdLength < KTX2_DFD_MIN_SIZE)
+        throw std::runtime_error("Vkx::loadKtx2: the data format descriptor is missing");
+
+    // The basic descriptor block follows the descriptor's total size. Its fourth word holds the block's dimensions minus
+    // one, and its fifth word starts with the number of bytes in the block.
+    uint8_t const * dimensions = file.at((size_t)dfdOffset + 4 + 12, 4);
+    Ktx2Block block{ file.at((size_t)dfdOffset + 4 + 16, 1)[0],
+                     { dimensions[0] + 1u, dimensions[1] + 1u, dimensions[2] + 1u } };
+    if (block.size == 0)
+        throw std::runtime_error("Vkx::loadKtx2: the data format descriptor has no block size");
+    return block;
+}
+
+BlockInfo legacyDdsFormat(Reader const & file)
+{
+    size_t constexpr PIXEL_FORMAT = 4 + 72;
+    uint32_t flags  = file.read<uint32_t>(PIXEL_FORMAT + 4);
+    uint32_t code   = file.read<uint32_t>(PIXEL_FORMAT + 8);
+    uint32_t bits   = file.read<uint32_t>(PIXEL_FORMAT + 12);
+    uint32_t rMask  = file.read<uint32_t>(PIXEL_FORMAT + 16);
+
+    if (flags & DDPF_FOURCC)
+    {
+        switch (code)
+        {
+            case fourCC('D', 'X', 'T', '1'): return { vk::Format::eBc1RgbaUnormBlock, 8, 4 };
+            case fourCC('D', 'X', 'T', '2'):
+            case fourCC('D', 'X', 'T', '3'): return { vk::Format::eBc2UnormBlock, 16, 4 };
+            case fourCC('D', 'X', 'T', '4'):
+            case fourCC('D', 'X', 'T', '5'): return { vk::Format::eBc3UnormBlock, 16, 4 };
+            case fourCC('A', 'T', 'I', '1'):
+            case fourCC('B', 'C', '4', 'U'): return { vk::Format::eBc4UnormBlock, 8, 4 };
+            case fourCC('B', 'C', '4', 'S'): return { vk::Format::eBc4SnormBlock, 8, 4 };
+            case fourCC('A', 'T', 'I', '2'):
+            case fourCC('B', 'C', '5', 'U'): return { vk::Format::eBc5UnormBlock, 16, 4 };
+            case fourCC('B', 'C', '5', 'S'): return { vk::Format::eBc5SnormBlock, 16, 4 };
+            case 113:                        return { vk::Format::eR16G16B16A16Sfloat, 8, 1 }; // D3DFMT_A16B16G16R16F
+            case 116:                        return { vk::Format::eR32G32B32A32Sfloat, 16, 1 }; // D3DFMT_A32B32G32R32F
+        }
+    }
+    else if ((flags & DDPF_RGB) && bits == 32)
+    {
+        if (rMask == 0x000000ff)
+            return { vk::Format::eR8G8B8A8Unorm, 4, 1 };
+        if (rMask == 0x00ff0000)
+            return { vk::Format::eB8G8R8A8Unorm, 4, 1 };
+    }
+    throw std::runtime_error("Vkx::loadDds: unsupported pixel format");
+}
+} // anonymous namespace
+
+namespace Vkx
+{
+//! The file's mip levels, array layers and cube faces are all loaded. Block-compressed (BC1-BC7) and the common uncompressed
+//! formats are supported, in both legacy and DX10 files.
+//!
+//! @param  contents    Contents of the file
+//! @param  size        Size of the contents
+//!
+//! @return the image, with a region for every mip level of every layer
+//!
+//! @warning    A std::runtime_error is thrown if the file is malformed or its format is not supported
+ImageData loadDds(void const * contents, size_t size)
+{
+    Reader file(contents, size);
+    if (file.read<uint32_t>(0) != DDS_MAGIC || file.read<uint32_t>(4) != DDS_HEADER_SIZE)
+        throw std::runtime_error("Vkx::loadDds: not a DDS file");
+
+    uint32_t height    = file.read<uint32_t>(4 + 8);
+    uint32_t width     = file.read<uint32_t>(4 + 12);
+    uint32_t depth     = file.read<uint32_t>(4 + 20);
+    uint32_t mipLevels = std::max(file.read<uint32_t>(4 + 24), 1u);
+    uint32_t caps2     = file.read<uint32_t>(4 + 108);
+    uint32_t code      = file.read<uint32_t>(4 + 72 + 8);
+
+    ImageData data;
+    vk::ImageCreateInfo & info = data.info;
+    BlockInfo block;
+    uint32_t layers = 1;
+    size_t offset   = 4 + DDS_HEADER_SIZE;
+    info.imageType  = vk::ImageType::e2D;
+
+    if (code == fourCC('D', 'X', '1', '0'))
+    {
+        uint32_t dxgi      = file.read<uint32_t>(offset);
+        uint32_t dimension = file.read<uint32_t>(offset + 4);
+        uint32_t misc      = file.read<uint32_t>(offset + 8);
+        layers             = std::max(file.read<uint32_t>(offset + 12), 1u);
+        offset            += DDS_DX10_HEADER_SIZE;
+
+        auto found = std::find_if(std::begin(DXGI_FORMATS),
+                                  std::end(DXGI_FORMATS),
+                                  [dxgi] (DxgiFormat const & f) { return f.dxgi == dxgi; });
+        if (found == std::end(DXGI_FORMATS))
+            throw std::runtime_error("Vkx::loadDds: unsupported DXGI format");
+        block = found->block;
+
+        if (dimension == DDS_DIMENSION_TEXTURE1D)
+            info.imageType = vk::ImageType::e1D;
+        else if (dimension == DDS_DIMENSION_TEXTURE3D)
+            info.imageType = vk::ImageType::e3D;
+        if (misc & DDS_RESOURCE_MISC_CUBE)
+        {
+            layers     *= 6;
+            info.flags |= vk::ImageCreateFlagBits::eCubeCompatible;
+        }
+    }
+    else
+    {
+        block = legacyDdsFormat(file);
+        if (caps2 & DDSCAPS2_CUBEMAP)
+        {
+            layers      = 6;
+            info.flags |= vk::ImageCreateFlagBits::eCubeCompatible;
+        }
+        else if (caps2 & DDSCAPS2_VOLUME)
+        {
+            info.imageType = vk::ImageType::e3D;
+        }
+    }
+
+    info.format      = block.format;
+    info.extent      = vk::Extent3D(width, std::max(height, 1u), (info.imageType == vk::ImageType::e3D) ? std::max(depth, 1u) : 1);
+    info.mipLevels   = mipLevels;
+    info.arrayLayers = layers;
+    info.usage       = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+
+    // DDS files store all of the levels of a layer before the next layer
+    for (uint32_t layer = 0; layer < layers; ++layer)
+    {
+        for (uint32_t level = 0; level < mipLevels; ++level)
+        {
+            uint32_t levelBytes = levelSize(block, info.extent, level);
+            uint8_t const * src = file.at(offset, levelBytes);
+            data.regions.emplace_back(data.pixels.size(),
+                                      0,
+                                      0,
+                                      vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, layer, 1),
+                                      vk::Offset3D(0, 0, 0),
+                                      levelExtent(info.extent, level));
+            data.pixels.insert(data.pixels.end(), src, src + levelBytes);
+            offset += levelBytes;
+        }
+    }
+    return data;
+}
+
+//! Any format that Vulkan supports can be loaded, including BC, ASTC and ETC2. Supercompressed files (Basis Universal, zstd,
+//! and zlib) are not supported. If the file does not contain mip levels, the image has a single level.
+//!
+//! @param  contents    Contents of the file
+//! @param  size        Size of the contents
+//!
+//! @return the image, with a region for every mip level of every layer
+//!
+//! @warning    A std::runtime_error is thrown if the file is malformed or is supercompressed
+ImageData loadKtx2(void const * contents, size_t size)
+{
+    Reader file(contents, size);
+    if (memcmp(file.at(0, sizeof(KTX2_IDENTIFIER)), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+        throw std::runtime_error("Vkx::loadKtx2: not a KTX2 file");
+
+    uint32_t format           = file.read<uint32_t>(12);
+    uint32_t width            = file.read<uint32_t>(20);
+    uint32_t height           = file.read<uint32_t>(24);
+    uint32_t depth            = file.read<uint32_t>(28);
+    uint32_t layers           = std::max(file.read<uint32_t>(32), 1u);
+    uint32_t faces            = file.read<uint32_t>(36);
+    uint32_t mipLevels        = std::max(file.read<uint32_t>(40), 1u);
+    uint32_t supercompression = file.read<uint32_t>(44);
+
+    if (format == 0 || supercompression != 0)
+        throw std::runtime_error("Vkx::loadKtx2: supercompressed files are not supported");
+    if (faces != 1 && faces != 6)
+        throw std::runtime_error("Vkx::loadKtx2: invalid face count");
+
+    ImageData data;
+    vk::ImageCreateInfo & info = data.info;
+    info.imageType   = (depth > 0) ? vk::ImageType::e3D : (height > 0) ? vk::ImageType::e2D : vk::ImageType::e1D;
+    info.format      = static_cast<vk::Format>(format);
+    info.extent      = vk::Extent3D(width, std::max(height, 1u), std::max(depth, 1u));
+    info.mipLevels   = mipLevels;
+    info.arrayLayers = layers * faces;
+    info.usage       = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+    if (faces == 6)
+        info.flags |= vk::ImageCreateFlagBits::eCubeCompatible;
+
+    // A copy's buffer offset must be a multiple of both the block size and 4. Images in a level are packed tightly, so each
+    // one is copied to an aligned offset of its own.
+    Ktx2Block block  = ktx2Block(file);
+    size_t alignment = std::lcm<size_t>(block.size, 4);
+
+    // Each level contains every face of every layer, in that order. The level index points at each level's data.
+    for (uint32_t level = 0; level < mipLevels; ++level)
+    {
+        size_t entry        = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+        uint64_t levelStart = file.read<uint64_t>(entry);
+        uint64_t levelBytes = file.read<uint64_t>(entry + 8);
+        uint8_t const * src = file.at((size_t)levelStart, (size_t)levelBytes);
+
+        vk::Extent3D extent = levelExtent(info.extent, level);
+        uint64_t imageBytes = uint64_t((extent.width + block.dimensions[0] - 1) / block.dimensions[0]) *
+                              ((extent.height + block.dimensions[1] - 1) / block.dimensions[1]) *
+                              ((extent.depth + block.dimensions[2] - 1) / block.dimensions[2]) * block.size;
+        if (levelBytes < imageBytes * info.arrayLayers)
+            throw std::runtime_error("Vkx::loadKtx2: a mip level is smaller than its extent requires");
+
+        for (uint32_t layer = 0; layer < info.arrayLayers; ++layer)
+        {
+            data.pixels.resize((data.pixels.size() + alignment - 1) / alignment * alignment);
+            data.regions.emplace_back(data.pixels.size(),
+                                      0,
+                                      0,
+                                      vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, layer, 1),
+                                      vk::Offset3D(0, 0, 0),
+                                      extent);
+            uint8_t const * image = src + layer * imageBytes;
+            data.pixels.insert(data.pixels.end(), image, image + imageBytes);
+        }
+    }
+    return data;
+}
+
+//! The container is identified by its contents rather than by the file's extension. The signature of this function allows it
+//! to be used as a TextureManager::Decoder.
+//!
+//! @param  path        Path of the file (used only in error messages)
+//! @param  contents    Contents of the file
+//!
+//! @return the image
+//!
+//! @warning    A std::runtime_error is thrown if the file is not a DDS or KTX2 file, or if it cannot be loaded
+ImageData loadTexture(std::string const & path, std::vector<char> const & contents)
+{
+    if (contents.size() >= sizeof(KTX2_IDENTIFIER) && memcmp(contents.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+        return loadKtx2(contents.data(), contents.size());
+    if (contents.size() >= 4 && memcmp(contents.data(), "DDS ", 4) == 0)
+        return loadDds(contents.data(), contents.size());
+    throw std::runtime_error("Vkx::loadTexture: " + path + " is not a DDS or KTX2 file");
+}
+} // namespace Vkx
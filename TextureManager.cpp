@@ -1,5 +1,388 @@
 #include "TextureManager.h"
 
+#include "BlockCompressor.h"
+#include "Buffer.h"
+#include "Device.h"
+#include "Image.h"
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+#include "Vkx.h"
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+std::vector<char> readFile(std::string const & path)
+{
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Vkx::TextureManager: failed to open " + path);
+    size_t size = (size_t)file.tellg();
+    std::vector<char> contents(size);
+    file.seekg(0);
+    file.read(contents.data(), size);
+    return contents;
+}
+} // anonymous namespace
+
 namespace Vkx
 {
+//! If the upload queue's family differs from the graphics family, the textures are created with concurrent sharing between
+//! the two families so that no ownership transfer is necessary.
+//!
+//! @param  device          Logical device associated with the textures
+//! @param  queue           Queue that the uploads are submitted to
+//! @param  queueFamily     Family of the upload queue
+//! @param  graphicsFamily  Family of the queues that use the textures
+//! @param  decoder         Converts the contents of a file into an image
+//! @param  workers         Worker threads used to load the textures, or nullptr to create a pool (default: nullptr)
+//!
+//! @note   Missing mip levels are generated on the worker threads if the image is supported by generateMipChain(), and by
+//!         blitting on the upload queue otherwise. Blitting requires an upload queue that supports graphics operations, so
+//!         with a transfer-only or compute-only queue, a texture whose levels must be blitted fails to load.
+TextureManager::TextureManager(std::shared_ptr<Device>     device,
+                               vk::Queue                   queue,
+                               uint32_t                    queueFamily,
+                               uint32_t                    graphicsFamily,
+                               Decoder                     decoder,
+                               std::shared_ptr<ThreadPool> workers /*= nullptr*/)
+    : device_(device)
+    , queue_(queue)
+    , families_{ queueFamily, graphicsFamily }
+    , queueFlags_(device->physical()->getQueueFamilyProperties()[queueFamily].queueFlags)
+    , decoder_(decoder)
+    , workers_(workers ? workers : std::make_shared<ThreadPool>())
+{
+    commandPool_ = device_->createCommandPoolUnique(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient,
+                                                                              queueFamily));
+}
+
+//! The destructor waits for any loads and uploads in progress, but does not submit them.
+TextureManager::~TextureManager()
+{
+    for (auto & job : jobs_)
+    {
+        job.wait();
+    }
+    for (auto & batch : batches_)
+    {
+        device_->waitForFences(1, &(*batch.fence), VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+}
+
+//! If the texture is already loaded (or loading), its reference count is incremented and its handle is returned.
+//!
+//! @param  path    Path to the texture file
+//!
+//! @return handle of the texture
+TextureManager::Handle TextureManager::load(std::string const & path)
+{
+    auto found = byPath_.find(path);
+    if (found != byPath_.end())
+    {
+        ++slots_[found->second].references;
+        return found->second;
+    }
+
+    Handle handle;
+    if (!freeSlots_.empty())
+    {
+        handle = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    else
+    {
+        handle = (Handle)slots_.size();
+        slots_.emplace_back();
+    }
+
+    Slot & slot      = slots_[handle];
+    slot.path        = path;
+    slot.references  = 1;
+    slot.status      = Status::ePending;
+    byPath_[path]    = handle;
+    if (table_)
+        slot.index = table_->add(nullptr);  // Written when the texture is ready
+
+    uint32_t generation = slot.generation;
+    Compression compression = compression_;
+    jobs_.push_back(workers_->submit([this, handle, generation, path, compression] () {
+                                         decode(handle, generation, path, compression);
+                                     }));
+    return handle;
+}
+
+//! When the last reference is released, the texture is destroyed and its handle may be reused.
+//!
+//! @param  handle  Texture to release
+//!
+//! @warning    The texture must not be in use by the GPU when its last reference is released.
+//! @warning    A std::invalid_argument is thrown if the handle does not refer to a texture, which includes a handle whose
+//!             last reference has already been released.
+void TextureManager::release(Handle handle)
+{
+    if (handle >= slots_.size() || slots_[handle].references <= 0)
+        throw std::invalid_argument("Vkx::TextureManager::release: invalid or released handle");
+
+    Slot & slot = slots_[handle];
+    if (--slot.references > 0)
+        return;
+
+    // Any load in progress is discarded when it finishes because its generation no longer matches.
+    byPath_.erase(slot.path);
+    slot.path.clear();
+    slot.error.clear();
+    slot.image.reset();
+    if (table_ && slot.index != BindlessTextureTable::INVALID_INDEX)
+        table_->remove(slot.index);
+    slot.index = BindlessTextureTable::INVALID_INDEX;
+    slot.status = Status::eFailed;
+    ++slot.generation;
+    freeSlots_.push_back(handle);
+}
+
+//! This function should be called once per frame. Textures whose uploads have completed become ready, and all textures that
+//! have finished loading since the previous call are uploaded in a single submission.
+void TextureManager::update()
+{
+    retireCompletedBatches();
+
+    jobs_.erase(std::remove_if(jobs_.begin(),
+                               jobs_.end(),
+                               [] (std::future<void> & job) {
+                                   return job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                               }),
+                jobs_.end());
+
+    std::vector<Upload> decoded;
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex_);
+        decoded.swap(decoded_);
+    }
+
+    Batch batch;
+    for (auto & upload : decoded)
+    {
+        Slot & slot = slots_[upload.handle];
+        if (slot.generation != upload.generation)
+            continue;   // Released while loading
+        if (!upload.image)
+        {
+            slot.status = Status::eFailed;
+            slot.error  = std::move(upload.error);
+        }
+        else
+            batch.uploads.push_back(std::move(upload));
+    }
+    if (batch.uploads.empty())
+        return;
+
+    std::vector<vk::UniqueCommandBuffer> commandBuffers = device_->allocateCommandBuffersUnique(
+        vk::CommandBufferAllocateInfo(*commandPool_, vk::CommandBufferLevel::ePrimary, 1));
+    batch.commands = std::move(commandBuffers[0]);
+
+    vk::CommandBuffer & commands = *batch.commands;
+    commands.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+    // The barriers may only name stages that the upload queue supports. The batch's fence makes the images visible to the
+    // queues that sample them.
+    vk::PipelineStageFlags shaderStages = samplingStages(queueFlags_);
+    for (auto & upload : batch.uploads)
+    {
+        LocalImage & image = *upload.image;
+        image.transitionLayout(commands, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+        if (upload.regions.empty())
+            image.copy(commands, *upload.staging);
+        else
+            image.copy(commands, *upload.staging, upload.regions);
+        if (upload.generateMipmaps)
+            image.generateMipmaps(commands, shaderStages);
+        else
+            image.transitionLayout(commands,
+                                   vk::ImageLayout::eTransferDstOptimal,
+                                   vk::ImageLayout::eShaderReadOnlyOptimal,
+                                   shaderStages);
+    }
+    commands.end();
+
+    batch.fence = device_->createFenceUnique(vk::FenceCreateInfo());
+    queue_.submit(vk::SubmitInfo(0, nullptr, nullptr, 1, &commands), *batch.fence);
+    batches_.push_back(std::move(batch));
+}
+
+//! Finished loads are submitted before waiting, so every texture that has not failed is ready when this function returns.
+void TextureManager::waitIdle()
+{
+    for (auto & job : jobs_)
+    {
+        job.wait();
+    }
+    update();
+    for (auto & batch : batches_)
+    {
+        device_->waitForFences(1, &(*batch.fence), VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
+    retireCompletedBatches();
+}
+
+//! @param  handle  Texture
+//!
+//! @return the texture's view if it is ready, otherwise the placeholder view
+vk::ImageView TextureManager::view(Handle handle) const
+{
+    Slot const & slot = slots_[handle];
+    return (slot.status == Status::eReady) ? slot.image->view() : placeholder_;
+}
+
+//! @param  handle  Texture
+//!
+//! @return the texture's index in the bindless texture table if it is ready, otherwise the placeholder's index. If there is
+//!         no table, or the table is full, BindlessTextureTable::INVALID_INDEX is returned.
+BindlessTextureTable::Index TextureManager::index(Handle handle) const
+{
+    Slot const & slot = slots_[handle];
+    return (slot.status == Status::eReady) ? slot.index : placeholderIndex_;
+}
+
+//! @param  placeholder     View returned by view() for textures that are not ready. If there is a bindless texture table,
+//!                         the view is also added to it.
+void TextureManager::setPlaceholder(vk::ImageView placeholder)
+{
+    placeholder_ = placeholder;
+    if (table_)
+        setPlaceholderIndex();
+}
+
+//! Every loaded texture is given an element in the table, which remains the same until the texture is released. The
+//! element is written once, when the texture becomes ready, so it is never changed while a command buffer might be using it.
+//! Until then, index() returns the index of the placeholder view. Textures that are already loaded are added to the new
+//! table and removed from the previous one.
+//!
+//! @param  table   Table to add the textures to, or nullptr
+//!
+//! @note   The table's indices are not reused until its frames come around, so beginFrame() must be called on the table.
+void TextureManager::setBindlessTable(std::shared_ptr<BindlessTextureTable> table)
+{
+    for (auto & slot : slots_)
+    {
+        if (table_ && slot.index != BindlessTextureTable::INVALID_INDEX)
+            table_->remove(slot.index);
+        slot.index = BindlessTextureTable::INVALID_INDEX;
+        if (table && slot.references > 0)
+            slot.index = table->add((slot.status == Status::eReady) ? slot.image->view() : vk::ImageView());
+    }
+    if (table_ && placeholderIndex_ != BindlessTextureTable::INVALID_INDEX)
+        table_->remove(placeholderIndex_);
+    placeholderIndex_ = BindlessTextureTable::INVALID_INDEX;
+
+    table_ = table;
+    if (table_)
+        setPlaceholderIndex();
+}
+
+//! Textures are compressed on the worker threads, after their mip levels have been generated and before they are staged.
+//! Textures whose formats cannot be compressed into the block format (see canCompressImage()) are uploaded uncompressed, as
+//! are textures whose mip levels must be generated by blitting. No texture is compressed unless the device was created with
+//! the textureCompressionBC feature enabled (see Device::enabledFeatures()).
+//!
+//! @param  block       Block format
+//! @param  quality     Speed/quality trade-off (default: CompressionQuality::eNormal)
+//!
+//! @note   This only affects textures loaded after the call.
+void TextureManager::setCompression(BlockFormat block, CompressionQuality quality /*= CompressionQuality::eNormal*/)
+{
+    compression_ = Compression{ true, block, quality };
+}
+
+// Runs on a worker thread. Nothing but the decoded queue is shared with the manager's thread.
+void TextureManager::decode(Handle handle, uint32_t generation, std::string const & path, Compression const & compression)
+{
+    Upload upload{ handle, generation, nullptr, {}, nullptr, {}, false, {} };
+    try
+    {
+        std::vector<char> contents = readFile(path);
+        ImageData data = decoder_(path, contents);
+
+        vk::ImageCreateInfo & info = data.info;
+        info.usage |= vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+        upload.generateMipmaps = info.mipLevels > 1 && !data.hasMipmaps();
+        if (upload.generateMipmaps && canGenerateMipChain(info))
+        {
+            // Generating the mip levels here keeps the work off of the upload queue
+            generateMipChain(data, MipFilter::eBox, workers_.get());
+            upload.generateMipmaps = false;
+        }
+        else if (upload.generateMipmaps)
+        {
+            if (!(queueFlags_ & vk::QueueFlagBits::eGraphics))
+                throw std::runtime_error("Vkx::TextureManager: mipmaps cannot be blitted on the upload queue");
+            vk::FormatProperties formatProperties = device_->physical()->getFormatProperties(info.format);
+            if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+                throw std::runtime_error("Vkx::TextureManager: texture image format does not support linear blitting");
+            info.usage |= vk::ImageUsageFlagBits::eTransferSrc;
+        }
+        if (compression.enabled && !upload.generateMipmaps && device_->enabledFeatures().textureCompressionBC &&
+            canCompressImage(info.format, compression.format))
+        {
+            data = compressImage(data, compression.format, compression.quality, workers_.get());
+        }
+        if (families_[0] != families_[1])
+        {
+            info.sharingMode           = vk::SharingMode::eConcurrent;
+            info.queueFamilyIndexCount = 2;
+            info.pQueueFamilyIndices   = families_;
+        }
+
+        upload.pixels  = std::move(data.pixels);
+        upload.staging = createStagingBuffer(device_, upload.pixels.data(), upload.pixels.size());
+        upload.regions = std::move(data.regions);
+        upload.image   = std::make_unique<LocalImage>(device_, info);
+    }
+    catch (std::exception const & e)
+    {
+        upload.image.reset();
+        upload.error = e.what();
+    }
+    catch (...)
+    {
+        upload.image.reset();
+        upload.error = "Vkx::TextureManager: unknown error loading " + path;
+    }
+
+    std::lock_guard<std::mutex> lock(decodedMutex_);
+    decoded_.push_back(std::move(upload));
+}
+
+void TextureManager::setPlaceholderIndex()
+{
+    if (placeholderIndex_ != BindlessTextureTable::INVALID_INDEX)
+        table_->remove(placeholderIndex_);
+    placeholderIndex_ = placeholder_ ? table_->add(placeholder_) : BindlessTextureTable::INVALID_INDEX;
+}
+
+void TextureManager::retireCompletedBatches()
+{
+    // Batches are submitted to a single queue, so they complete in order
+    while (!batches_.empty() && device_->getFenceStatus(*batches_.front().fence) == vk::Result::eSuccess)
+    {
+        for (auto & upload : batches_.front().uploads)
+        {
+            Slot & slot = slots_[upload.handle];
+            if (slot.generation == upload.generation)
+            {
+                slot.image  = std::move(upload.image);
+                slot.status = Status::eReady;
+                if (table_ && slot.index != BindlessTextureTable::INVALID_INDEX)
+                    table_->set(slot.index, slot.image->view());
+            }
+        }
+        batches_.pop_front();
+    }
+}
 } // namespace Vkx
@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Vkx
+{
+//! @param  nThreads    Number of worker threads, or 0 to use one per hardware thread (default: 0)
+ThreadPool::ThreadPool(size_t nThreads /*= 0*/)
+{
+    if (nThreads == 0)
+        nThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    workers_.reserve(nThreads);
+    for (size_t i = 0; i < nThreads; ++i)
+    {
+        workers_.emplace_back([this] () { run(); });
+    }
+}
+
+//! Jobs that have already been queued are completed before the destructor returns.
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (auto & worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+//! The range is split into chunks that are claimed by the calling thread and by the workers. Because the calling thread also
+//! processes chunks and only waits for chunks that have been claimed, this function can be called from a worker thread.
+//!
+//! @param  count   Number of indexes
+//! @param  body    Called with each chunk's range of indexes [begin, end)
+void ThreadPool::parallelFor(size_t count, std::function<void(size_t begin, size_t end)> body)
+{
+    if (count == 0)
+        return;
+
+    struct Shared
+    {
+        std::function<void(size_t, size_t)> body;
+        size_t count;
+        size_t chunkSize;
+        size_t nChunks;
+        std::atomic<size_t> next { 0 };
+        size_t done = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    auto shared       = std::make_shared<Shared>();
+    shared->body      = std::move(body);
+    shared->count     = count;
+    shared->chunkSize = std::max<size_t>(count / (workers_.size() * 4 + 1), 1);
+    shared->nChunks   = (count + shared->chunkSize - 1) / shared->chunkSize;
+
+    // Claims and processes chunks until there are none left
+    auto work = [] (Shared & s) {
+                    for (size_t chunk = s.next++; chunk < s.nChunks; chunk = s.next++)
+                    {
+                        size_t begin = chunk * s.chunkSize;
+                        std::exception_ptr error;
+                        try
+                        {
+                            s.body(begin, std::min(begin + s.chunkSize, s.count));
+                        }
+                        catch (...)
+                        {
+                            error = std::current_exception();
+                        }
+                        std::lock_guard<std::mutex> lock(s.mutex);
+                        if (error && !s.error)
+                            s.error = error;
+                        if (++s.done == s.nChunks)
+                            s.finished.notify_all();
+                    }
+                };
+
+    size_t nHelpers = std::min(workers_.size(), shared->nChunks - 1);
+    for (size_t i = 0; i < nHelpers; ++i)
+    {
+        enqueue([shared, work] () { work(*shared); });
+    }
+    work(*shared);
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->finished.wait(lock, [&shared] () { return shared->done == shared->nChunks; });
+    if (shared->error)
+        std::rethrow_exception(shared->error);
+}
+
+void ThreadPool::enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    available_.notify_one();
+}
+
+void ThreadPool::run()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this] () { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+} // namespace Vkx
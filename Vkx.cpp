@@ -1,15 +1,75 @@
 #include "Vkx.h"
 
 #include "Buffer.h"
+#include "MappedFile.h"
 
 #include <vulkan/vulkan.hpp>
 
 #include <algorithm>
 #include <cstdint>
 #include <cstdlib>
-#include <fstream>
+#include <numeric>
+#include <stdexcept>
 #include <vector>
 
+namespace
+{
+bool intersects(vk::Rect2D const & a, vk::Rect2D const & b)
+{
+    return a.offset.x < b.offset.x + (int32_t)b.extent.width &&
+           b.offset.x < a.offset.x + (int32_t)a.extent.width &&
+           a.offset.y < b.offset.y + (int32_t)b.extent.height &&
+           b.offset.y < a.offset.y + (int32_t)a.extent.height;
+}
+
+// Appends the parts of a that are not in b, as up to four non-overlapping rectangles
+void subtract(vk::Rect2D const & a, vk::Rect2D const & b, std::vector<vk::Rect2D> & parts)
+{
+    if (!intersects(a, b))
+    {
+        parts.push_back(a);
+        return;
+    }
+
+    int32_t aRight  = a.offset.x + (int32_t)a.extent.width;
+    int32_t aBottom = a.offset.y + (int32_t)a.extent.height;
+    int32_t bRight  = b.offset.x + (int32_t)b.extent.width;
+    int32_t bBottom = b.offset.y + (int32_t)b.extent.height;
+    int32_t left    = std::max(a.offset.x, b.offset.x);
+    int32_t right   = std::min(aRight, bRight);
+
+    // Full-height strips to the left and right, then the parts above and below between them
+    if (a.offset.x < b.offset.x)
+        parts.push_back(vk::Rect2D(a.offset, vk::Extent2D(b.offset.x - a.offset.x, a.extent.height)));
+    if (bRight < aRight)
+        parts.push_back(vk::Rect2D(vk::Offset2D(bRight, a.offset.y), vk::Extent2D(aRight - bRight, a.extent.height)));
+    if (a.offset.y < b.offset.y)
+        parts.push_back(vk::Rect2D(vk::Offset2D(left, a.offset.y), vk::Extent2D(right - left, b.offset.y - a.offset.y)));
+    if (bBottom < aBottom)
+        parts.push_back(vk::Rect2D(vk::Offset2D(left, bBottom), vk::Extent2D(right - left, aBottom - bBottom)));
+}
+
+// Returns true if two rectangles share a whole edge, and if so, sets the first to their union
+bool merge(vk::Rect2D & a, vk::Rect2D const & b)
+{
+    if (a.offset.x == b.offset.x && a.extent.width == b.extent.width &&
+        (a.offset.y + (int32_t)a.extent.height == b.offset.y || b.offset.y + (int32_t)b.extent.height == a.offset.y))
+    {
+        a.offset.y       = std::min(a.offset.y, b.offset.y);
+        a.extent.height += b.extent.height;
+        return true;
+    }
+    if (a.offset.y == b.offset.y && a.extent.height == b.extent.height &&
+        (a.offset.x + (int32_t)a.extent.width == b.offset.x || b.offset.x + (int32_t)b.extent.width == a.offset.x))
+    {
+        a.offset.x      = std::min(a.offset.x, b.offset.x);
+        a.extent.width += b.extent.width;
+        return true;
+    }
+    return false;
+}
+} // anonymous namespace
+
 namespace Vkx
 {
 //! @param  extensions
@@ -61,6 +121,8 @@ bool allLayersAvailable(std::vector<char const *> const & requested)
     return true;
 }
 
+//! The module is not cached. Device::shaders() provides shared modules and avoids loading the same file more than once.
+//!
 //! @param  path        Path to shader file
 //! @param  device      Logical device managing the shader
 //! @param  flags       Creation flags (default: none)
@@ -68,22 +130,19 @@ bool allLayersAvailable(std::vector<char const *> const & requested)
 //! @return shader module handle
 //!
 //! @warning   std::runtime_error is thrown if the file cannot be opened
+//! @warning   std::invalid_argument is thrown if the file is empty or its size is not a multiple of 4 bytes
 vk::ShaderModule loadShaderModule(std::string const &         path,
                                   std::shared_ptr<Device>     device,
                                   vk::ShaderModuleCreateFlags flags /*= vk::ShaderModuleCreateFlags()*/)
 {
-    // Load the code
-    std::ifstream file(path, std::ios::ate | std::ios::binary);
-    if (!file.is_open())
-        throw std::runtime_error("Vkx::loadShaderModule: failed to open the file");
-    size_t fileSize   = (size_t)file.tellg();
-    size_t shaderSize = (fileSize + (sizeof(uint32_t) - 1)) / sizeof(uint32_t);
-    std::vector<uint32_t> buffer(shaderSize);
-    file.seekg(0);
-    file.read((char *)buffer.data(), fileSize);
+    // The mapping is page-aligned, so the code can be used in place
+    MappedFile code(path);
+    if (code.size() == 0 || code.size() % sizeof(uint32_t) != 0)
+        throw std::invalid_argument("Vkx::loadShaderModule: the file is not SPIR-V");
 
     // Create the module for the device
-    vk::ShaderModule shaderModule = device->createShaderModule({ flags, buffer.size() * sizeof(uint32_t), buffer.data() });
+    vk::ShaderModule shaderModule = device->createShaderModule(
+        { flags, code.size(), static_cast<uint32_t const *>(code.data()) });
 
     return shaderModule;
 }
@@ -141,4 +200,111 @@ uint32_t findAppropriateMemoryType(std::shared_ptr<PhysicalDevice> physicalDevic
     queue.submit(vk::SubmitInfo(0, nullptr, nullptr, 1, &commandBuffers[0].get()), nullptr);
     vkQueueWaitIdle(queue);
 }
+
+//! @param  format  Format
+//!
+//! @return size of a texel in bytes
+//!
+//! @warning    A std::invalid_argument is thrown if the format is not a supported uncompressed color format
+size_t texelSize(vk::Format format)
+{
+    switch (format)
+    {
+        case vk::Format::eR8Unorm:
+        case vk::Format::eR8Srgb:
+            return 1;
+        case vk::Format::eR8G8Unorm:
+        case vk::Format::eR8G8Srgb:
+        case vk::Format::eR16Sfloat:
+            return 2;
+        case vk::Format::eR8G8B8Unorm:
+        case vk::Format::eR8G8B8Srgb:
+            return 3;
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eR8G8B8A8Srgb:
+        case vk::Format::eB8G8R8A8Unorm:
+        case vk::Format::eB8G8R8A8Srgb:
+        case vk::Format::eR16G16Sfloat:
+        case vk::Format::eR32Sfloat:
+            return 4;
+        case vk::Format::eR16G16B16A16Sfloat:
+        case vk::Format::eR32G32Sfloat:
+            return 8;
+        case vk::Format::eR32G32B32A32Sfloat:
+            return 16;
+        default:
+            throw std::invalid_argument("Vkx::texelSize: unsupported format");
+    }
+}
+
+//! vkCmdCopyBufferToImage and vkCmdCopyImageToBuffer require the offset to be a multiple of both the texel size and 4. For a
+//! 3-byte texel, that is 12.
+//!
+//! @param  format  Format
+//!
+//! @return alignment in bytes
+//!
+//! @warning    A std::invalid_argument is thrown if the format is not a supported uncompressed color format
+size_t copyAlignment(vk::Format format)
+{
+    return std::lcm(texelSize(format), size_t(4));
+}
+
+//! The result is meant for the barriers that make images readable by shaders. A transfer-only queue family has no shader
+//! stages, so the result is empty for it.
+//!
+//! @param  queueFlags  Capabilities of the queue family
+//!
+//! @return the fragment shader stage for a graphics queue, the compute shader stage for a compute-only queue, or no stages
+vk::PipelineStageFlags samplingStages(vk::QueueFlags queueFlags)
+{
+    if (queueFlags & vk::QueueFlagBits::eGraphics)
+        return vk::PipelineStageFlagBits::eFragmentShader;
+    if (queueFlags & vk::QueueFlagBits::eCompute)
+        return vk::PipelineStageFlagBits::eComputeShader;
+    return vk::PipelineStageFlags();
+}
+
+//! Overlapping parts are removed first, then rectangles that share a whole edge are joined. Empty rectangles are dropped.
+//!
+//! @param  rects   Rectangles, which may overlap
+//!
+//! @return non-overlapping rectangles covering the same texels
+std::vector<vk::Rect2D> coalesceRects(std::vector<vk::Rect2D> const & rects)
+{
+    std::vector<vk::Rect2D> coalesced;
+    std::vector<vk::Rect2D> parts;
+    std::vector<vk::Rect2D> remaining;
+    for (auto const & rect : rects)
+    {
+        if (rect.extent.width == 0 || rect.extent.height == 0)
+            continue;
+
+        remaining.assign(1, rect);
+        for (auto const & existing : coalesced)
+        {
+            parts.clear();
+            for (auto const & r : remaining)
+            {
+                subtract(r, existing, parts);
+            }
+            remaining.swap(parts);
+        }
+        coalesced.insert(coalesced.end(), remaining.begin(), remaining.end());
+    }
+
+    for (size_t i = 0; i < coalesced.size(); ++i)
+    {
+        for (size_t j = i + 1; j < coalesced.size(); ++j)
+        {
+            if (merge(coalesced[i], coalesced[j]))
+            {
+                // The union may now share an edge with a rectangle that has already been checked
+                coalesced.erase(coalesced.begin() + j);
+                j = i;
+            }
+        }
+    }
+    return coalesced;
+}
 } // namespace Vkx
@@ -0,0 +1,358 @@
+// Measures the throughput of compressImage() for every block format and quality, on the calling thread and on a pool of
+// worker threads. No GPU is needed.
+//
+// Usage: BlockCompressionBench [size of the square test image (default: 1024)]
+//
+// Every compressed image is decoded and compared with the source. The program returns 0 if every compressed image has
+// the expected size, the workers produce the same blocks as the calling thread, and every block can be decoded. If the
+// image is at least 64x64, the PSNR of every image must also be at least the minimum for its format.
+
+#include <Vkx/BlockCompressor.h>
+#include <Vkx/Image.h>
+#include <Vkx/ThreadPool.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+int constexpr ITERATIONS = 3;   // Timed runs of each case. The fastest is reported.
+
+// In smaller test images, the gradients change too quickly within a block for the PSNR minimums to apply
+uint32_t constexpr PSNR_CHECK_SIZE = 64;
+
+// A mix of smooth gradients and noise, so that the encoders' searches do typical amounts of work
+Vkx::ImageData makeImage(uint32_t size)
+{
+    Vkx::ImageData data;
+    data.info = vk::ImageCreateInfo({},
+                                    vk::ImageType::e2D,
+                                    vk::Format::eR8G8B8A8Unorm,
+                                    vk::Extent3D(size, size, 1),
+                                    1,
+                                    1,
+                                    vk::SampleCountFlagBits::e1,
+                                    vk::ImageTiling::eOptimal,
+                                    vk::ImageUsageFlagBits::eSampled);
+    data.pixels.resize(size_t(size) * size * 4);
+    uint32_t noise = 1;
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            noise = noise * 1664525u + 1013904223u;
+            float u = (x + 0.5f) / size;
+            float v = (y + 0.5f) / size;
+            uint8_t * t = &data.pixels[(size_t(y) * size + x) * 4];
+            t[0] = (uint8_t)std::lround(255.0f * u);
+            t[1] = (uint8_t)std::lround(127.5f + 127.5f * std::sin(25.0f * v));
+            t[2] = (uint8_t)(noise >> 24);
+            t[3] = (uint8_t)std::lround(255.0f * v);
+        }
+    }
+    return data;
+}
+
+// Returns the fastest time of the compression in milliseconds
+double time(Vkx::ImageData const &  image,
+            Vkx::BlockFormat        block,
+            Vkx::CompressionQuality quality,
+            Vkx::ThreadPool *       workers,
+            Vkx::ImageData &        compressed)
+{
+    double fastest = 1.0e30;
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        compressed = Vkx::compressImage(image, block, quality, workers);
+        auto end = std::chrono::steady_clock::now();
+        fastest = std::min(fastest, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return fastest;
+}
+
+// The decoders follow the format specifications rather than sharing code with the encoders, so that they check them.
+
+void unpack565(uint16_t c, int rgb[3])
+{
+    int r  = (c >> 11) & 31;
+    int g  = (c >> 5) & 63;
+    int b  = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Decodes the RGBA of a BC1 block, or the RGB of a BC3 block (which always has four colors)
+void decodeBC1(uint8_t const * in, bool alwaysFourColors, uint8_t out[16][4])
+{
+    uint16_t c0 = uint16_t(in[0] | (in[1] << 8));
+    uint16_t c1 = uint16_t(in[2] | (in[3] << 8));
+    int palette[4][4];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    bool fourColors = alwaysFourColors || c0 > c1;
+    for (int c = 0; c < 3; ++c)
+    {
+        palette[2][c] = fourColors ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+        palette[3][c] = fourColors ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+
+    uint32_t indices = uint32_t(in[4]) | (uint32_t(in[5]) << 8) | (uint32_t(in[6]) << 16) | (uint32_t(in[7]) << 24);
+    for (int i = 0; i < 16; ++i)
+    {
+        int k = (indices >> (2 * i)) & 3;
+        for (int c = 0; c < (alwaysFourColors ? 3 : 4); ++c)
+        {
+            out[i][c] = (uint8_t)palette[k][c];
+        }
+    }
+}
+
+// Decodes a BC4 block into one channel
+void decodeBC4(uint8_t const * in, int channel, uint8_t out[16][4])
+{
+    int palette[8] = { in[0], in[1] };
+    if (palette[0] > palette[1])
+    {
+        for (int i = 2; i < 8; ++i)
+        {
+            palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1] + 3) / 7;
+        }
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+        {
+            palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1] + 2) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        indices |= uint64_t(in[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        out[i][channel] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+// Decodes a BC7 block. Only mode 6 is decoded, because it is the only mode the encoder uses. Returns false otherwise.
+bool decodeBC7(uint8_t const * in, uint8_t out[16][4])
+{
+    static int constexpr WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    int position = 0;
+    auto read = [in, &position] (int bits) {
+                    uint32_t value = 0;
+                    for (int b = 0; b < bits; ++b, ++position)
+                    {
+                        value |= uint32_t((in[position >> 3] >> (position & 7)) & 1) << b;
+                    }
+                    return (int)value;
+                };
+
+    if (read(7) != 1 << 6)
+        return false;
+    int endpoints[2][4];
+    for (int c = 0; c < 4; ++c)
+    {
+        endpoints[0][c] = read(7) << 1;
+        endpoints[1][c] = read(7) << 1;
+    }
+    for (auto & endpoint : endpoints)
+    {
+        int p = read(1);
+        for (int c = 0; c < 4; ++c)
+        {
+            endpoint[c] |= p;
+        }
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        int w = WEIGHTS[read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c)
+        {
+            out[i][c] = (uint8_t)(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+        }
+    }
+    return true;
+}
+
+// Decodes a compressed square RGBA8 image with one level into RGBA texels. Channels that the format does not store are
+// 0, except alpha, which is 255. Returns false if a block cannot be decoded.
+bool decode(Vkx::ImageData const & compressed, Vkx::BlockFormat block, uint32_t size, std::vector<uint8_t> & texels)
+{
+    bool narrow     = block == Vkx::BlockFormat::eBC1 || block == Vkx::BlockFormat::eBC4;
+    size_t bytes    = narrow ? 8 : 16;
+    uint32_t blocks = (size + 3) / 4;
+
+    texels.assign(size_t(size) * size * 4, 0);
+    for (uint32_t by = 0; by < blocks; ++by)
+    {
+        for (uint32_t bx = 0; bx < blocks; ++bx)
+        {
+            uint8_t const * in = compressed.pixels.data() + (size_t(by) * blocks + bx) * bytes;
+            uint8_t out[16][4] = {};
+            for (auto & texel : out)
+            {
+                texel[3] = 255;
+            }
+            switch (block)
+            {
+                case Vkx::BlockFormat::eBC1:
+                    decodeBC1(in, false, out);
+                    break;
+                case Vkx::BlockFormat::eBC3:
+                    decodeBC4(in, 3, out);
+                    decodeBC1(in + 8, true, out);
+                    break;
+                case Vkx::BlockFormat::eBC4:
+                    decodeBC4(in, 0, out);
+                    break;
+                case Vkx::BlockFormat::eBC5:
+                    decodeBC4(in, 0, out);
+                    decodeBC4(in + 8, 1, out);
+                    break;
+                case Vkx::BlockFormat::eBC7:
+                    if (!decodeBC7(in, out))
+                        return false;
+                    break;
+            }
+
+            // Texels of partial blocks past the edges are dropped
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t x = bx * 4 + i % 4;
+                uint32_t y = by * 4 + i / 4;
+                if (x < size && y < size)
+                    std::memcpy(&texels[(size_t(y) * size + x) * 4], out[i], 4);
+            }
+        }
+    }
+    return true;
+}
+
+// Returns the PSNR in dB of the decoded texels over the channels stored by the format. BC1 stores 1-bit alpha, so a
+// source texel with alpha below 128 is expected to decode to transparent black and any other one to be opaque.
+double psnr(std::vector<uint8_t> const & source, std::vector<uint8_t> const & decoded, Vkx::BlockFormat block)
+{
+    int channels = (block == Vkx::BlockFormat::eBC4) ? 1 : (block == Vkx::BlockFormat::eBC5) ? 2 : 4;
+    double squared = 0.0;
+    for (size_t t = 0; t < source.size(); t += 4)
+    {
+        uint8_t expected[4] = { source[t], source[t + 1], source[t + 2], source[t + 3] };
+        if (block == Vkx::BlockFormat::eBC1)
+        {
+            bool transparent = expected[3] < 128;
+            for (int c = 0; c < 4; ++c)
+            {
+                expected[c] = transparent ? 0 : (c == 3) ? 255 : expected[c];
+            }
+        }
+        for (int c = 0; c < channels; ++c)
+        {
+            double d = double(expected[c]) - double(decoded[t + c]);
+            squared += d * d;
+        }
+    }
+    double mse = squared / (double(source.size() / 4) * channels);
+    return (mse > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    uint32_t imageSize = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 1024;
+    if (imageSize == 0)
+    {
+        std::fprintf(stderr, "BlockCompressionBench: the size must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    struct Format
+    {
+        Vkx::BlockFormat block;
+        char const * name;
+        size_t bytesPerBlock;
+        double minimumPsnr;     // dB, for images of at least PSNR_CHECK_SIZE texels
+    };
+    std::vector<Format> const formats = {
+        { Vkx::BlockFormat::eBC1, "BC1", 8, 21.0 },
+        { Vkx::BlockFormat::eBC3, "BC3", 16, 18.0 },
+        { Vkx::BlockFormat::eBC4, "BC4", 8, 45.0 },
+        { Vkx::BlockFormat::eBC5, "BC5", 16, 38.0 },
+        { Vkx::BlockFormat::eBC7, "BC7", 16, 20.0 }
+    };
+    struct Quality
+    {
+        Vkx::CompressionQuality quality;
+        char const * name;
+    };
+    std::vector<Quality> const qualities = {
+        { Vkx::CompressionQuality::eFast, "fast" },
+        { Vkx::CompressionQuality::eNormal, "normal" },
+        { Vkx::CompressionQuality::eBest, "best" }
+    };
+
+    try
+    {
+        Vkx::ImageData  image = makeImage(imageSize);
+        Vkx::ThreadPool workers;
+        double megatexels = double(imageSize) * imageSize * 1.0e-6;
+        size_t expected   = size_t((imageSize + 3) / 4) * ((imageSize + 3) / 4);
+
+        std::printf("%ux%u RGBA8, %zu worker threads\n\n", imageSize, imageSize, workers.size());
+        std::printf("format  quality   1 thread (ms, Mtexel/s)   workers (ms, Mtexel/s)   PSNR (dB)\n");
+
+        bool passed = true;
+        std::vector<uint8_t> decoded;
+        for (auto const & format : formats)
+        {
+            for (auto const & quality : qualities)
+            {
+                Vkx::ImageData serialResult;
+                Vkx::ImageData parallelResult;
+                double serial   = time(image, format.block, quality.quality, nullptr, serialResult);
+                double parallel = time(image, format.block, quality.quality, &workers, parallelResult);
+                bool ok = serialResult.pixels.size() == expected * format.bytesPerBlock &&
+                          parallelResult.pixels == serialResult.pixels;
+                double decibels = ok && decode(serialResult, format.block, imageSize, decoded)
+                                  ? psnr(image.pixels, decoded, format.block)
+                                  : 0.0;
+                ok     = ok && (decibels >= format.minimumPsnr || imageSize < PSNR_CHECK_SIZE);
+                passed = passed && ok;
+                std::printf("%-6s  %-7s   %9.2f  %9.2f        %9.2f  %9.2f        %6.2f %s\n",
+                            format.name,
+                            quality.name,
+                            serial,
+                            megatexels / (serial * 1.0e-3),
+                            parallel,
+                            megatexels / (parallel * 1.0e-3),
+                            decibels,
+                            ok ? "" : "FAILED");
+            }
+        }
+
+        std::printf("\n%s\n", passed ? "PASSED" : "FAILED");
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "BlockCompressionBench: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
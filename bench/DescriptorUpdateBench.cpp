@@ -0,0 +1,155 @@
+// Times updating descriptor sets with a DescriptorUpdateTemplate against building vk::WriteDescriptorSets and calling
+// vk::Device::updateDescriptorSets().
+//
+// Usage: DescriptorUpdateBench [number of sets (default: 1000)]
+//
+// Each set has a uniform buffer, an array of 4 storage buffers, and an array of 4 samplers, and every set is updated
+// with different buffer ranges. The cost is all on the CPU, so a software driver such as lavapipe is representative.
+//
+// The program returns 0 if both paths run.
+
+#include "Headless.h"
+
+#include <Vkx/Buffer.h>
+#include <Vkx/DescriptorUpdateTemplate.h>
+#include <Vkx/SamplerCache.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+int constexpr ITERATIONS = 10;  // Timed runs of each path. The fastest is reported.
+uint32_t constexpr ARRAY_SIZE = 4;
+vk::DeviceSize constexpr RANGE = 256;  // Size of each buffer range
+
+struct Descriptors
+{
+    vk::DescriptorBufferInfo parameters;
+    vk::DescriptorBufferInfo storage[ARRAY_SIZE];
+    vk::DescriptorImageInfo  samplers[ARRAY_SIZE];
+};
+
+// Returns the time taken by a function in milliseconds
+template <typename F>
+double time(F && f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Updates a set the way it is done without a template
+void write(vk::Device device, vk::DescriptorSet set, Descriptors const & d)
+{
+    std::array<vk::WriteDescriptorSet, 3> writes = {
+        vk::WriteDescriptorSet(set, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &d.parameters),
+        vk::WriteDescriptorSet(set, 1, 0, ARRAY_SIZE, vk::DescriptorType::eStorageBuffer, nullptr, d.storage),
+        vk::WriteDescriptorSet(set, 2, 0, ARRAY_SIZE, vk::DescriptorType::eSampler, d.samplers)
+    };
+    device.updateDescriptorSets(writes, nullptr);
+}
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    uint32_t setCount = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 1000;
+    if (setCount == 0)
+    {
+        std::fprintf(stderr, "DescriptorUpdateBench: the number of sets must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        Headless context;
+        std::shared_ptr<Vkx::Device> device = context.device;
+        std::printf("Device: %s\n\n", context.name().c_str());
+
+        std::array<vk::DescriptorSetLayoutBinding, 3> bindings = {
+            vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eAll),
+            vk::DescriptorSetLayoutBinding(1,
+                                           vk::DescriptorType::eStorageBuffer,
+                                           ARRAY_SIZE,
+                                           vk::ShaderStageFlagBits::eAll),
+            vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eSampler, ARRAY_SIZE, vk::ShaderStageFlagBits::eAll)
+        };
+        vk::UniqueDescriptorSetLayout layout = device->createDescriptorSetLayoutUnique(
+            vk::DescriptorSetLayoutCreateInfo({}, (uint32_t)bindings.size(), bindings.data()));
+
+        std::array<vk::DescriptorPoolSize, 3> sizes = {
+            vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, setCount),
+            vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, setCount * ARRAY_SIZE),
+            vk::DescriptorPoolSize(vk::DescriptorType::eSampler, setCount * ARRAY_SIZE)
+        };
+        vk::UniqueDescriptorPool pool = device->createDescriptorPoolUnique(
+            vk::DescriptorPoolCreateInfo({}, setCount, (uint32_t)sizes.size(), sizes.data()));
+        std::vector<vk::DescriptorSetLayout> layouts(setCount, *layout);
+        std::vector<vk::DescriptorSet> sets = device->allocateDescriptorSets(
+            vk::DescriptorSetAllocateInfo(*pool, setCount, layouts.data()));
+
+        // Every set refers to its own ranges of one buffer
+        vk::PhysicalDeviceLimits limits = context.physical->getProperties().limits;
+        vk::DeviceSize alignment = std::max({ RANGE,
+                                              limits.minUniformBufferOffsetAlignment,
+                                              limits.minStorageBufferOffsetAlignment });
+        Vkx::LocalBuffer buffer(device,
+                                alignment * (ARRAY_SIZE + 1) * setCount,
+                                vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+        vk::Sampler sampler = device->samplers().get(vk::SamplerCreateInfo());
+
+        std::vector<Descriptors> descriptors(setCount);
+        for (uint32_t i = 0; i < setCount; ++i)
+        {
+            vk::DeviceSize base = alignment * (ARRAY_SIZE + 1) * i;
+            descriptors[i].parameters = vk::DescriptorBufferInfo(buffer, base, RANGE);
+            for (uint32_t j = 0; j < ARRAY_SIZE; ++j)
+            {
+                descriptors[i].storage[j]  = vk::DescriptorBufferInfo(buffer, base + alignment * (j + 1), RANGE);
+                descriptors[i].samplers[j] = vk::DescriptorImageInfo(sampler, nullptr, vk::ImageLayout::eUndefined);
+            }
+        }
+
+        Vkx::DescriptorUpdateTemplate update(device, *layout, {
+            Vkx::DescriptorUpdateTemplate::entry(0, vk::DescriptorType::eUniformBuffer, &Descriptors::parameters),
+            Vkx::DescriptorUpdateTemplate::entry(1, vk::DescriptorType::eStorageBuffer, &Descriptors::storage),
+            Vkx::DescriptorUpdateTemplate::entry(2, vk::DescriptorType::eSampler, &Descriptors::samplers)
+        });
+
+        double writes    = 1.0e30;
+        double templated = 1.0e30;
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            writes = std::min(writes, time([&] {
+                for (uint32_t s = 0; s < setCount; ++s)
+                {
+                    write(*device, sets[s], descriptors[s]);
+                }
+            }));
+            templated = std::min(templated, time([&] {
+                for (uint32_t s = 0; s < setCount; ++s)
+                {
+                    update.update(sets[s], descriptors[s]);
+                }
+            }));
+        }
+
+        std::printf("%u sets, %u descriptors each\n", setCount, 1 + 2 * ARRAY_SIZE);
+        std::printf("vk::WriteDescriptorSet   %9.3f ms  %7.3f us/set\n", writes, writes * 1.0e3 / setCount);
+        std::printf("update template          %9.3f ms  %7.3f us/set\n", templated, templated * 1.0e3 / setCount);
+        std::printf("\nPASSED\n");
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "DescriptorUpdateBench: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,97 @@
+#if !defined(VKX_BENCH_HEADLESS_H)
+#define VKX_BENCH_HEADLESS_H
+
+#pragma once
+
+#include <Vkx/Device.h>
+#include <Vkx/Instance.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+//! A device with no surface, and one queue that supports graphics and compute operations.
+//!
+//! The first physical device is used, unless the VKX_DEVICE environment variable holds part of another one's name. To run
+//! on a software driver, point VK_ICD_FILENAMES at it (lavapipe's lvp_icd.x86_64.json, for example).
+struct Headless
+{
+    //! Constructor.
+    //!
+    //! @param  features    Features to enable (default: none)
+    //! @param  next        Chain of extended feature structs to enable, or nullptr (default: nullptr)
+    //! @param  extensions  Device extensions to enable (default: none)
+    explicit Headless(vk::PhysicalDeviceFeatures const & features   = vk::PhysicalDeviceFeatures(),
+                      void *                             next       = nullptr,
+                      std::vector<char const *> const &  extensions = {})
+    {
+        vk::ApplicationInfo appInfo("VkxBench", 1, "Vkx", 1, VK_API_VERSION_1_2);
+        instance = std::make_shared<Vkx::Instance>(vk::InstanceCreateInfo({}, &appInfo));
+
+        auto chooser = [] (std::vector<vk::PhysicalDevice> const & all) {
+            if (all.empty())
+                throw std::runtime_error("Headless: no Vulkan devices");
+            char const * wanted = std::getenv("VKX_DEVICE");
+            for (auto const & candidate : all)
+            {
+                if (wanted && std::string(candidate.getProperties().deviceName).find(wanted) != std::string::npos)
+                    return candidate;
+            }
+            return all[0];
+        };
+        physical = std::make_shared<Vkx::PhysicalDevice>(instance, nullptr, chooser);
+
+        std::vector<vk::QueueFamilyProperties> families = physical->getQueueFamilyProperties();
+        vk::QueueFlags required = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+        family = 0;
+        while (family < families.size() && (families[family].queueFlags & required) != required)
+        {
+            ++family;
+        }
+        if (family == families.size())
+            throw std::runtime_error("Headless: no graphics and compute queue");
+
+        float priority = 1.0f;
+        vk::DeviceQueueCreateInfo queueInfo({}, family, 1, &priority);
+        vk::DeviceCreateInfo info({},
+                                  1,
+                                  &queueInfo,
+                                  0,
+                                  nullptr,
+                                  (uint32_t)extensions.size(),
+                                  extensions.data(),
+                                  &features);
+        info.pNext  = next;
+        device      = std::make_shared<Vkx::Device>(physical, info);
+        queue       = device->getQueue(family, 0);
+        commandPool = device->createCommandPoolUnique(
+            vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, family));
+    }
+
+    //! Returns true if the physical device supports a device extension.
+    bool supports(char const * extension) const
+    {
+        for (auto const & properties : physical->enumerateDeviceExtensionProperties())
+        {
+            if (std::string(properties.extensionName) == extension)
+                return true;
+        }
+        return false;
+    }
+
+    //! Returns the name of the physical device.
+    std::string name() const { return std::string(physical->getProperties().deviceName); }
+
+    std::shared_ptr<Vkx::Instance> instance;
+    std::shared_ptr<Vkx::PhysicalDevice> physical;
+    std::shared_ptr<Vkx::Device> device;
+    uint32_t family;
+    vk::Queue queue;
+    vk::UniqueCommandPool commandPool;
+};
+
+#endif // !defined(VKX_BENCH_HEADLESS_H)
@@ -0,0 +1,186 @@
+// Checks createStagingBuffer() and ImportedHostBuffer. CPU memory is imported with VK_EXT_external_memory_host when
+// the device has it enabled, even if it does not start or end on a minImportedHostPointerAlignment boundary. Otherwise
+// it is copied into a HostBuffer. Each staging buffer is copied back through the GPU and compared with its source.
+//
+// Usage: HostImportTest
+//
+// A software driver such as lavapipe supports the extension, so the test can run without a GPU (see Headless.h). If the
+// device does not support the extension, only the fallback is checked. The program returns 0 if every check passes, and
+// 77 (which ctest reports as skipped) if there is no Vulkan device.
+
+#include "Headless.h"
+
+#include <Vkx/Buffer.h>
+#include <Vkx/Vkx.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+int constexpr SKIPPED = 77;
+
+// Fills memory with a pattern that depends on the position, so that misplaced bytes are detected
+void fill(uint8_t * data, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        data[i] = uint8_t((i * 131 + seed * 7 + (i >> 8)) & 0xff);
+    }
+}
+
+// Copies a staging buffer through the GPU and returns true if the copy matches the source
+bool matches(Headless & context, Vkx::Buffer const & staging, uint8_t const * src, size_t size)
+{
+    Vkx::HostBuffer readback(context.device, size, vk::BufferUsageFlagBits::eTransferDst);
+    Vkx::executeOnceSynched(context.device, *context.commandPool, context.queue, [&] (vk::CommandBuffer & commands) {
+        commands.copyBuffer(staging, readback, vk::BufferCopy(0, 0, size));
+        vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+        commands.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eHost,
+                                 {},
+                                 barrier,
+                                 nullptr,
+                                 nullptr);
+    });
+    return std::memcmp(readback.data(), src, size) == 0;
+}
+
+// Reports the result of a check
+bool check(char const * name, bool ok)
+{
+    std::printf("%-52s %s\n", name, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Without the extension, nothing can be imported and the staging buffer is a copy
+bool checkFallback(Headless & context)
+{
+    bool passed = true;
+
+    std::vector<uint8_t> src(1000);
+    fill(src.data(), src.size(), 1);
+
+    bool refused = false;
+    try
+    {
+        Vkx::ImportedHostBuffer imported(context.device, src.data(), src.size());
+    }
+    catch (std::runtime_error const &)
+    {
+        refused = true;
+    }
+    passed &= check("fallback: ImportedHostBuffer is refused", refused);
+
+    std::unique_ptr<Vkx::Buffer> staging = Vkx::createStagingBuffer(context.device, src.data(), src.size());
+    bool copied = dynamic_cast<Vkx::HostBuffer *>(staging.get()) != nullptr;
+    passed &= check("fallback: staging buffer is a HostBuffer", copied);
+    passed &= check("fallback: contents", matches(context, *staging, src.data(), src.size()));
+    return passed;
+}
+
+// Imports memory at several offsets from the start of a page
+bool checkImport(Headless & context)
+{
+    bool passed = true;
+
+    auto properties = context.physical->getProperties2<vk::PhysicalDeviceProperties2,
+                                                       vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>();
+    size_t alignment = (size_t)properties.get<vk::PhysicalDeviceExternalMemoryHostPropertiesEXT>()
+                       .minImportedHostPointerAlignment;
+    std::printf("minImportedHostPointerAlignment: %zu\n", alignment);
+
+    // Three pages, with the first starting on an import boundary. The vector must outlive every buffer importing it.
+    std::vector<uint8_t> memory(alignment * 4);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory.data());
+    uint8_t * pages   = memory.data() + ((alignment - address % alignment) % alignment);
+    fill(pages, alignment * 3, 2);
+
+    struct Case
+    {
+        char const * name;
+        size_t offset;
+        size_t size;
+    };
+    Case const aligned[] = {
+        { "import: whole page", 0, alignment },
+        { "import: within a page", 256, 1024 },
+        { "import: across a page boundary", alignment - 256, 512 },
+        { "import: ending at a page boundary", alignment - 512, 512 },
+        { "import: several pages, unaligned end", 0, alignment * 2 + 100 }
+    };
+    for (auto const & c : aligned)
+    {
+        std::unique_ptr<Vkx::Buffer> staging = Vkx::createStagingBuffer(context.device, pages + c.offset, c.size);
+        bool imported = dynamic_cast<Vkx::ImportedHostBuffer *>(staging.get()) != nullptr;
+        passed &= check(c.name, imported && matches(context, *staging, pages + c.offset, c.size));
+    }
+
+    // Memory that is not aligned for a buffer cannot be imported, so it must be copied instead
+    uint8_t * unaligned = pages + 1;
+    size_t size         = 1000;
+    bool refused        = false;
+    try
+    {
+        Vkx::ImportedHostBuffer imported(context.device, unaligned, size);
+    }
+    catch (std::invalid_argument const &)
+    {
+        refused = true;
+    }
+    std::unique_ptr<Vkx::Buffer> staging = Vkx::createStagingBuffer(context.device, unaligned, size);
+    bool copied = dynamic_cast<Vkx::HostBuffer *>(staging.get()) != nullptr;
+    if (refused)
+        passed &= check("import: unaligned memory falls back to a copy", copied);
+    else
+        std::printf("%-52s %s\n", "import: unaligned memory falls back to a copy", "skipped (byte alignment)");
+    passed &= check("import: unaligned memory contents", matches(context, *staging, unaligned, size));
+    return passed;
+}
+} // anonymous namespace
+
+int main()
+{
+    std::unique_ptr<Headless> context;
+    try
+    {
+        context = std::make_unique<Headless>();
+    }
+    catch (std::exception const & e)
+    {
+        std::printf("HostImportTest: %s\n\nSKIPPED\n", e.what());
+        return SKIPPED;
+    }
+
+    try
+    {
+        std::printf("Device: %s\n\n", context->name().c_str());
+        bool passed = checkFallback(*context);
+
+        if (context->supports(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME))
+        {
+            Headless importing(vk::PhysicalDeviceFeatures(), nullptr, { VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME });
+            passed &= checkImport(importing);
+        }
+        else
+        {
+            std::printf("%s is not supported; the import path is not checked\n",
+                        VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+        }
+
+        std::printf("\n%s\n", passed ? "PASSED" : "FAILED");
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "HostImportTest: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
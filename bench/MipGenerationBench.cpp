@@ -0,0 +1,292 @@
+// Compares the mipmaps generated by ComputeMipGenerator with those blitted by LocalImage::generateMipmaps(), and times
+// both.
+//
+// Usage: MipGenerationBench [path to GenerateMipmaps.comp.spv]
+//
+// Both paths are checked against a CPU reference of the shader's filter: a 2x2 box of the previous level, clamped at the
+// edges and rounded to 8 bits. Where every reduction so far has halved an even size (or kept a size of 1), a linear blit
+// is the same box filter, so the blitted levels are checked too. Below an odd size, a blit filters bilinearly, which is
+// implementation-defined, so only the differences are reported.
+//
+// The program returns 0 if every check passes.
+
+#include "Headless.h"
+
+#include <Vkx/Buffer.h>
+#include <Vkx/ComputeMipGenerator.h>
+#include <Vkx/Image.h>
+#include <Vkx/Vkx.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if !defined(VKX_SHADER_DIR)
+#define VKX_SHADER_DIR "shaders"
+#endif
+
+namespace
+{
+int constexpr ITERATIONS = 10;  // Timed runs of each path. The fastest is reported.
+
+struct Level
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> texels;    // RGBA8
+};
+
+// A smooth pattern, so that the box and bilinear filters give similar results even where they differ
+std::vector<uint8_t> makeBaseLevel(uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> texels(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            float u = (x + 0.5f) / width;
+            float v = (y + 0.5f) / height;
+            uint8_t * t = &texels[(size_t(y) * width + x) * 4];
+            t[0] = (uint8_t)std::lround(255.0f * u);
+            t[1] = (uint8_t)std::lround(255.0f * v);
+            t[2] = (uint8_t)std::lround(127.5f + 127.5f * std::sin(6.2831853f * (u + v)));
+            t[3] = 255;
+        }
+    }
+    return texels;
+}
+
+// The shader's filter on the CPU
+std::vector<Level> referenceChain(Level const & base, uint32_t levels)
+{
+    std::vector<Level> chain{ base };
+    for (uint32_t i = 1; i < levels; ++i)
+    {
+        Level const & src = chain.back();
+        Level         dst{ std::max(src.width / 2, 1u), std::max(src.height / 2, 1u), {} };
+        dst.texels.resize(size_t(dst.width) * dst.height * 4);
+        for (uint32_t y = 0; y < dst.height; ++y)
+        {
+            for (uint32_t x = 0; x < dst.width; ++x)
+            {
+                uint32_t x0 = std::min(x * 2, src.width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+                uint32_t y0 = std::min(y * 2, src.height - 1);
+                uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+                for (int c = 0; c < 4; ++c)
+                {
+                    float sum = src.texels[(size_t(y0) * src.width + x0) * 4 + c] +
+                                src.texels[(size_t(y0) * src.width + x1) * 4 + c] +
+                                src.texels[(size_t(y1) * src.width + x0) * 4 + c] +
+                                src.texels[(size_t(y1) * src.width + x1) * 4 + c];
+                    dst.texels[(size_t(y) * dst.width + x) * 4 + c] = (uint8_t)std::lround(sum * 0.25f);
+                }
+            }
+        }
+        chain.push_back(std::move(dst));
+    }
+    return chain;
+}
+
+struct Difference
+{
+    int maximum = 0;
+    double mean = 0.0;
+};
+
+Difference compare(std::vector<uint8_t> const & a, std::vector<uint8_t> const & b)
+{
+    Difference d;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        int delta = std::abs(int(a[i]) - int(b[i]));
+        d.maximum = std::max(d.maximum, delta);
+        d.mean   += delta;
+    }
+    d.mean /= std::max<size_t>(a.size(), 1);
+    return d;
+}
+
+// Uploads the base level, generates the chain, and reads every level back. Returns the GPU time of the generation.
+double generate(Headless &                                context,
+                std::shared_ptr<Vkx::ComputeMipGenerator> generator,
+                Level const &                             base,
+                uint32_t                                  levels,
+                std::vector<std::vector<uint8_t>> &       result)
+{
+    vk::ImageCreateInfo info({},
+                             vk::ImageType::e2D,
+                             vk::Format::eR8G8B8A8Unorm,
+                             vk::Extent3D(base.width, base.height, 1),
+                             levels,
+                             1,
+                             vk::SampleCountFlagBits::e1,
+                             vk::ImageTiling::eOptimal,
+                             vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc |
+                             vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage);
+    Vkx::LocalImage image(context.device, info);
+    if (generator)
+        image.setMipGenerator(generator);
+
+    Vkx::HostBuffer staging(context.device,
+                            base.texels.size(),
+                            vk::BufferUsageFlagBits::eTransferSrc,
+                            base.texels.data());
+
+    // Every level is read back into one buffer, each at an aligned offset
+    std::vector<vk::BufferImageCopy> readbacks;
+    size_t size = 0;
+    for (uint32_t i = 0; i < levels; ++i)
+    {
+        uint32_t width  = std::max(base.width >> i, 1u);
+        uint32_t height = std::max(base.height >> i, 1u);
+        readbacks.push_back(vk::BufferImageCopy(size,
+                                                0,
+                                                0,
+                                                vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, 0, 1),
+                                                vk::Offset3D(0, 0, 0),
+                                                vk::Extent3D(width, height, 1)));
+        size += size_t(width) * height * 4;
+        size  = (size + 15) & ~size_t(15);
+    }
+    Vkx::HostBuffer readback(context.device, size, vk::BufferUsageFlagBits::eTransferDst);
+
+    vk::UniqueQueryPool queries =
+        context.device->createQueryPoolUnique(vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, 2));
+    Vkx::executeOnceSynched(context.device, *context.commandPool, context.queue, [&] (vk::CommandBuffer & commands) {
+        commands.resetQueryPool(*queries, 0, 2);
+        image.transitionLayout(commands, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+        image.copy(commands, staging);
+        commands.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queries, 0);
+        image.generateMipmaps(commands, vk::PipelineStageFlagBits::eComputeShader);
+        commands.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queries, 1);
+
+        vk::ImageMemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite,
+                                       vk::AccessFlagBits::eTransferRead,
+                                       vk::ImageLayout::eShaderReadOnlyOptimal,
+                                       vk::ImageLayout::eTransferSrcOptimal,
+                                       VK_QUEUE_FAMILY_IGNORED,
+                                       VK_QUEUE_FAMILY_IGNORED,
+                                       image,
+                                       vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1));
+        commands.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+                                 vk::PipelineStageFlagBits::eTransfer,
+                                 {},
+                                 nullptr,
+                                 nullptr,
+                                 barrier);
+        commands.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, readback, readbacks);
+    });
+
+    uint64_t timestamps[2];
+    (void)context.device->getQueryPoolResults(*queries,
+                                         0,
+                                         2,
+                                         sizeof(timestamps),
+                                         timestamps,
+                                         sizeof(uint64_t),
+                                         vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+
+    result.resize(levels);
+    for (uint32_t i = 0; i < levels; ++i)
+    {
+        uint8_t const * data = static_cast<uint8_t const *>(readback.data()) + readbacks[i].bufferOffset;
+        size_t bytes = size_t(readbacks[i].imageExtent.width) * readbacks[i].imageExtent.height * 4;
+        result[i].assign(data, data + bytes);
+    }
+
+    float period = context.physical->getProperties().limits.timestampPeriod;
+    return double(timestamps[1] - timestamps[0]) * period * 1.0e-6;
+}
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    std::string shaderPath = argc > 1 ? argv[1] : VKX_SHADER_DIR "/GenerateMipmaps.comp.spv";
+
+    // The sizes cover square, non-square, odd at the base level, odd further down, and 1-texel-wide images
+    struct Size
+    {
+        uint32_t width;
+        uint32_t height;
+    };
+    std::vector<Size> const sizes = {
+        { 256, 256 }, { 512, 128 }, { 257, 129 }, { 300, 200 }, { 1000, 333 }, { 1, 64 }
+    };
+
+    try
+    {
+        vk::PhysicalDeviceFeatures features;
+        features.shaderStorageImageWriteWithoutFormat    = VK_TRUE;
+        features.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
+        Headless context(features);
+        auto generator = std::make_shared<Vkx::ComputeMipGenerator>(context.device, shaderPath);
+        std::printf("Device: %s\n", context.name().c_str());
+
+        bool passed = true;
+        for (auto const & size : sizes)
+        {
+            Level    base{ size.width, size.height, makeBaseLevel(size.width, size.height) };
+            uint32_t levels = Vkx::Image::computeMaxMipLevels(size.width, size.height);
+            std::vector<Level> reference = referenceChain(base, levels);
+
+            std::vector<std::vector<uint8_t>> blitted;
+            std::vector<std::vector<uint8_t>> computed;
+            double blitTime    = 1.0e30;
+            double computeTime = 1.0e30;
+            for (int i = 0; i < ITERATIONS; ++i)
+            {
+                blitTime    = std::min(blitTime, generate(context, nullptr, base, levels, blitted));
+                computeTime = std::min(computeTime, generate(context, generator, base, levels, computed));
+            }
+
+            std::printf("\n%ux%u, %u levels: blit %.3f ms, compute %.3f ms\n",
+                        size.width,
+                        size.height,
+                        levels,
+                        blitTime,
+                        computeTime);
+            std::printf("level   size        compute-ref (max/mean)   blit-ref (max/mean)   blit-compute (max/mean)\n");
+
+            // A unorm result may be rounded either way, and the error can grow by a step at each level
+            bool exact = true;
+            for (uint32_t i = 1; i < levels; ++i)
+            {
+                Level const & previous = reference[i - 1];
+                exact = exact && (previous.width % 2 == 0 || previous.width == 1) &&
+                        (previous.height % 2 == 0 || previous.height == 1);
+
+                Difference computeError = compare(computed[i], reference[i].texels);
+                Difference blitError    = compare(blitted[i], reference[i].texels);
+                Difference between      = compare(blitted[i], computed[i]);
+                int tolerance = (int)i;
+                bool ok = computeError.maximum <= tolerance && (!exact || blitError.maximum <= tolerance);
+                passed  = passed && ok;
+                std::printf("%5u   %4ux%-4u   %3d / %-8.3f           %3d / %-8.3f        %3d / %-8.3f %s%s\n",
+                            i,
+                            reference[i].width,
+                            reference[i].height,
+                            computeError.maximum,
+                            computeError.mean,
+                            blitError.maximum,
+                            blitError.mean,
+                            between.maximum,
+                            between.mean,
+                            exact ? "" : "(bilinear blit) ",
+                            ok ? "" : "FAILED");
+            }
+        }
+
+        std::printf("\n%s\n", passed ? "PASSED" : "FAILED");
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "MipGenerationBench: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
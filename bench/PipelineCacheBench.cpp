@@ -0,0 +1,150 @@
+// Times pipeline creation with an empty pipeline cache, with a warm one, and with one saved to a file and loaded back,
+// and times PipelineCache's merge(), save() and load().
+//
+// Usage: PipelineCacheBench [path to GenerateMipmaps.comp.spv] [cache file (default: PipelineCacheBench.bin)]
+//
+// Drivers may keep caches of their own (Mesa's on-disk shader cache, for example), which make "cold" creation look
+// warm. Disable them for meaningful results (MESA_SHADER_CACHE_DISABLE=true for Mesa drivers).
+//
+// The program returns 0 if the saved cache is loaded back and every pipeline is created.
+
+#include "Headless.h"
+
+#include <Vkx/ComputeMipGenerator.h>
+#include <Vkx/PipelineCache.h>
+#include <Vkx/ShaderCache.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#if !defined(VKX_SHADER_DIR)
+#define VKX_SHADER_DIR "shaders"
+#endif
+
+namespace
+{
+int constexpr ITERATIONS = 10;  // Timed runs of each case. The fastest is reported.
+
+// Returns the time taken by a function in milliseconds
+template <typename F>
+double time(F && f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Creates the compute pipeline used by ComputeMipGenerator, with the same layout
+class Creator
+{
+public:
+    Creator(Vkx::Device & device, std::string const & shaderPath)
+        : device_(device)
+        , shader_(device.shaders().get(shaderPath))
+    {
+        vk::DescriptorSetLayoutBinding bindings[] =
+        {
+            vk::DescriptorSetLayoutBinding(0,
+                                           vk::DescriptorType::eCombinedImageSampler,
+                                           1,
+                                           vk::ShaderStageFlagBits::eCompute),
+            vk::DescriptorSetLayoutBinding(1,
+                                           vk::DescriptorType::eStorageImage,
+                                           Vkx::ComputeMipGenerator::MAX_LEVELS_PER_DISPATCH,
+                                           vk::ShaderStageFlagBits::eCompute),
+            vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute)
+        };
+        setLayout_ = device_.createDescriptorSetLayoutUnique(vk::DescriptorSetLayoutCreateInfo({}, 3, bindings));
+
+        // 128 bytes of push constants are always available, and cover the shader's parameters
+        vk::PushConstantRange pushConstants(vk::ShaderStageFlagBits::eCompute, 0, 128);
+        layout_ = device_.createPipelineLayoutUnique(
+            vk::PipelineLayoutCreateInfo({}, 1, &(*setLayout_), 1, &pushConstants));
+    }
+
+    void create(vk::PipelineCache cache) const
+    {
+        vk::ComputePipelineCreateInfo info({},
+                                           vk::PipelineShaderStageCreateInfo({},
+                                                                             vk::ShaderStageFlagBits::eCompute,
+                                                                             *shader_,
+                                                                             "main"),
+                                           *layout_);
+        // The pipeline is destroyed with the result
+        (void)device_.createComputePipelineUnique(cache, info);
+    }
+
+private:
+    Vkx::Device & device_;
+    Vkx::ShaderCache::Module shader_;
+    vk::UniqueDescriptorSetLayout setLayout_;
+    vk::UniquePipelineLayout layout_;
+};
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    std::string shaderPath = argc > 1 ? argv[1] : VKX_SHADER_DIR "/GenerateMipmaps.comp.spv";
+    std::string cachePath  = argc > 2 ? argv[2] : "PipelineCacheBench.bin";
+
+    try
+    {
+        Headless context;
+        std::printf("Device: %s\n\n", context.name().c_str());
+        Vkx::Device & device = *context.device;
+        Creator creator(device, shaderPath);
+        vk::PhysicalDeviceProperties properties = context.physical->getProperties();
+
+        // Each cold run uses a new, empty cache
+        double cold = 1.0e30;
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            vk::UniquePipelineCache empty = device.pipelineCache().createWorkerCache();
+            cold = std::min(cold, time([&] { creator.create(*empty); }));
+        }
+
+        // A worker cache is warmed, and merged into the device's cache
+        vk::UniquePipelineCache worker = device.pipelineCache().createWorkerCache();
+        creator.create(*worker);
+        double warm = 1.0e30;
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            warm = std::min(warm, time([&] { creator.create(*worker); }));
+        }
+        double merge = time([&] { device.pipelineCache().merge(*worker); });
+
+        size_t size = device.pipelineCache().data().size();
+        double save = time([&] { device.pipelineCache().save(cachePath); });
+
+        // The file is loaded into a new cache, as it would be in the next run
+        Vkx::PipelineCache reloaded(device, properties);
+        bool loaded = false;
+        double load = time([&] { loaded = reloaded.load(cachePath); });
+        double fromFile = 1.0e30;
+        for (int i = 0; i < ITERATIONS; ++i)
+        {
+            fromFile = std::min(fromFile, time([&] { creator.create(reloaded); }));
+        }
+
+        std::printf("pipeline creation, empty cache    %9.3f ms\n", cold);
+        std::printf("pipeline creation, warm cache     %9.3f ms\n", warm);
+        std::printf("pipeline creation, loaded cache   %9.3f ms\n", fromFile);
+        std::printf("merge                             %9.3f ms\n", merge);
+        std::printf("save                              %9.3f ms (%zu bytes)\n", save, size);
+        std::printf("load                              %9.3f ms %s\n", load, loaded ? "" : "(not loaded) FAILED");
+
+        std::printf("\n%s\n", loaded ? "PASSED" : "FAILED");
+        return loaded ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const & e)
+    {
+        std::fprintf(stderr, "PipelineCacheBench: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,100 @@
+#if !defined(VKX_BINDLESSTEXTURETABLE_H)
+#define VKX_BINDLESSTEXTURETABLE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+class SwapChain;
+
+//! A single descriptor set holding a large array of sampled images, indexed by shaders.
+//!
+//! The set has one binding (0) that is an array of sampled images. The array is partially bound and updated after bind, so
+//! the set can be bound once per command buffer while textures are added and removed, and draws only need to pass the
+//! indices of their textures (in push constants or per-instance data, for example):
+//!
+//!     layout(set = 0, binding = 0) uniform texture2D textures[];
+//!     ...
+//!     texture(sampler2D(textures[nonuniformEXT(index)], linearSampler), uv)
+//!
+//! An index is stable until it is removed. A removed index is not reused until the frame that removed it comes around again
+//! (see beginFrame()), so that command buffers still in flight never see a different texture at an index they use.
+//!
+//! The device must support descriptor indexing (Vulkan 1.2 or VK_EXT_descriptor_indexing), with the features returned by
+//! requiredFeatures() enabled.
+//!
+//! @note   The table must be used from a single thread.
+//! @note   A BindlessTextureTable cannot be copied or moved.
+
+class BindlessTextureTable
+{
+public:
+    //! Identifies a texture's element in the array.
+    using Index = uint32_t;
+
+    static Index constexpr INVALID_INDEX = ~0u;  //!< An index that never refers to a texture
+
+    //! Constructor.
+    BindlessTextureTable(std::shared_ptr<Device> device,
+                         uint32_t                capacity,
+                         int                     frames,
+                         vk::ShaderStageFlags    stages = vk::ShaderStageFlagBits::eAll);
+
+    //! Returns the descriptor indexing features that the device must enable.
+    static vk::PhysicalDeviceDescriptorIndexingFeatures requiredFeatures();
+
+    //! Adds a texture to the table and returns its index, or INVALID_INDEX if the table is full.
+    Index add(vk::ImageView view, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    //! Replaces the texture at an index.
+    void set(Index index, vk::ImageView view, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    //! Removes a texture from the table.
+    void remove(Index index);
+
+    //! Starts a frame, making the indices removed during its previous use available again.
+    void beginFrame(int frame);
+
+    //! Starts the swap chain's current frame, making the indices removed during its previous use available again.
+    void beginFrame(SwapChain const & swapChain);
+
+    //! Returns the layout of the table's descriptor set.
+    vk::DescriptorSetLayout layout() const { return *layout_; }
+
+    //! Returns the table's descriptor set.
+    vk::DescriptorSet descriptorSet() const { return set_; }
+
+    //! Returns the number of elements in the array.
+    uint32_t capacity() const { return capacity_; }
+
+    //! Returns the number of textures in the table.
+    size_t size() const { return size_; }
+
+private:
+    // Non-copyable
+    BindlessTextureTable(BindlessTextureTable const &) = delete;
+    BindlessTextureTable & operator =(BindlessTextureTable const &) = delete;
+
+    void write(Index index, vk::ImageView view, vk::ImageLayout layout);
+
+    std::shared_ptr<Device> device_;
+    uint32_t capacity_;
+    vk::UniqueDescriptorSetLayout layout_;
+    vk::UniqueDescriptorPool pool_;
+    vk::DescriptorSet set_;                         // Freed with the pool
+    size_t size_ = 0;
+    Index next_ = 0;                                // Indices from here on have never been used
+    std::vector<Index> freeIndices_;
+    std::vector<std::vector<Index>> removed_;       // Indices removed during each frame, not yet reusable
+    int currentFrame_ = 0;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_BINDLESSTEXTURETABLE_H)
@@ -0,0 +1,45 @@
+#if !defined(VKX_BLOCKCOMPRESSOR_H)
+#define VKX_BLOCKCOMPRESSOR_H
+
+#pragma once
+
+#include <Vkx/Image.h>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class ThreadPool;
+
+//! Block-compressed formats produced by compressImage()
+enum class BlockFormat
+{
+    eBC1,   //!< RGB with 1-bit alpha, 4 bits per texel
+    eBC3,   //!< RGBA, 8 bits per texel
+    eBC4,   //!< One channel (red), 4 bits per texel
+    eBC5,   //!< Two channels (red and green), 8 bits per texel
+    eBC7    //!< RGBA at higher quality than BC3, 8 bits per texel
+};
+
+//! Trade-offs between the speed of compressImage() and the quality of its results
+enum class CompressionQuality
+{
+    eFast,      //!< Bounding-box endpoints. Suitable for textures generated every few frames.
+    eNormal,    //!< Principal-axis endpoints, refined once
+    eBest       //!< Principal-axis endpoints, refined repeatedly, with wider searches
+};
+
+//! Returns true if compressImage() can compress images of the format into the block format.
+bool canCompressImage(vk::Format format, BlockFormat block);
+
+//! Returns the format of an image compressed into the block format.
+vk::Format compressedFormat(vk::Format format, BlockFormat block);
+
+//! Compresses all of an image's levels and layers on the CPU.
+ImageData compressImage(ImageData const &  data,
+                        BlockFormat        block,
+                        CompressionQuality quality = CompressionQuality::eNormal,
+                        ThreadPool *       workers = nullptr);
+} // namespace Vkx
+
+#endif // !defined(VKX_BLOCKCOMPRESSOR_H)
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vulkan/vulkan.hpp>
 #include <Vkx/Device.h>
 #include <Vkx/Vkx.h>
@@ -61,6 +62,8 @@ private:
 
 //! A Buffer that is visible to the CPU and is automatically kept in sync (eHostVisible | eHostCoherent).
 //!
+//! The buffer's memory is mapped for the buffer's whole lifetime, so it can be written directly through data().
+//!
 //! @ingroup Buffers
 
 class HostBuffer : public Buffer
@@ -76,10 +79,54 @@ public:
                void const *            src         = nullptr,
                vk::SharingMode         sharingMode = vk::SharingMode::eExclusive);
 
+    //! Move constructor.
+    HostBuffer(HostBuffer && src);
+
+    //! Move-assignment operator.
+    HostBuffer & operator =(HostBuffer && rhs);
+
     //! Copies CPU memory into the buffer
     void set(size_t offset, void const * src, size_t size);
+
+    //! Returns the CPU address of the buffer's memory.
+    void * data() const { return data_; }
+
+private:
+    void * data_ = nullptr; // Persistently-mapped memory
 };
 
+//! A Buffer whose memory is existing CPU memory, imported with VK_EXT_external_memory_host instead of being copied.
+//!
+//! Any CPU memory can be imported, such as a memory-mapped file (see MappedFile) or a decoder's output. The pages containing
+//! the memory are imported, so the memory itself needs no particular alignment beyond the buffer's own alignment requirement,
+//! and the buffer starts exactly at the given address.
+//!
+//! @ingroup Buffers
+//! @note   The device must have been created with VK_EXT_external_memory_host enabled.
+//! @warning    The memory is not owned by the buffer. It must remain valid until the buffer is destroyed and the GPU has
+//!             finished using it.
+
+class ImportedHostBuffer : public Buffer
+{
+public:
+    //! Constructor.
+    ImportedHostBuffer() = default;
+
+    //! Constructor.
+    ImportedHostBuffer(std::shared_ptr<Device> device,
+                       void const *            src,
+                       size_t                  size,
+                       vk::BufferUsageFlags    usage       = vk::BufferUsageFlagBits::eTransferSrc,
+                       vk::SharingMode         sharingMode = vk::SharingMode::eExclusive);
+
+    //! Returns true if the device can import CPU memory.
+    static bool isSupported(Device const & device);
+};
+
+//! Returns a buffer that can be used as the source of transfers of CPU memory, without copying the memory if possible.
+//! @ingroup Buffers
+std::unique_ptr<Buffer> createStagingBuffer(std::shared_ptr<Device> device, void const * src, size_t size);
+
 //! A Buffer that is visible only to the GPU (eDeviceLocal).
 //!
 //! @ingroup Buffers
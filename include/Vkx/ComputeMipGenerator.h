@@ -0,0 +1,68 @@
+#if !defined(VKX_COMPUTEMIPGENERATOR_H)
+#define VKX_COMPUTEMIPGENERATOR_H
+
+#pragma once
+
+#include <Vkx/Buffer.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+class Image;
+
+//! Resources used by the commands recorded by ComputeMipGenerator::record(). They must be kept until the commands have been
+//! executed.
+struct MipDispatch
+{
+    vk::UniqueDescriptorPool descriptorPool;    //!< Pool of the dispatches' descriptor sets
+    std::vector<vk::UniqueImageView> views;     //!< Views of the individual levels
+    std::vector<LocalBuffer> intermediates;     //!< Counter and level 6 texels of each dispatch
+};
+
+//! Generates mipmaps with a compute shader instead of a chain of blits.
+//!
+//! Up to 12 levels are generated by each dispatch (see shaders/GenerateMipmaps.comp), so most images need only one dispatch
+//! and one barrier instead of a blit and a barrier per level. The shader must be compiled to SPIR-V, which the build does if
+//! glslc is found.
+//!
+//! @note   The device must support shaderStorageImageWriteWithoutFormat and shaderStorageImageArrayDynamicIndexing, and
+//!         the images must be created with vk::ImageUsageFlagBits::eStorage.
+//! @note   A ComputeMipGenerator cannot be copied or moved.
+
+class ComputeMipGenerator
+{
+public:
+    //! Maximum number of levels generated by a single dispatch
+    static uint32_t constexpr MAX_LEVELS_PER_DISPATCH = 12;
+
+    //! Constructor.
+    ComputeMipGenerator(std::shared_ptr<Device> device, std::string const & shaderPath);
+
+    //! Returns true if mipmaps can be generated for images of the format.
+    bool supports(vk::Format format) const;
+
+    //! Records the commands that generate an image's mipmaps.
+    std::shared_ptr<MipDispatch> record(vk::CommandBuffer &    commands,
+                                        Image const &          image,
+                                        vk::PipelineStageFlags shaderStages = vk::PipelineStageFlagBits::eFragmentShader) const;
+
+private:
+    // Non-copyable
+    ComputeMipGenerator(ComputeMipGenerator const &) = delete;
+    ComputeMipGenerator & operator =(ComputeMipGenerator const &) = delete;
+
+    std::shared_ptr<Device> device_;
+    vk::Sampler sampler_;     // Owned by the device's sampler cache
+    vk::UniqueDescriptorSetLayout descriptorSetLayout_;
+    vk::UniquePipelineLayout pipelineLayout_;
+    vk::UniquePipeline pipeline_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_COMPUTEMIPGENERATOR_H)
@@ -0,0 +1,91 @@
+#if !defined(VKX_DESCRIPTORALLOCATOR_H)
+#define VKX_DESCRIPTORALLOCATOR_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+class SwapChain;
+
+//! Allocates descriptor sets that live for one frame, from pools that grow on demand.
+//!
+//! Each frame in flight has its own list of descriptor pools. When a pool runs out of space, the next pool in the list is
+//! used, and a new pool (twice as large as the previous one, up to a limit) is added if there is none. beginFrame() resets
+//! all of a frame's pools at once, so the sets are never freed individually and the pools are kept for reuse.
+//!
+//! @note   Allocation is thread-safe.
+//! @note   A DescriptorAllocator cannot be copied or moved.
+
+class DescriptorAllocator
+{
+public:
+    //! Allocation counts
+    struct Statistics
+    {
+        size_t pools;       //!< Number of pools in all frames
+        size_t sets;        //!< Number of sets allocated since their frames were last reset
+        size_t allocations; //!< Number of sets allocated since the allocator was created
+        size_t growths;     //!< Number of times a pool ran out of space
+    };
+
+    //! Constructor.
+    DescriptorAllocator(std::shared_ptr<Device>                     device,
+                        std::vector<vk::DescriptorPoolSize> const & descriptorsPerSet,
+                        int                                         frames,
+                        uint32_t                                    setsPerPool = 64);
+
+    //! Starts a frame, resetting the pools of its previous allocations.
+    void beginFrame(int frame);
+
+    //! Starts the swap chain's current frame, resetting the pools of its previous allocations.
+    void beginFrame(SwapChain const & swapChain);
+
+    //! Allocates a descriptor set for the current frame.
+    vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+
+    //! Returns the allocation counts.
+    Statistics statistics() const;
+
+private:
+    // Non-copyable
+    DescriptorAllocator(DescriptorAllocator const &) = delete;
+    DescriptorAllocator & operator =(DescriptorAllocator const &) = delete;
+
+    static uint32_t constexpr MAX_SETS_PER_POOL = 4096;
+
+    struct Pool
+    {
+        vk::UniqueDescriptorPool pool;
+        uint32_t maxSets;
+        bool used = false;      // True if sets have been allocated since the pool was created or reset
+    };
+
+    struct FrameData
+    {
+        std::vector<Pool> pools;
+        size_t current = 0;     // Index of the pool that sets are allocated from
+        size_t sets = 0;        // Number of sets allocated since the frame was reset
+    };
+
+    void addPool(FrameData & frame);
+
+    std::shared_ptr<Device> device_;
+    std::vector<vk::DescriptorPoolSize> descriptorsPerSet_;
+    uint32_t setsPerPool_;
+    std::vector<FrameData> frames_;
+    int currentFrame_ = 0;
+    size_t allocations_ = 0;
+    size_t growths_ = 0;
+    mutable std::mutex mutex_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_DESCRIPTORALLOCATOR_H)
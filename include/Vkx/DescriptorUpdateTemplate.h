@@ -0,0 +1,148 @@
+#if !defined(VKX_DESCRIPTORUPDATETEMPLATE_H)
+#define VKX_DESCRIPTORUPDATETEMPLATE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+
+//! Updates all of a descriptor set's bindings from a struct in a single call.
+//!
+//! The struct holds a vk::DescriptorImageInfo, vk::DescriptorBufferInfo, or vk::BufferView (or an array of them) for each
+//! binding, and the template is created from a list of its members:
+//!
+//!     struct MaterialDescriptors
+//!     {
+//!         vk::DescriptorBufferInfo parameters;
+//!         vk::DescriptorImageInfo  maps[3];
+//!     };
+//!
+//!     DescriptorUpdateTemplate materialUpdate(device, layout, {
+//!         DescriptorUpdateTemplate::entry(0, vk::DescriptorType::eUniformBuffer, &MaterialDescriptors::parameters),
+//!         DescriptorUpdateTemplate::entry(1, vk::DescriptorType::eCombinedImageSampler, &MaterialDescriptors::maps)
+//!     });
+//!     ...
+//!     materialUpdate.update(set, descriptors);
+//!
+//! This replaces building an array of vk::WriteDescriptorSet and calling vk::Device::updateDescriptorSets() each time.
+//!
+//! @note   Descriptor update templates are core in Vulkan 1.1.
+//! @note   A DescriptorUpdateTemplate cannot be copied or moved.
+
+class DescriptorUpdateTemplate
+{
+public:
+    //! Constructor.
+    DescriptorUpdateTemplate(std::shared_ptr<Device>                                device,
+                             vk::DescriptorSetLayout                                layout,
+                             std::vector<vk::DescriptorUpdateTemplateEntry> const & entries);
+
+    //! Returns an entry that updates a binding from a member of a struct.
+    template <typename S, typename M>
+    static vk::DescriptorUpdateTemplateEntry entry(uint32_t           binding,
+                                                   vk::DescriptorType type,
+                                                   M S::*             member,
+                                                   uint32_t           arrayElement = 0);
+
+    //! Updates a descriptor set from a struct whose layout matches the entries.
+    template <typename S>
+    void update(vk::DescriptorSet set, S const & data) const
+    {
+        static_assert(std::is_standard_layout_v<S>, "descriptor structs must have standard layout");
+        update(set, &data, sizeof(S));
+    }
+
+    //! Updates a descriptor set from data laid out as described by the entries.
+    void update(vk::DescriptorSet set, void const * data, size_t size) const;
+
+    //! Implicitly converts to the underlying vk::DescriptorUpdateTemplate
+    operator vk::DescriptorUpdateTemplate() const { return *template_; }
+
+private:
+    // Non-copyable
+    DescriptorUpdateTemplate(DescriptorUpdateTemplate const &) = delete;
+    DescriptorUpdateTemplate & operator =(DescriptorUpdateTemplate const &) = delete;
+
+    // Kinds of descriptor info held by the members
+    enum class Kind
+    {
+        eImage,
+        eBuffer,
+        eTexelBuffer
+    };
+
+    template <typename T>
+    struct Element
+    {
+        using Type = T;
+        static uint32_t constexpr COUNT = 1;
+    };
+
+    template <typename T, size_t N>
+    struct Element<T[N]>
+    {
+        using Type = T;
+        static uint32_t constexpr COUNT = (uint32_t)N;
+    };
+
+    static vk::DescriptorUpdateTemplateEntry makeEntry(uint32_t           binding,
+                                                       uint32_t           arrayElement,
+                                                       uint32_t           count,
+                                                       vk::DescriptorType type,
+                                                       Kind               kind,
+                                                       size_t             offset,
+                                                       size_t             stride);
+
+    std::shared_ptr<Device> device_;
+    vk::UniqueDescriptorUpdateTemplate template_;
+    size_t size_ = 0;   // Number of bytes read by an update
+};
+
+//! @param  binding         Binding to update
+//! @param  type            Type of the binding's descriptors
+//! @param  member          Member holding the descriptor info. An array member updates consecutive array elements.
+//! @param  arrayElement    First array element to update (default: 0)
+//!
+//! @return template entry
+//!
+//! @warning    A std::invalid_argument is thrown if the member's type does not hold descriptors of the given type
+template <typename S, typename M>
+vk::DescriptorUpdateTemplateEntry DescriptorUpdateTemplate::entry(uint32_t           binding,
+                                                                  vk::DescriptorType type,
+                                                                  M S::*             member,
+                                                                  uint32_t           arrayElement /*= 0*/)
+{
+    static_assert(std::is_standard_layout_v<S>, "descriptor structs must have standard layout");
+    using T = typename Element<M>::Type;
+    static_assert(std::is_same_v<T, vk::DescriptorImageInfo> ||
+                  std::is_same_v<T, vk::DescriptorBufferInfo> ||
+                  std::is_same_v<T, vk::BufferView>,
+                  "descriptor members must be vk::DescriptorImageInfo, vk::DescriptorBufferInfo, vk::BufferView, or arrays of them");
+
+    Kind kind = std::is_same_v<T, vk::DescriptorImageInfo>  ? Kind::eImage
+              : std::is_same_v<T, vk::DescriptorBufferInfo> ? Kind::eBuffer
+              : Kind::eTexelBuffer;
+
+    // The member's offset, found without constructing an S
+    union Storage
+    {
+        Storage() {}
+        ~Storage() {}
+        S s;
+    } storage;
+    size_t offset = (size_t)(reinterpret_cast<char const *>(&(storage.s.*member)) -
+                             reinterpret_cast<char const *>(&storage.s));
+
+    return makeEntry(binding, arrayElement, Element<M>::COUNT, type, kind, offset, sizeof(T));
+}
+} // namespace Vkx
+
+#endif // !defined(VKX_DESCRIPTORUPDATETEMPLATE_H)
@@ -5,6 +5,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 
@@ -15,13 +16,17 @@ namespace Vkx
 {
 class Instance;
 class PhysicalDevice;
+class PipelineCache;
+class SamplerCache;
+class ShaderCache;
 
 //! A destructible extension to vk::Device.
 //!
 //! @ingroup Devices
 //! @note   A Device can be moved, but cannot be copied or assigned.
+//! @note   A Device is normally owned by a std::shared_ptr. Shader modules from shaders() keep it alive only then.
 
-class Device : public vk::Device
+class Device : public vk::Device, public std::enable_shared_from_this<Device>
 {
 public:
     //! Constructor.
@@ -39,12 +44,32 @@ public:
     //! Returns the physical device this device is associated with.
     std::shared_ptr<PhysicalDevice> physical() const { return physicalDevice_; }
 
+    //! Returns the cache of samplers shared by everything using this device.
+    SamplerCache & samplers() const { return *samplers_; }
+
+    //! Returns the pipeline cache shared by everything using this device.
+    PipelineCache & pipelineCache() const { return *pipelineCache_; }
+
+    //! Returns the cache of shader modules shared by everything using this device.
+    ShaderCache & shaders() const { return *shaders_; }
+
+    //! Returns true if the extension was enabled when the device was created.
+    bool extensionEnabled(char const * name) const;
+
+    //! Returns the core features that were enabled when the device was created.
+    vk::PhysicalDeviceFeatures const & enabledFeatures() const { return features_; }
+
 private:
     // Non-copyable
     Device(Device const &) = delete;
     Device & operator =(Device const &) = delete;
 
     std::shared_ptr<PhysicalDevice> physicalDevice_;
+    std::unique_ptr<SamplerCache> samplers_;        // Destroyed before the device
+    std::unique_ptr<PipelineCache> pipelineCache_;  // Saved and destroyed before the device
+    std::unique_ptr<ShaderCache> shaders_;          // Destroyed before the device
+    std::vector<std::string> extensions_;           // Enabled extensions
+    vk::PhysicalDeviceFeatures features_;           // Enabled core features
 };
 
 //! A destructible extension to vk::PhysicalDevice.
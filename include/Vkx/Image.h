@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include <vulkan/vulkan.hpp>
 #include <Vkx/Device.h>
 #include <Vkx/Vkx.h>
@@ -12,6 +14,24 @@
 
 namespace Vkx
 {
+class ComputeMipGenerator;
+struct MipDispatch;
+
+//! Image contents in CPU memory, ready to be uploaded.
+//!
+//! If there are no regions, the pixels are the tightly-packed texels of mip level 0 of each layer, one layer after another,
+//! and any other levels are generated. If the regions include levels other than level 0, then every level is provided and
+//! none are generated.
+struct ImageData
+{
+    vk::ImageCreateInfo info;                   //!< Creation info for the image
+    std::vector<uint8_t> pixels;                //!< Texel data
+    std::vector<vk::BufferImageCopy> regions;   //!< Where each part of the texel data goes in the image
+
+    //! Returns true if the data provides levels other than level 0.
+    bool hasMipmaps() const;
+};
+
 //! An extension to vk::Image that supports ownership of the memory and the view.
 //!
 //! @note   Instances can be moved, but cannot be copied.
@@ -48,8 +68,11 @@ public:
     //! Returns the creation info.
     vk::ImageCreateInfo info() const { return info_; }
 
-    //! Returns the maximum number of mip levels needed for the given with and height.
-    static uint32_t computeMaxMipLevels(uint32_t width, uint32_t height);
+    //! Returns the maximum number of mip levels needed for the given width, height and depth.
+    static uint32_t computeMaxMipLevels(uint32_t width, uint32_t height, uint32_t depth = 1);
+
+    //! Returns the type of the view of an image created with the given info.
+    static vk::ImageViewType viewType(vk::ImageCreateInfo const & info);
 
 protected:
     std::shared_ptr<Device> device_;    //!< Device associated with this image
@@ -65,6 +88,12 @@ private:
 };
 
 //! An Image that is visible to the CPU and is automatically kept in sync (eHostVisible | eHostCoherent).
+//!
+//! The image's memory is mapped for the image's whole lifetime. Writes respect the row pitch of the image's layout, which is
+//! queried once when the image is created.
+//!
+//! @note   The image must have linear tiling.
+//! @note   Only level 0 of layer 0 is accessible, which is all that a linear image is guaranteed to have.
 class HostImage : public Image
 {
 public:
@@ -78,8 +107,27 @@ public:
               size_t                      size = 0,
               vk::ImageAspectFlags        aspect = vk::ImageAspectFlagBits::eColor);
 
-    //! Copies image data from CPU memory into the image.
+    //! Move constructor
+    HostImage(HostImage && src);
+
+    //! Move-assignment operator
+    HostImage & operator =(HostImage && rhs);
+
+    //! Copies image data from CPU memory into the image, starting at an offset into its tightly-packed texels.
     void set(void const * src, size_t offset, size_t size);
+
+    //! Copies a rectangle of texels from CPU memory into the image.
+    void set(vk::Rect2D const & rect, void const * src, size_t srcPitch);
+
+    //! Returns the CPU address of the image's texels.
+    void * data() const { return data_; }
+
+    //! Returns the layout of the image's texels in memory.
+    vk::SubresourceLayout const & layout() const { return layout_; }
+
+private:
+    void * data_ = nullptr;         // Persistently-mapped memory
+    vk::SubresourceLayout layout_;  // Layout of level 0 of layer 0
 };
 
 //! An Image that is accessible only to the GPU (eDeviceLocal).
@@ -103,26 +151,112 @@ public:
                size_t                  size,
                vk::ImageAspectFlags    aspect = vk::ImageAspectFlagBits::eColor);
 
+    //! Constructor.
+    LocalImage(std::shared_ptr<Device> device,
+               vk::CommandPool const & commandPool,
+               vk::Queue const &       queue,
+               ImageData const &       data,
+               vk::ImageAspectFlags    aspect = vk::ImageAspectFlagBits::eColor);
+
     //! Copies data from CPU memory into the image
     void set(vk::CommandPool const & commandPool,
              vk::Queue const &       queue,
              void const *            src,
              size_t                  size);
 
+    //! Converts data in another format from CPU memory into the image
+    void set(vk::CommandPool const & commandPool,
+             vk::Queue const &       queue,
+             void const *            src,
+             vk::Format              srcFormat);
+
+    //! Copies image data, including any mip levels it provides, into the image
+    void set(vk::CommandPool const & commandPool,
+             vk::Queue const &       queue,
+             ImageData const &       data);
+
+    //! Copies one layer from CPU memory into the image
+    void setLayer(vk::CommandPool const & commandPool,
+                  vk::Queue const &       queue,
+                  uint32_t                layer,
+                  void const *            src,
+                  size_t                  size);
+
+    //! Copies rectangles of one level of one layer from CPU memory into the image
+    void update(vk::CommandPool const &         commandPool,
+                vk::Queue const &               queue,
+                void const *                    src,
+                std::vector<vk::Rect2D> const & rects,
+                uint32_t                        level = 0,
+                uint32_t                        layer = 0);
+
+    //! Records commands that copy rectangles of one level of one layer from a buffer into the image
+    void update(vk::CommandBuffer &             commands,
+                vk::Buffer const &              buffer,
+                std::vector<vk::Rect2D> const & rects,
+                uint32_t                        level = 0,
+                uint32_t                        layer = 0);
+
     //! Copies data from a buffer into the image
     void copy(vk::CommandPool const & commandPool,
               vk::Queue const &       queue,
               vk::Buffer const &      buffer);
 
+    //! Records commands that copy data from a buffer into the image
+    void copy(vk::CommandBuffer & commands, vk::Buffer const & buffer);
+
+    //! Records commands that copy regions of a buffer into the image
+    void copy(vk::CommandBuffer &                      commands,
+              vk::Buffer const &                       buffer,
+              std::vector<vk::BufferImageCopy> const & regions);
+
     //! Transitions the image's layout
     void transitionLayout(vk::CommandPool const & commandPool,
                           vk::Queue const &       queue,
                           vk::ImageLayout         oldLayout,
                           vk::ImageLayout         newLayout);
 
+    //! Records commands that transition the image's layout
+    void transitionLayout(vk::CommandBuffer &    commands,
+                          vk::ImageLayout        oldLayout,
+                          vk::ImageLayout        newLayout,
+                          vk::PipelineStageFlags shaderStages = vk::PipelineStageFlagBits::eFragmentShader);
+
+    //! Records commands that transition the layout of some of the image's layers
+    void transitionLayout(vk::CommandBuffer &    commands,
+                          vk::ImageLayout        oldLayout,
+                          vk::ImageLayout        newLayout,
+                          uint32_t               baseLayer,
+                          uint32_t               layerCount,
+                          vk::PipelineStageFlags shaderStages = vk::PipelineStageFlagBits::eFragmentShader);
+
     //! Generates mipmaps for the image
     void generateMipmaps(vk::CommandPool const & commandPool,
                          vk::Queue const &       queue);
+
+    //! Records commands that generate mipmaps for the image
+    void generateMipmaps(vk::CommandBuffer &    commands,
+                         vk::PipelineStageFlags shaderStages = vk::PipelineStageFlagBits::eFragmentShader);
+
+    //! Records commands that generate mipmaps for some of the image's layers
+    void generateMipmaps(vk::CommandBuffer &    commands,
+                         uint32_t               baseLayer,
+                         uint32_t               layerCount,
+                         vk::PipelineStageFlags shaderStages = vk::PipelineStageFlagBits::eFragmentShader);
+
+    //! Returns true if mipmaps for the image can be generated by blitting.
+    bool canBlitMipmaps() const;
+
+    //! Sets the compute shader generator used by generateMipmaps(), or nullptr to blit. Images it cannot handle are blitted.
+    void setMipGenerator(std::shared_ptr<ComputeMipGenerator> generator) { mipGenerator_ = generator; }
+
+private:
+    std::vector<vk::Rect2D> validatedRects(std::vector<vk::Rect2D> const & rects, uint32_t level, uint32_t layer) const;
+    bool usesMipGenerator() const;
+    bool gpuCanGenerateMipmaps() const;
+
+    std::shared_ptr<ComputeMipGenerator> mipGenerator_; // Generates mipmaps instead of blits, if set
+    std::shared_ptr<MipDispatch> mipDispatch_;          // Resources of the last mip generation dispatch
 };
 
 //! A LocalImage for use as a depth buffer (vk::ImageAspect::eDEPTH).
@@ -0,0 +1,54 @@
+#if !defined(VKX_MAPPEDFILE_H)
+#define VKX_MAPPEDFILE_H
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Vkx
+{
+//! A read-only file mapped into memory.
+//!
+//! The contents are paged in on demand rather than read up front, and the mapping starts on a page boundary, so the contents
+//! can be imported into an ImportedHostBuffer and uploaded without being copied.
+//!
+//! @note   A MappedFile can be moved, but cannot be copied.
+
+class MappedFile
+{
+public:
+    //! Constructor.
+    MappedFile() = default;
+
+    //! Constructor.
+    explicit MappedFile(std::string const & path);
+
+    //! Move constructor.
+    MappedFile(MappedFile && src);
+
+    //! Destructor.
+    ~MappedFile();
+
+    //! Move-assignment operator.
+    MappedFile & operator =(MappedFile && rhs);
+
+    //! Returns the contents of the file, or nullptr if the file is empty.
+    void const * data() const { return data_; }
+
+    //! Returns the size of the file.
+    size_t size() const { return size_; }
+
+private:
+    // Non-copyable
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator =(MappedFile const &) = delete;
+
+    void unmap();
+
+    void const * data_ = nullptr;
+    size_t size_       = 0;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_MAPPEDFILE_H)
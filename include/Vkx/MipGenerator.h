@@ -0,0 +1,28 @@
+#if !defined(VKX_MIPGENERATOR_H)
+#define VKX_MIPGENERATOR_H
+
+#pragma once
+
+#include <Vkx/Image.h>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class ThreadPool;
+
+//! Filters used to generate mip levels on the CPU
+enum class MipFilter
+{
+    eBox,       //!< Averages each 2x2 block of texels. Fastest.
+    eKaiser     //!< Kaiser-windowed sinc. Sharper, at a higher cost.
+};
+
+//! Returns true if generateMipChain() supports the image.
+bool canGenerateMipChain(vk::ImageCreateInfo const & info);
+
+//! Generates all of an image's mip levels on the CPU.
+void generateMipChain(ImageData & data, MipFilter filter = MipFilter::eBox, ThreadPool * workers = nullptr);
+} // namespace Vkx
+
+#endif // !defined(VKX_MIPGENERATOR_H)
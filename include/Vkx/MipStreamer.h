@@ -0,0 +1,180 @@
+#if !defined(VKX_MIPSTREAMER_H)
+#define VKX_MIPSTREAMER_H
+
+#pragma once
+
+#include <Vkx/Buffer.h>
+#include <Vkx/Image.h>
+#include <Vkx/SwapChain.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Camera;
+class ThreadPool;
+
+//! A texture whose mip levels become resident from the smallest upward.
+//!
+//! Only the levels from residentLevel() to the end of the chain are resident. The resident image's level 0 is the full
+//! texture's level residentLevel(), so normalized texture coordinates and samplers are unaffected by streaming.
+//!
+//! The resident image is in the LAYOUT layout, so that its levels can be copied into the next image while it is sampled.
+//!
+//! @note   A StreamedTexture is managed by a MipStreamer and cannot be copied or moved.
+
+class StreamedTexture
+{
+public:
+    //! Returns the tightly-packed texels of a mip level of every layer of the full texture, one layer after another. This is
+    //! called on a worker thread.
+    using Source = std::function<std::vector<uint8_t>(uint32_t level)>;
+
+    //! Layout of the resident image when it is sampled
+    static vk::ImageLayout constexpr LAYOUT = vk::ImageLayout::eGeneral;
+
+    //! Constructor.
+    StreamedTexture(vk::ImageCreateInfo const & info, Source source, uint32_t tailLevels = 1);
+
+    //! Returns the most detailed resident level, or the number of levels if nothing is resident.
+    uint32_t residentLevel() const { return residentLevel_; }
+
+    //! Returns the resident image, or nullptr if nothing is resident.
+    LocalImage const * image() const { return image_.get(); }
+
+    //! Returns the resident image's view, or a null view if nothing is resident.
+    vk::ImageView view() const { return image_ ? image_->view() : vk::ImageView(); }
+
+    //! Returns the creation info of the full texture.
+    vk::ImageCreateInfo const & info() const { return info_; }
+
+    //! Returns the mip level needed to draw an object with this texture at the appropriate level of detail.
+    uint32_t desiredLevel(Camera const &    camera,
+                          glm::vec3 const & position,
+                          float             radius,
+                          float             viewportHeight) const;
+
+private:
+    friend class MipStreamer;
+
+    // Non-copyable
+    StreamedTexture(StreamedTexture const &) = delete;
+    StreamedTexture & operator =(StreamedTexture const &) = delete;
+
+    vk::ImageCreateInfo info_;
+    Source source_;
+    std::unique_ptr<LocalImage> image_;
+    uint32_t tailLevel_;
+    uint32_t residentLevel_;
+    uint32_t requestedLevel_;
+    float priority_ = 0.0f;
+    bool busy_      = false;
+};
+
+//! Streams the mip levels of StreamedTextures according to requests made each frame.
+//!
+//! Changing a texture's resident levels creates a new image containing exactly the requested levels. Levels that are already
+//! resident are copied from the current image on the GPU, and only the others are read from the texture's source on worker
+//! threads. All ready uploads are submitted in a single command buffer per update(). The new image replaces the old one once
+//! its upload fence signals, and the old image is destroyed once every frame in flight has started again (see update()).
+//! Textures that become more detailed are refined one level per step, so that detail arrives progressively. Textures that
+//! become less detailed are reduced immediately, releasing their memory.
+//!
+//! If the upload queue's family differs from the graphics family, the images are created with concurrent sharing between the
+//! two families so that no ownership transfer is necessary.
+//!
+//! @note   A MipStreamer must be used from a single thread. It cannot be copied or moved.
+
+class MipStreamer
+{
+public:
+    //! Constructor.
+    MipStreamer(std::shared_ptr<Device>     device,
+                vk::Queue                   queue,
+                uint32_t                    queueFamily,
+                uint32_t                    graphicsFamily,
+                size_t                      texelBudget,
+                std::shared_ptr<ThreadPool> workers = nullptr,
+                int                         framesInFlight = SwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+
+    //! Destructor.
+    ~MipStreamer();
+
+    //! Adds a texture to be streamed. Its mip tail is loaded by the next update.
+    void add(std::shared_ptr<StreamedTexture> texture);
+
+    //! Stops streaming a texture.
+    void remove(std::shared_ptr<StreamedTexture> const & texture);
+
+    //! Requests that a texture's resident levels start at the given level.
+    void request(StreamedTexture & texture, uint32_t level, float priority);
+
+    //! Starts streaming the highest-priority requests and makes completed uploads available. Call this once per frame.
+    void update(int frame);
+
+    //! Updates the streaming for the swap chain's current frame.
+    void update(SwapChain const & swapChain);
+
+    //! Returns the number of texels in all resident levels of all textures.
+    size_t residentTexels() const;
+
+private:
+    // Non-copyable
+    MipStreamer(MipStreamer const &) = delete;
+    MipStreamer & operator =(MipStreamer const &) = delete;
+
+    struct Upload
+    {
+        std::shared_ptr<StreamedTexture> texture;
+        uint32_t level;
+        std::unique_ptr<LocalImage> image;
+        std::vector<uint8_t> texels;        // May be imported by the staging buffer, so it must outlive it
+        std::unique_ptr<Buffer> staging;    // nullptr if every level is copied from the current image
+        std::vector<vk::BufferImageCopy> regions;
+        std::vector<vk::ImageCopy> copies;  // Levels copied from the current image
+    };
+
+    struct Batch
+    {
+        std::vector<Upload> uploads;
+        vk::UniqueCommandBuffer commands;
+        vk::UniqueFence fence;
+    };
+
+    struct Retired
+    {
+        std::unique_ptr<LocalImage> image;
+        uint32_t frames;    // Bit i is set until frame i has started again
+    };
+
+    void start(std::shared_ptr<StreamedTexture> texture, uint32_t level);
+    Upload load(std::shared_ptr<StreamedTexture> texture, uint32_t level, uint32_t residentLevel);
+
+    std::shared_ptr<Device> device_;
+    vk::Queue queue_;
+    uint32_t families_[2];                  // Upload and graphics families
+    vk::PipelineStageFlags shaderStages_;   // Stages of the upload queue that can sample images
+    size_t texelBudget_;
+    std::shared_ptr<ThreadPool> workers_;
+    int framesInFlight_;
+    vk::UniqueCommandPool commandPool_;
+
+    std::vector<std::shared_ptr<StreamedTexture>> textures_;
+    std::vector<std::future<void>> jobs_;
+    std::mutex loadedMutex_;
+    std::vector<Upload> loaded_;
+    std::deque<Batch> batches_;
+    std::vector<Retired> retired_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_MIPSTREAMER_H)
@@ -0,0 +1,116 @@
+#if !defined(VKX_PIPELINEBUILDER_H)
+#define VKX_PIPELINEBUILDER_H
+
+#pragma once
+
+#include <Vkx/Specialization.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+
+//! Describes the complete state of a graphics pipeline, and creates it.
+//!
+//! The state starts with common defaults (triangle lists, back-face culling, one sample, no depth test, and one color
+//! attachment without blending), and the setters change it. Viewport and scissor are always dynamic. Each shader stage can be
+//! specialized (see Specialization), and the values of its constants are part of the state. Shaders are named by the paths
+//! of their SPIR-V files and loaded through the device's ShaderCache, so two builders describing the same state compare equal
+//! and hash equally, which is what PipelineLibrary uses to share pipelines.
+
+class PipelineBuilder
+{
+public:
+    //! Constructor.
+    PipelineBuilder(vk::PipelineLayout layout, vk::RenderPass renderPass, uint32_t subpass = 0);
+
+    //! Adds a shader stage.
+    PipelineBuilder & shader(vk::ShaderStageFlagBits stage,
+                             std::string const &     path,
+                             std::string const &     entry          = "main",
+                             Specialization const &  specialization = Specialization());
+
+    //! Adds a vertex buffer binding.
+    PipelineBuilder & vertexBinding(uint32_t            binding,
+                                    uint32_t            stride,
+                                    vk::VertexInputRate rate = vk::VertexInputRate::eVertex);
+
+    //! Adds a vertex attribute.
+    PipelineBuilder & vertexAttribute(uint32_t location, uint32_t binding, vk::Format format, uint32_t offset);
+
+    //! Sets the primitive topology.
+    PipelineBuilder & topology(vk::PrimitiveTopology topology, bool primitiveRestart = false);
+
+    //! Sets the rasterization state.
+    PipelineBuilder & rasterization(vk::PolygonMode polygonMode, vk::CullModeFlags cullMode, vk::FrontFace frontFace);
+
+    //! Sets the number of samples per pixel.
+    PipelineBuilder & samples(vk::SampleCountFlagBits samples);
+
+    //! Sets the depth test state.
+    PipelineBuilder & depthTest(bool test, bool write, vk::CompareOp compare = vk::CompareOp::eLess);
+
+    //! Adds the blend state of a color attachment.
+    PipelineBuilder & blend(vk::PipelineColorBlendAttachmentState const & attachment);
+
+    //! Adds a dynamic state.
+    PipelineBuilder & dynamicState(vk::DynamicState state);
+
+    //! Creates the pipeline.
+    vk::UniquePipeline build(Device & device, vk::PipelineCache cache) const;
+
+    //! Returns the paths of the shader stages' SPIR-V files.
+    std::vector<std::string> shaderPaths() const;
+
+    //! Returns a hash of the state.
+    size_t hash() const;
+
+    //! Returns true if the state is the same.
+    bool operator ==(PipelineBuilder const & rhs) const;
+
+    //! Returns true if the state is different.
+    bool operator !=(PipelineBuilder const & rhs) const { return !(*this == rhs); }
+
+    //! Hashes a PipelineBuilder, for use in unordered containers.
+    struct Hash
+    {
+        size_t operator ()(PipelineBuilder const & builder) const { return builder.hash(); }
+    };
+
+private:
+    friend class PipelineManifest;
+
+    struct Stage
+    {
+        vk::ShaderStageFlagBits stage;
+        std::string path;
+        std::string entry;
+        Specialization specialization;
+    };
+
+    vk::PipelineLayout layout_;
+    vk::RenderPass renderPass_;
+    uint32_t subpass_;
+    std::vector<Stage> stages_;
+    std::vector<vk::VertexInputBindingDescription> bindings_;
+    std::vector<vk::VertexInputAttributeDescription> attributes_;
+    vk::PrimitiveTopology topology_  = vk::PrimitiveTopology::eTriangleList;
+    bool primitiveRestart_           = false;
+    vk::PolygonMode polygonMode_     = vk::PolygonMode::eFill;
+    vk::CullModeFlags cullMode_      = vk::CullModeFlagBits::eBack;
+    vk::FrontFace frontFace_         = vk::FrontFace::eCounterClockwise;
+    vk::SampleCountFlagBits samples_ = vk::SampleCountFlagBits::e1;
+    bool depthTest_                  = false;
+    bool depthWrite_                 = false;
+    vk::CompareOp depthCompare_      = vk::CompareOp::eLess;
+    std::vector<vk::PipelineColorBlendAttachmentState> blendAttachments_;   // Empty means one attachment without blending
+    std::vector<vk::DynamicState> dynamicStates_;                           // In addition to viewport and scissor
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_PIPELINEBUILDER_H)
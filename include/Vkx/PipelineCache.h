@@ -0,0 +1,73 @@
+#if !defined(VKX_PIPELINECACHE_H)
+#define VKX_PIPELINECACHE_H
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+//! Manages a vk::PipelineCache that persists between runs.
+//!
+//! Cache data loaded from a file is used only if its header matches the device's vendor, device, and pipeline cache UUID, so
+//! a file written by a different GPU or driver is ignored rather than handed to the driver. Threads that create many pipelines
+//! can use their own caches (see createWorkerCache()) and merge them in when done. The data is saved by writing a temporary file
+//! and renaming it over the old one, so a crash while saving never leaves a truncated cache behind.
+//!
+//! Every Device owns a PipelineCache (see Device::pipelineCache()). If it has loaded a file, it is saved back to that file
+//! when the device is destroyed.
+//!
+//! @note   The cache is thread-safe, but merge() and load() must not run while pipelines are being created with it.
+//! @note   A PipelineCache cannot be copied or moved.
+
+class PipelineCache
+{
+public:
+    //! Constructor.
+    PipelineCache(vk::Device device, vk::PhysicalDeviceProperties const & properties);
+
+    //! Destructor.
+    ~PipelineCache();
+
+    //! Merges the cache data in a file into the cache.
+    bool load(std::string const & path);
+
+    //! Saves the cache data to a file.
+    void save(std::string const & path) const;
+
+    //! Saves the cache data to the file it was loaded from, if any.
+    void save() const;
+
+    //! Returns the cache's data.
+    std::vector<uint8_t> data() const;
+
+    //! Returns true if the data was produced by a device with the given properties.
+    static bool isCompatible(std::vector<uint8_t> const & data, vk::PhysicalDeviceProperties const & properties);
+
+    //! Creates an empty cache for use by one thread.
+    vk::UniquePipelineCache createWorkerCache() const;
+
+    //! Merges a cache into this cache.
+    void merge(vk::PipelineCache const & src);
+
+    //! Implicitly converts into a vk::PipelineCache.
+    operator vk::PipelineCache() const { return *cache_; }
+
+private:
+    // Non-copyable
+    PipelineCache(PipelineCache const &) = delete;
+    PipelineCache & operator =(PipelineCache const &) = delete;
+
+    vk::Device device_;
+    vk::PhysicalDeviceProperties properties_;
+    vk::UniquePipelineCache cache_;
+    std::string path_;              // File the data was loaded from, and is saved to on destruction
+    mutable std::mutex mutex_;      // Guards merging and path_
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_PIPELINECACHE_H)
@@ -0,0 +1,100 @@
+#if !defined(VKX_PIPELINELIBRARY_H)
+#define VKX_PIPELINELIBRARY_H
+
+#pragma once
+
+#include <Vkx/PipelineBuilder.h>
+#include <Vkx/ShaderCache.h>
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+class ThreadPool;
+
+//! Shares graphics pipelines with identical state, and compiles new ones in the background.
+//!
+//! Pipelines are identified by the complete state in a PipelineBuilder, so asking for a pipeline that already exists returns
+//! it rather than creating a duplicate. get() creates a missing pipeline immediately. request() never waits: it starts
+//! compiling a missing pipeline on a worker thread and returns a fallback pipeline until the compilation has finished, so a
+//! new permutation costs a frame or two of approximate rendering rather than a hitch. Pipelines are created with the device's
+//! PipelineCache.
+//!
+//! At startup, prewarm() creates a list of pipelines (typically recorded in a PipelineManifest by a previous run) using all of
+//! the worker threads.
+//!
+//! Shaders are named by path, so when the device's ShaderCache reloads a file whose contents have changed (see
+//! ShaderCache::get()), the pipelines built from the old module are replaced: they are created again the next time they
+//! are asked for. Replaced pipelines are kept until the library is destroyed, since command buffers may refer to them.
+//!
+//! @note   The library is thread-safe.
+//! @note   A PipelineLibrary cannot be copied or moved.
+
+class PipelineLibrary
+{
+public:
+    //! Constructor.
+    PipelineLibrary(std::shared_ptr<Device> device, std::shared_ptr<ThreadPool> workers = nullptr);
+
+    //! Destructor.
+    ~PipelineLibrary();
+
+    //! Returns the pipeline with the given state, creating it if necessary.
+    vk::Pipeline get(PipelineBuilder const & builder);
+
+    //! Returns the pipeline with the given state if it is ready, and the fallback otherwise.
+    vk::Pipeline request(PipelineBuilder const & builder, vk::Pipeline fallback);
+
+    //! Creates the pipelines with the given states in parallel, skipping those that exist or are being compiled.
+    void prewarm(std::vector<PipelineBuilder> const &          builders,
+                 std::function<void(size_t done, size_t total)> progress = nullptr);
+
+    //! Returns the states of all of the pipelines that have been created.
+    std::vector<PipelineBuilder> builders() const;
+
+    //! Returns true if the pipeline with the given state has been created.
+    bool ready(PipelineBuilder const & builder) const;
+
+    //! Returns the number of pipelines, including those being compiled.
+    size_t size() const;
+
+    //! Waits until all background compilations have finished.
+    void waitIdle();
+
+private:
+    // Non-copyable
+    PipelineLibrary(PipelineLibrary const &) = delete;
+    PipelineLibrary & operator =(PipelineLibrary const &) = delete;
+
+    struct Entry
+    {
+        vk::UniquePipeline pipeline;
+        std::shared_future<void> compiling;     // Valid while the pipeline is compiled in the background
+        bool failed = false;
+        std::vector<std::pair<std::string, ShaderCache::Module>> shaders;   // Modules the pipeline was built from
+    };
+
+    void compile(PipelineBuilder const & builder, Entry & entry);
+    void compileIfMissing(PipelineBuilder const & builder);
+    void removeOutdated();
+
+    std::shared_ptr<Device> device_;
+    std::shared_ptr<ThreadPool> workers_;
+    std::unordered_map<PipelineBuilder, std::shared_ptr<Entry>, PipelineBuilder::Hash> pipelines_;
+    std::vector<std::shared_ptr<Entry>> replaced_;  // Built from shaders that have since changed
+    uint64_t shaderGeneration_ = 0;                 // ShaderCache::generation() when the entries were last checked
+    mutable std::mutex mutex_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_PIPELINELIBRARY_H)
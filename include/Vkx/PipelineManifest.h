@@ -0,0 +1,51 @@
+#if !defined(VKX_PIPELINEMANIFEST_H)
+#define VKX_PIPELINEMANIFEST_H
+
+#pragma once
+
+#include <Vkx/PipelineBuilder.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+//! Saves and loads lists of pipeline states, so that the pipelines used in one run can be prewarmed in the next (see
+//! PipelineLibrary::prewarm()).
+//!
+//! Pipeline layouts and render passes are different objects in every run, so they are saved by name. Every layout and render
+//! pass that is saved or loaded must be given a name with addLayout() and addRenderPass().
+//!
+//! The file is text, with one line per part of a pipeline's state.
+
+class PipelineManifest
+{
+public:
+    //! Names a pipeline layout.
+    void addLayout(std::string const & name, vk::PipelineLayout layout);
+
+    //! Names a render pass.
+    void addRenderPass(std::string const & name, vk::RenderPass renderPass);
+
+    //! Saves pipeline states to a file.
+    void save(std::string const & path, std::vector<PipelineBuilder> const & builders) const;
+
+    //! Loads pipeline states from a file.
+    std::vector<PipelineBuilder> load(std::string const & path) const;
+
+private:
+    template <typename T>
+    struct Names
+    {
+        std::unordered_map<std::string, T> byName;
+        std::unordered_map<T, std::string> byHandle;
+    };
+
+    Names<vk::PipelineLayout> layouts_;
+    Names<vk::RenderPass> renderPasses_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_PIPELINEMANIFEST_H)
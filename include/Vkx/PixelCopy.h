@@ -0,0 +1,34 @@
+#if !defined(VKX_PIXELCOPY_H)
+#define VKX_PIXELCOPY_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+//! Copies rows of texels between memory with different row pitches.
+void copyRows(void *       dst,
+              size_t       dstPitch,
+              void const * src,
+              size_t       srcPitch,
+              size_t       rowSize,
+              uint32_t     rows);
+
+//! Returns true if convertRows() can convert texels from one format to another.
+bool canConvertRows(vk::Format srcFormat, vk::Format dstFormat);
+
+//! Copies rows of texels between memory with different row pitches, converting them from one format to another.
+void convertRows(void *       dst,
+                 size_t       dstPitch,
+                 vk::Format   dstFormat,
+                 void const * src,
+                 size_t       srcPitch,
+                 vk::Format   srcFormat,
+                 uint32_t     width,
+                 uint32_t     rows);
+} // namespace Vkx
+
+#endif // !defined(VKX_PIXELCOPY_H)
@@ -0,0 +1,54 @@
+#if !defined(VKX_SAMPLERCACHE_H)
+#define VKX_SAMPLERCACHE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+//! Shares samplers with identical state.
+//!
+//! Samplers are created on first request and are destroyed with the cache. Every Device owns a SamplerCache (see
+//! Device::samplers()), so in most cases there is no need to create one.
+//!
+//! @note   The cache is thread-safe.
+//! @note   A SamplerCache cannot be copied or moved.
+
+class SamplerCache
+{
+public:
+    //! Constructor.
+    SamplerCache(vk::Device device, uint32_t maxSamplers);
+
+    //! Returns a sampler with the given state, creating it if necessary.
+    vk::Sampler get(vk::SamplerCreateInfo const & info);
+
+    //! Returns the number of distinct samplers in the cache.
+    size_t size() const;
+
+    //! Destroys all of the samplers.
+    void clear();
+
+private:
+    // Non-copyable
+    SamplerCache(SamplerCache const &) = delete;
+    SamplerCache & operator =(SamplerCache const &) = delete;
+
+    struct Hash
+    {
+        size_t operator ()(vk::SamplerCreateInfo const & info) const;
+    };
+
+    vk::Device device_;
+    uint32_t maxSamplers_;
+    std::unordered_map<vk::SamplerCreateInfo, vk::UniqueSampler, Hash> samplers_;
+    mutable std::mutex mutex_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_SAMPLERCACHE_H)
@@ -0,0 +1,93 @@
+#if !defined(VKX_SHADERCACHE_H)
+#define VKX_SHADERCACHE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+
+//! Shares shader modules loaded from SPIR-V files.
+//!
+//! Files are memory-mapped rather than read, and a module is created only once for each distinct content: loading the same
+//! file again returns the same module, as does loading a different file with identical contents. A file is reloaded only if
+//! its size or modification time has changed, and even then a new module is created only if its contents have changed.
+//! Contents are matched by hash and then compared byte for byte, so a hash collision cannot return the wrong module.
+//!
+//! Modules are shared. A module is destroyed when neither the cache nor anything that has received it refers to it. Every
+//! Device owns a ShaderCache (see Device::shaders()), so in most cases there is no need to create one.
+//!
+//! A module returned by the cache holds a std::shared_ptr to the Device, so the module cannot outlive the device that created
+//! it. The cache's own references do not, because the Device owns the cache. If the Device is not owned by a std::shared_ptr,
+//! the modules cannot keep it alive, and they must be released before it is destroyed.
+//!
+//! @note   The cache is thread-safe.
+//! @note   A ShaderCache cannot be copied or moved.
+
+class ShaderCache
+{
+public:
+    //! A shared shader module, destroyed when the last reference is released
+    using Module = std::shared_ptr<vk::ShaderModule const>;
+
+    //! Constructor.
+    explicit ShaderCache(Device & device);
+
+    //! Returns the shader module created from the SPIR-V in a file, loading the file if necessary.
+    Module get(std::string const & path);
+
+    //! Returns the shader module last loaded from a file without checking the file, or nullptr if it is not loaded.
+    Module find(std::string const & path) const;
+
+    //! Returns a number that changes whenever a file is reloaded with different contents.
+    uint64_t generation() const { return generation_; }
+
+    //! Returns the number of files in the cache.
+    size_t size() const;
+
+    //! Releases the cache's references to all modules.
+    void clear();
+
+private:
+    friend class Device;
+
+    // Non-copyable
+    ShaderCache(ShaderCache const &) = delete;
+    ShaderCache & operator =(ShaderCache const &) = delete;
+
+    struct File
+    {
+        std::filesystem::file_time_type modified;
+        uintmax_t size;
+        uint64_t hash;
+        Module module;      // Does not hold the Device
+    };
+
+    struct Contents
+    {
+        std::vector<uint8_t> code;  // Compared when the hashes match
+        std::weak_ptr<vk::ShaderModule const> module;
+    };
+
+    Module share(Module const & module) const;
+
+    Device * device_;                                       // Updated by Device when it is moved
+    std::unordered_map<std::string, File> files_;           // Indexed by path
+    std::unordered_multimap<uint64_t, Contents> byHash_;    // Indexed by hash of the contents
+    std::atomic<uint64_t> generation_{ 0 };
+    mutable std::mutex mutex_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_SHADERCACHE_H)
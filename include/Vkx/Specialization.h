@@ -0,0 +1,100 @@
+#if !defined(VKX_SPECIALIZATION_H)
+#define VKX_SPECIALIZATION_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+//! Values of a shader's specialization constants.
+//!
+//! Constants are set by ID with their C++ types, which are checked at compile time: bool (stored as a VkBool32), 32-bit and
+//! 64-bit integers, float, and double. A struct can also provide the values, with each listed member becoming the constant
+//! whose ID is its position in the list:
+//!
+//!     struct MaterialConstants { uint32_t lightCount; bool normalMap; float alphaCutoff; };
+//!     MaterialConstants constants = { 4, true, 0.5f };
+//!     auto specialization = Specialization::fromStruct(constants,
+//!                                                      &MaterialConstants::lightCount,    // constant_id = 0
+//!                                                      &MaterialConstants::normalMap,     // constant_id = 1
+//!                                                      &MaterialConstants::alphaCutoff);  // constant_id = 2
+//!
+//! Specializations compare equal and hash equally if they set the same constants to the same values, so they are part of the
+//! state that PipelineBuilder hashes.
+
+class Specialization
+{
+public:
+    //! Sets the value of a constant.
+    template <typename T>
+    Specialization & set(uint32_t id, T value);
+
+    //! Sets the value of a constant from its bytes.
+    Specialization & set(uint32_t id, void const * value, size_t size);
+
+    //! Returns a specialization with the values of a struct's members, in order, starting with constant ID 0.
+    template <typename S, typename ... M>
+    static Specialization fromStruct(S const & values, M S::* ... members);
+
+    //! Returns the specialization info referring to this object's data.
+    vk::SpecializationInfo info() const;
+
+    //! Returns true if no constants are set.
+    bool empty() const { return entries_.empty(); }
+
+    //! Returns a hash of the constants and their values.
+    size_t hash() const;
+
+    //! Returns true if the same constants are set to the same values.
+    bool operator ==(Specialization const & rhs) const;
+
+    //! Returns true if the constants or their values differ.
+    bool operator !=(Specialization const & rhs) const { return !(*this == rhs); }
+
+private:
+    friend class PipelineManifest;
+
+    std::vector<vk::SpecializationMapEntry> entries_;   // Sorted by ID
+    std::vector<uint8_t> data_;
+};
+
+//! @param  id      ID of the constant
+//! @param  value   Value
+//!
+//! @return this specialization
+template <typename T>
+Specialization & Specialization::set(uint32_t id, T value)
+{
+    static_assert(std::is_arithmetic_v<T> && (std::is_same_v<T, bool> || sizeof(T) == 4 || sizeof(T) == 8),
+                  "specialization constants must be bool, 32-bit or 64-bit integers, float, or double");
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        VkBool32 b = value ? VK_TRUE : VK_FALSE;
+        return set(id, &b, sizeof(b));
+    }
+    else
+    {
+        return set(id, &value, sizeof(value));
+    }
+}
+
+//! @param  values      Struct holding the values
+//! @param  members     Members holding the values of constants 0, 1, 2, ...
+//!
+//! @return specialization
+template <typename S, typename ... M>
+Specialization Specialization::fromStruct(S const & values, M S::* ... members)
+{
+    Specialization specialization;
+    uint32_t id = 0;
+    (specialization.set(id++, values.*members), ...);
+    return specialization;
+}
+} // namespace Vkx
+
+#endif // !defined(VKX_SPECIALIZATION_H)
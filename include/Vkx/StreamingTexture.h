@@ -0,0 +1,92 @@
+#if !defined(VKX_STREAMINGTEXTURE_H)
+#define VKX_STREAMINGTEXTURE_H
+
+#pragma once
+
+#include <Vkx/Buffer.h>
+#include <Vkx/Image.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+
+//! A texture whose contents are replaced continuously, such as a video.
+//!
+//! The texture owns a ring of images and a persistently-mapped staging buffer with a region for each image. A producer
+//! thread writes each new frame directly into a staging region with beginWrite() and endWrite(). The rendering thread calls
+//! acquire() once per frame, which records the upload of the newest frame (if any) into the frame's command buffer and
+//! returns the image to sample. Neither side blocks the other: the producer waits only for the upload that last read the
+//! staging region it is about to overwrite, and if the producer gets ahead of the renderer, frames are dropped. Each
+//! region has its own event, set by the GPU when its upload is complete, so the texture needs none of the renderer's
+//! fences.
+//!
+//! @note   The commands recorded by acquire() must be submitted to the queue that samples the image. Its family must
+//!         support graphics or compute operations, which events require.
+//! @note   A StreamingTexture cannot be copied or moved.
+//! @note   The GPU must be finished with the texture before it is destroyed.
+
+class StreamingTexture
+{
+public:
+    //! Default number of images in the ring
+    static uint32_t constexpr DEFAULT_DEPTH = 3;
+
+    //! Constructor.
+    StreamingTexture(std::shared_ptr<Device> device,
+                     vk::Format              format,
+                     uint32_t                width,
+                     uint32_t                height,
+                     uint32_t                depth = DEFAULT_DEPTH);
+
+    //! Returns the address to write the next frame's texels to. Called by the producer.
+    void * beginWrite();
+
+    //! Publishes the frame written since beginWrite(). Called by the producer.
+    void endWrite();
+
+    //! Records the upload of the newest frame, if any, and returns the image to sample.
+    LocalImage const * acquire(vk::CommandBuffer & commands);
+
+    //! Returns the size of a frame's texels.
+    size_t frameSize() const { return frameSize_; }
+
+private:
+    // Non-copyable
+    StreamingTexture(StreamingTexture const &) = delete;
+    StreamingTexture & operator =(StreamingTexture const &) = delete;
+
+    enum class State
+    {
+        eFree,      // Can be written
+        eWriting,   // Being written by the producer
+        eReady,     // Written, but not uploaded yet
+        eDisplayed  // Uploaded, and returned by acquire()
+    };
+
+    struct Slot
+    {
+        LocalImage image;
+        size_t offset;              // Offset of the slot's region in the staging buffer
+        vk::UniqueEvent uploaded;   // Set when the upload from the slot's region is complete
+        bool uploading;             // True if an upload from the region has been recorded and not waited for
+        State state;
+        bool initialized;           // True once the image has left the eUndefined layout
+    };
+
+    std::shared_ptr<Device> device_;
+    size_t frameSize_;
+    HostBuffer staging_;
+    std::vector<Slot> slots_;
+    uint32_t next_ = 0;             // Where the search for a free slot starts
+    uint32_t writing_;              // Slot being written by the producer
+    std::mutex mutex_;
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_STREAMINGTEXTURE_H)
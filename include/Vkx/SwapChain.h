@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -14,12 +15,28 @@ class Device;
 
 //! An object that encapsulates a vk:SwapchainKHR and the objects controlled by it.
 //!
+//! swap() acquires the next image before waiting for anything, and then waits only for the fence of the frame that last
+//! rendered to that image, and for the fence of the frame being started. Image-available semaphores therefore belong to the
+//! acquired images rather than to the frames, and are recycled once the frame that waited on them has completed. When the
+//! swap chain is recreated, its images' semaphores are retired with it and replaced by new ones, because an image that was
+//! acquired but never rendered leaves its semaphore signaled.
+//! Render-finished semaphores belong to the images too, because a present of one image may still be waiting on its
+//! semaphore while another frame renders to a different image.
+//!
 //! @note   A SwapChain cannot be copied or assigned, but can be moved
 
 class SwapChain
 {
 public:
-    static int constexpr MAX_LATENCY = 3;   //!< The number of frames in the swap chain
+    static int constexpr DEFAULT_FRAMES_IN_FLIGHT = 3;  //!< The default number of frames in flight
+    static int constexpr MAX_FRAMES_IN_FLIGHT     = 4;  //!< The largest number of frames in flight
+
+    //! Time spent in the CPU by swap()
+    struct Timing
+    {
+        std::chrono::nanoseconds fenceWait; //!< Waiting for the frame's in-flight fence
+        std::chrono::nanoseconds acquire;   //!< Acquiring the next image
+    };
 
     //! Constructor
     SwapChain(std::shared_ptr<Device>      device,
@@ -27,7 +44,8 @@ public:
               vk::Extent2D                 extent,
               uint32_t                     graphicsFamily,
               uint32_t                     presentFamily,
-              vk::PresentModeKHR           presentMode);
+              vk::PresentModeKHR           presentMode,
+              int                          framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
 
     //! Move constructor.
     SwapChain(SwapChain && src);
@@ -38,6 +56,15 @@ public:
     //! Advances to the next swap chain image.
     uint32_t swap();
 
+    //! Presents the current image once rendering to it has finished.
+    void present(vk::Queue const & queue);
+
+    //! Returns true if the swap chain no longer matches the surface exactly and should be recreated.
+    bool suboptimal() const { return suboptimal_; }
+
+    //! Replaces the swap chain's images with images of a new extent.
+    void recreate(vk::Extent2D extent);
+
     //! Returns the image format.
     vk::Format format() const { return format_; }
 
@@ -50,11 +77,23 @@ public:
     //! Returns the specified image view.
     vk::ImageView & view(size_t i) { return *views_[i]; }
 
-    //! Returns the image-available semaphore for the current frame.
-    vk::Semaphore & imageAvailable() { return *imageAvailableSemaphores_[currentFrame_]; }
+    //! Returns the index of the current frame, in [0, framesInFlight()).
+    int frame() const { return currentFrame_; }
+
+    //! Returns the number of frames that can be in flight at once.
+    int framesInFlight() const { return (int)inFlightFences_.size(); }
 
-    //! Returns the render-finished semaphore for the current frame.
-    vk::Semaphore & renderFinished() { return *renderFinishedSemaphores_[currentFrame_]; }
+    //! Returns the time spent by the most recent call to swap().
+    Timing const & timing() const { return timing_; }
+
+    //! Returns the semaphore signaled when the current image is available.
+    vk::Semaphore & imageAvailable() { return *imageAvailableSemaphores_[currentSemaphore_]; }
+
+    //! Returns the index of the current image.
+    uint32_t image() const { return currentImage_; }
+
+    //! Returns the render-finished semaphore for the current image.
+    vk::Semaphore & renderFinished() { return *renderFinishedSemaphores_[currentImage_]; }
 
     //! Returns the in-flight fence for the current frame.
     vk::Fence & inFlight() { return *inFlightFences_[currentFrame_]; }
@@ -67,15 +106,40 @@ private:
     SwapChain(SwapChain const &) = delete;
     SwapChain & operator =(SwapChain const &) = delete;
 
+    // A replaced swap chain, kept until the frames that may be using its images have retired
+    struct Retired
+    {
+        vk::UniqueSwapchainKHR swapChain;
+        std::vector<vk::UniqueImageView> views;
+        std::vector<vk::UniqueSemaphore> semaphores;    // Image-available semaphores of the images, which may be signaled
+        std::vector<vk::UniqueSemaphore> renderFinished;
+        int framesLeft;
+    };
+
+    static size_t constexpr NO_SEMAPHORE = ~size_t(0);
+
+    void create(vk::Extent2D extent, vk::SwapchainKHR oldSwapChain);
+
     std::shared_ptr<Device> device_;
     vk::UniqueSwapchainKHR swapChain_;
     vk::Format format_;
+    vk::ColorSpaceKHR colorSpace_;
     std::vector<vk::UniqueImageView> views_;
     vk::Extent2D extent_;
-    std::vector<vk::UniqueSemaphore> imageAvailableSemaphores_;
-    std::vector<vk::UniqueSemaphore> renderFinishedSemaphores_;
+    uint32_t families_[2];          // Graphics and present families
+    vk::PresentModeKHR presentMode_;
+    std::vector<Retired> retired_;
+    std::vector<vk::UniqueSemaphore> imageAvailableSemaphores_;    // Grows as needed
+    std::vector<size_t> freeSemaphores_;                            // Image-available semaphores that can be acquired with
+    std::vector<size_t> imageSemaphores_;                           // Image-available semaphore last used by each image
+    std::vector<vk::Fence> imageFences_;                            // In-flight fence of the last frame to use each image
+    std::vector<vk::UniqueSemaphore> renderFinishedSemaphores_;    // One for each image
     std::vector<vk::UniqueFence> inFlightFences_;
     int currentFrame_ = 0;
+    uint32_t currentImage_ = 0;
+    size_t currentSemaphore_ = 0;
+    bool suboptimal_ = false;
+    Timing timing_ = {};
 };
 } // namespace Vkx
 
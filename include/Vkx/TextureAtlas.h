@@ -0,0 +1,108 @@
+#if !defined(VKX_TEXTUREATLAS_H)
+#define VKX_TEXTUREATLAS_H
+
+#pragma once
+
+#include <Vkx/Image.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Vkx
+{
+class Device;
+
+//! Packs many small textures into a single LocalImage.
+//!
+//! Space is allocated with the MaxRects algorithm (best short side fit), and textures can be inserted and removed at any
+//! time. Each texture is surrounded by a gutter of replicated edge texels so that filtering and lower mip levels do not bleed
+//! in texels of neighboring textures. Inserted textures are staged in CPU memory and uploaded by flush(), which copies only
+//! the inserted regions.
+//!
+//! @note   flush() must be called at least once before the atlas's image is used.
+//! @note   A TextureAtlas cannot be copied or moved.
+
+class TextureAtlas
+{
+public:
+    //! Identifies a texture in the atlas. A handle remains valid until the texture is removed.
+    using Handle = uint32_t;
+
+    static Handle constexpr INVALID_HANDLE = ~0u;   //!< A handle that never refers to a texture
+
+    //! Constructor.
+    TextureAtlas(std::shared_ptr<Device> device,
+                 vk::Format              format,
+                 uint32_t                width,
+                 uint32_t                height,
+                 uint32_t                gutter = 1,
+                 uint32_t                mipLevels = 1);
+
+    //! Adds a texture to the atlas and returns its handle, or INVALID_HANDLE if there is no room.
+    Handle insert(uint32_t width, uint32_t height, void const * texels);
+
+    //! Removes a texture from the atlas.
+    void remove(Handle handle);
+
+    //! Uploads the textures inserted since the previous call.
+    void flush(vk::CommandPool const & commandPool, vk::Queue const & queue);
+
+    //! Returns the texels of a texture in the atlas (not including its gutter).
+    vk::Rect2D rect(Handle handle) const { return entries_[handle].rect; }
+
+    //! Returns the normalized texture coordinates of a texture in the atlas as (left, top, right, bottom).
+    glm::vec4 uvRect(Handle handle) const;
+
+    //! Returns the atlas's image.
+    LocalImage const & image() const { return image_; }
+
+    //! Returns the number of textures in the atlas.
+    size_t size() const { return entries_.size() - freeHandles_.size(); }
+
+    //! Returns the fraction of the atlas that is allocated to textures, including their gutters.
+    float occupancy() const;
+
+private:
+    // Non-copyable
+    TextureAtlas(TextureAtlas const &) = delete;
+    TextureAtlas & operator =(TextureAtlas const &) = delete;
+
+    struct Entry
+    {
+        vk::Rect2D allocated;   // Space allocated to the texture, including the gutter and alignment
+        vk::Rect2D rect;        // The texture's texels
+        bool used;
+    };
+
+    struct Upload
+    {
+        Handle handle;
+        vk::BufferImageCopy region;
+    };
+
+    bool allocate(uint32_t width, uint32_t height, vk::Rect2D & allocated);
+    void rebuildFreeRects();
+    void splitFreeRects(vk::Rect2D const & used);
+
+    std::shared_ptr<Device> device_;
+    LocalImage image_;
+    size_t texelSize_;
+    uint32_t gutter_;
+    uint32_t alignment_;                // Allocations are aligned so that the gutters survive down to the last level
+    bool initialized_ = false;          // True once the image has left the eUndefined layout
+    uint64_t allocatedArea_ = 0;
+
+    std::vector<vk::Rect2D> freeRects_; // Maximal free rectangles. They may overlap each other.
+    std::vector<Entry> entries_;
+    std::vector<Handle> freeHandles_;
+
+    std::vector<uint8_t> staged_;       // Texels (with gutters) of the textures inserted since the last flush
+    std::vector<Upload> uploads_;       // Where each staged texture goes
+};
+} // namespace Vkx
+
+#endif // !defined(VKX_TEXTUREATLAS_H)
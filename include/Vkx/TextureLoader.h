@@ -0,0 +1,30 @@
+#if !defined(VKX_TEXTURELOADER_H)
+#define VKX_TEXTURELOADER_H
+
+#pragma once
+
+#include <Vkx/Image.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//! @defgroup TextureLoaders Texture Loaders
+//! Functions that load images from texture container files.
+
+namespace Vkx
+{
+//! Loads an image from the contents of a DDS file.
+//! @ingroup TextureLoaders
+ImageData loadDds(void const * contents, size_t size);
+
+//! Loads an image from the contents of a KTX2 file.
+//! @ingroup TextureLoaders
+ImageData loadKtx2(void const * contents, size_t size);
+
+//! Loads an image from the contents of a DDS or KTX2 file.
+//! @ingroup TextureLoaders
+ImageData loadTexture(std::string const & path, std::vector<char> const & contents);
+} // namespace Vkx
+
+#endif // !defined(VKX_TEXTURELOADER_H)
@@ -3,17 +3,171 @@
 
 #pragma once
 
+#include <Vkx/BindlessTextureTable.h>
+#include <Vkx/BlockCompressor.h>
+#include <Vkx/Buffer.h>
 #include <Vkx/Image.h>
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
 namespace Vkx
 {
-//! An abstract class that loads and manages textures.
-    class TextureManager
-    {
+class ThreadPool;
+
+//! Loads and manages textures asynchronously.
+//!
+//! Reading and decoding a texture file, and filling its staging buffer, are done on worker threads. The uploads are batched
+//! into a single command buffer per call to update() and submitted to the manager's queue with a fence. A texture's handle is
+//! valid immediately, but view() returns the placeholder view until the fence for its upload has signaled.
+//!
+//! @note   Except for the decoder, which is called on worker threads, the manager must be used from a single thread.
+//! @note   A TextureManager cannot be copied or moved.
+
+class TextureManager
+{
 public:
-        TextureManager()          = default;
-        virtual ~TextureManager() = default;
+    //! Identifies a texture. A handle remains valid until it is released.
+    using Handle = uint32_t;
+
+    //! Converts the contents of a file into an image. This is called on a worker thread.
+    using Decoder = std::function<ImageData(std::string const & path, std::vector<char> const & contents)>;
+
+    //! Status of a texture
+    enum class Status
+    {
+        ePending,   //!< The texture is being loaded or uploaded
+        eReady,     //!< The texture is resident and can be used
+        eFailed     //!< The texture could not be loaded
     };
+
+    static Handle constexpr INVALID_HANDLE = ~0u;   //!< A handle that never refers to a texture
+
+    //! Constructor.
+    TextureManager(std::shared_ptr<Device>     device,
+                   vk::Queue                   queue,
+                   uint32_t                    queueFamily,
+                   uint32_t                    graphicsFamily,
+                   Decoder                     decoder,
+                   std::shared_ptr<ThreadPool> workers = nullptr);
+
+    //! Destructor.
+    virtual ~TextureManager();
+
+    //! Starts loading a texture and returns its handle.
+    Handle load(std::string const & path);
+
+    //! Releases a reference to a texture.
+    void release(Handle handle);
+
+    //! Submits finished loads for upload and makes completed uploads available.
+    void update();
+
+    //! Waits until all pending loads and uploads are complete.
+    void waitIdle();
+
+    //! Returns the status of a texture.
+    Status status(Handle handle) const { return slots_[handle].status; }
+
+    //! Returns the reason the texture could not be loaded, or an empty string if it has not failed.
+    std::string const & error(Handle handle) const { return slots_[handle].error; }
+
+    //! Returns the texture's image, or nullptr if it is not ready.
+    LocalImage const * image(Handle handle) const { return slots_[handle].image.get(); }
+
+    //! Returns the texture's view, or the placeholder view if it is not ready.
+    vk::ImageView view(Handle handle) const;
+
+    //! Sets the view returned for textures that are not ready.
+    void setPlaceholder(vk::ImageView placeholder);
+
+    //! Adds the textures to a bindless texture table, or stops adding them if the table is nullptr.
+    void setBindlessTable(std::shared_ptr<BindlessTextureTable> table);
+
+    //! Returns the texture's index in the bindless texture table, or the placeholder's index if it is not ready.
+    BindlessTextureTable::Index index(Handle handle) const;
+
+    //! Compresses textures into the block format before they are uploaded.
+    void setCompression(BlockFormat block, CompressionQuality quality = CompressionQuality::eNormal);
+
+    //! Uploads textures uncompressed (the default).
+    void clearCompression() { compression_.enabled = false; }
+
+private:
+    // Non-copyable
+    TextureManager(TextureManager const &) = delete;
+    TextureManager & operator =(TextureManager const &) = delete;
+
+    struct Slot
+    {
+        std::string path;
+        uint32_t generation = 0;
+        int references      = 0;
+        Status status       = Status::eFailed;
+        std::string error;                  // Set if the load failed
+        std::unique_ptr<LocalImage> image;
+        BindlessTextureTable::Index index = BindlessTextureTable::INVALID_INDEX;  // Written once the texture is ready
+    };
+
+    struct Upload
+    {
+        Handle handle;
+        uint32_t generation;
+        std::unique_ptr<LocalImage> image;
+        std::vector<uint8_t> pixels;        // May be imported by the staging buffer, so it must outlive it
+        std::unique_ptr<Buffer> staging;
+        std::vector<vk::BufferImageCopy> regions;
+        bool generateMipmaps;
+        std::string error;                  // Set if the load failed, in which case image is null
+    };
+
+    struct Compression
+    {
+        bool enabled = false;
+        BlockFormat format = BlockFormat::eBC7;
+        CompressionQuality quality = CompressionQuality::eNormal;
+    };
+
+    struct Batch
+    {
+        std::vector<Upload> uploads;
+        vk::UniqueCommandBuffer commands;
+        vk::UniqueFence fence;
+    };
+
+    void decode(Handle handle, uint32_t generation, std::string const & path, Compression const & compression);
+    void retireCompletedBatches();
+    void setPlaceholderIndex();
+
+    std::shared_ptr<Device> device_;
+    vk::Queue queue_;
+    uint32_t families_[2];
+    vk::QueueFlags queueFlags_;     // Capabilities of the upload queue's family
+    Decoder decoder_;
+    std::shared_ptr<ThreadPool> workers_;
+    vk::UniqueCommandPool commandPool_;
+    vk::ImageView placeholder_;
+    std::shared_ptr<BindlessTextureTable> table_;
+    BindlessTextureTable::Index placeholderIndex_ = BindlessTextureTable::INVALID_INDEX;
+    Compression compression_;       // Applied to textures loaded from now on
+
+    std::vector<Slot> slots_;
+    std::vector<Handle> freeSlots_;
+    std::unordered_map<std::string, Handle> byPath_;
+
+    std::vector<std::future<void>> jobs_;
+    std::mutex decodedMutex_;
+    std::vector<Upload> decoded_;   // Uploads ready to be submitted (or with a null image if the load failed)
+    std::deque<Batch> batches_;     // Submitted uploads, oldest first
+};
 } // namespace Vkx
 
 #endif // !defined(VKX_TEXTUREMANAGER_H)
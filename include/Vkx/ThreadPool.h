@@ -0,0 +1,73 @@
+#if !defined(VKX_THREADPOOL_H)
+#define VKX_THREADPOOL_H
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Vkx
+{
+//! A fixed-size pool of worker threads that execute submitted jobs in FIFO order.
+//!
+//! @note   A ThreadPool cannot be copied or moved.
+
+class ThreadPool
+{
+public:
+    //! Constructor.
+    explicit ThreadPool(size_t nThreads = 0);
+
+    //! Destructor.
+    ~ThreadPool();
+
+    //! Queues a job and returns a future for its result.
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F && job);
+
+    //! Calls a function for every range of indexes in [0, count), in parallel, and returns when all calls are done.
+    void parallelFor(size_t count, std::function<void(size_t begin, size_t end)> body);
+
+    //! Returns the number of worker threads.
+    size_t size() const { return workers_.size(); }
+
+private:
+    // Non-copyable
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator =(ThreadPool const &) = delete;
+
+    void enqueue(std::function<void()> job);
+    void run();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    bool stopping_ = false;
+};
+
+//! @param  job     Function to execute on a worker thread. It is called with no parameters.
+//!
+//! @return future for the value returned by the job (or the exception it throws)
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F && job)
+{
+    using Result = std::invoke_result_t<F>;
+
+    // std::function requires a copyable target, so the task is shared
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+    std::future<Result> result = task->get_future();
+    enqueue([task] () { (*task)(); });
+    return result;
+}
+} // namespace Vkx
+
+#endif // !defined(VKX_THREADPOOL_H)
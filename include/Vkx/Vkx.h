@@ -58,6 +58,22 @@ void executeOnceSynched(std::shared_ptr<Device>                  device,
                         vk::Queue const &                        queue,
                         std::function<void(vk::CommandBuffer &)> commands);
 
+//! Returns the size of a texel of an uncompressed color format.
+//! @ingroup Utilities
+size_t texelSize(vk::Format format);
+
+//! Returns the alignment of a buffer offset in a copy to or from an image of an uncompressed color format.
+//! @ingroup Utilities
+size_t copyAlignment(vk::Format format);
+
+//! Returns the shader stages that can sample images in commands submitted to a queue family.
+//! @ingroup Utilities
+vk::PipelineStageFlags samplingStages(vk::QueueFlags queueFlags);
+
+//! Merges rectangles into fewer rectangles that cover the same area without overlapping.
+//! @ingroup Utilities
+std::vector<vk::Rect2D> coalesceRects(std::vector<vk::Rect2D> const & rects);
+
 //! Strips a grid generating 16-bit indexes.
 //! @ingroup Utilities
 int stripGrid(int w, int h, uint16_t * pData);